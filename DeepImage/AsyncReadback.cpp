@@ -0,0 +1,161 @@
+#include "AsyncReadback.h"
+
+#include <QOpenGLFunctions_4_5_Core>
+
+#include "ResourceTracker.h"
+
+static const GLuint64 WAIT_TIMEOUT_NS = 1000000000;
+
+static size_t BytesPerPixel(unsigned int format_, unsigned int type_)
+{
+	size_t channels = 4;
+	switch (format_) {
+	case GL_RED:
+	case GL_RED_INTEGER:
+	case GL_DEPTH_COMPONENT:
+	case GL_DEPTH_STENCIL:
+		channels = 1;
+		break;
+	case GL_RG:
+	case GL_RG_INTEGER:
+		channels = 2;
+		break;
+	case GL_RGB:
+	case GL_RGB_INTEGER:
+	case GL_BGR:
+		channels = 3;
+		break;
+	}
+
+	size_t size = 4;
+	switch (type_) {
+	case GL_UNSIGNED_BYTE:
+	case GL_BYTE:
+		size = 1;
+		break;
+	case GL_UNSIGNED_SHORT:
+	case GL_SHORT:
+	case GL_HALF_FLOAT:
+		size = 2;
+		break;
+	}
+
+	return channels * size;
+}
+
+AsyncReadback::AsyncReadback(int slotCount_)
+	: oldest(0),
+	pendingCount(0)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	slots.resize(slotCount_);
+	for (int i = 0; i < slots.size(); i++) {
+		f->glGenBuffers(1, &slots[i].pbo);
+		slots[i].fence = 0;
+		slots[i].capacity = 0;
+		slots[i].size = 0;
+		slots[i].width = slots[i].height = 0;
+		slots[i].owner = ResourceTracker::Instance().Allocate(
+			ResourceTracker::PIXEL_BUFFER, 0);
+	}
+}
+
+AsyncReadback::~AsyncReadback()
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	//reads still in flight are dropped without calling back
+	for (int i = 0; i < slots.size(); i++) {
+		if (slots[i].fence)
+			f->glDeleteSync((GLsync)slots[i].fence);
+		f->glDeleteBuffers(1, &slots[i].pbo);
+		ResourceTracker::Instance().Free(ResourceTracker::PIXEL_BUFFER,
+			slots[i].owner, slots[i].capacity);
+	}
+}
+
+void AsyncReadback::Read(unsigned int framebuffer_, unsigned int attachment_,
+	int x_, int y_, int width_, int height_,
+	unsigned int format_, unsigned int type_, Callback callback_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	//the ring is full when the slot after the newest is still in flight,
+	//which is exactly the oldest one
+	int idx = (oldest + pendingCount) % slots.size();
+	if (pendingCount == slots.size()) {
+		Deliver(slots[oldest], true);
+		idx = (oldest + pendingCount) % slots.size();
+	}
+	Slot& slot = slots[idx];
+
+	slot.width = width_;
+	slot.height = height_;
+	slot.size = (size_t)width_ * height_ * BytesPerPixel(format_, type_);
+	slot.callback = callback_;
+
+	f->glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+	if (slot.size > slot.capacity) {
+		f->glBufferData(GL_PIXEL_PACK_BUFFER, slot.size, 0, GL_STREAM_READ);
+		ResourceTracker& tracker = ResourceTracker::Instance();
+		tracker.Free(ResourceTracker::PIXEL_BUFFER, slot.owner, slot.capacity);
+		slot.capacity = slot.size;
+		slot.owner = tracker.Allocate(ResourceTracker::PIXEL_BUFFER, slot.capacity);
+	}
+
+	int previous;
+	f->glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+	f->glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer_);
+	//the read buffer only selects among color attachments
+	if (format_ != GL_DEPTH_COMPONENT && format_ != GL_DEPTH_STENCIL)
+		f->glReadBuffer(attachment_);
+	f->glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	f->glReadPixels(x_, y_, width_, height_, format_, type_, 0);
+	f->glBindFramebuffer(GL_READ_FRAMEBUFFER, previous);
+	f->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = f->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	pendingCount++;
+}
+
+void AsyncReadback::Poll(bool wait_)
+{
+	//stop at the first unfinished read to keep the callbacks in order
+	while (pendingCount > 0 && Deliver(slots[oldest], wait_));
+}
+
+bool AsyncReadback::Deliver(Slot & slot_, bool wait_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	//the flush bit makes sure the fence gets submitted at all
+	GLsync fence = (GLsync)slot_.fence;
+	GLenum result = f->glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+		wait_ ? WAIT_TIMEOUT_NS : 0);
+	while (wait_ && result == GL_TIMEOUT_EXPIRED)
+		result = f->glClientWaitSync(fence, 0, WAIT_TIMEOUT_NS);
+	if (result == GL_TIMEOUT_EXPIRED)
+		return false;
+
+	f->glDeleteSync(fence);
+	slot_.fence = 0;
+
+	f->glBindBuffer(GL_PIXEL_PACK_BUFFER, slot_.pbo);
+	const void* data = f->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot_.size, GL_MAP_READ_BIT);
+	if (data) {
+		slot_.callback(data, slot_.width, slot_.height);
+		f->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	f->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	slot_.callback = Callback();
+
+	oldest = (oldest + 1) % slots.size();
+	pendingCount--;
+
+	return true;
+}
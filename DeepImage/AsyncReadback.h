@@ -0,0 +1,51 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+//reads framebuffer regions into a ring of pixel pack buffers and hands
+//the pixels over once the GPU signalled the fence, usually a frame
+//later. glReadPixels into a buffer object returns immediately, so
+//neither picking nor bulk exports stall the pipeline.
+class AsyncReadback
+{
+public:
+	//data_ points into the mapped buffer and is only valid during the call.
+	//callbacks run on the GL thread, in the order the reads were issued,
+	//and must not queue new reads themselves.
+	typedef std::function<void(const void* data_, int width_, int height_)> Callback;
+
+private:
+	struct Slot {
+		unsigned int pbo;
+		void* fence;
+		size_t capacity;
+		size_t size;
+		int owner;
+		int width, height;
+		Callback callback;
+	};
+
+	std::vector<Slot> slots;
+	int oldest;
+	int pendingCount;
+
+public:
+	AsyncReadback(int slotCount_ = 3);
+	~AsyncReadback();
+
+	//queues a read of attachment_ of framebuffer_ in its native format_/type_,
+	//depth formats read the depth attachment whatever attachment_ says.
+	//with every slot in flight it first waits for the oldest one.
+	void Read(unsigned int framebuffer_, unsigned int attachment_,
+		int x_, int y_, int width_, int height_,
+		unsigned int format_, unsigned int type_, Callback callback_);
+
+	//delivers every finished read, wait_ blocks until all are delivered
+	void Poll(bool wait_ = false);
+
+	inline bool HasPending() const { return pendingCount > 0; }
+
+private:
+	bool Deliver(Slot& slot_, bool wait_);
+};
@@ -0,0 +1,206 @@
+#include "BVH.h"
+
+#include <algorithm>
+#include <cfloat>
+
+static const int BIN_COUNT = 16;
+//deeper than this only median splits are made, which keeps the
+//traversal stack in Traverse() from overflowing
+static const int MAX_SAH_DEPTH = 40;
+static const float TRAVERSAL_COST = 1.0f;
+
+static float HalfArea(const float bmin_[3], const float bmax_[3])
+{
+	float dx = bmax_[0] - bmin_[0];
+	float dy = bmax_[1] - bmin_[1];
+	float dz = bmax_[2] - bmin_[2];
+	return dx * dy + dy * dz + dz * dx;
+}
+
+static void Grow(float bmin_[3], float bmax_[3], const float* box_)
+{
+	for (int k = 0; k < 3; k++) {
+		bmin_[k] = std::min(bmin_[k], box_[k]);
+		bmax_[k] = std::max(bmax_[k], box_[k + 3]);
+	}
+}
+
+BVH::BVH()
+	: maxLeafSize(4)
+{
+}
+
+void BVH::Build(const std::vector<float>& boxes_, int maxLeafSize_)
+{
+	Clear();
+
+	int count = (int)(boxes_.size() / 6);
+	if (count == 0)
+		return;
+
+	maxLeafSize = std::max(1, maxLeafSize_);
+	boxes = boxes_;
+	centroids.resize(count * 3);
+	indices.resize(count);
+	for (int i = 0; i < count; i++) {
+		indices[i] = i;
+		for (int k = 0; k < 3; k++)
+			centroids[i * 3 + k] = (boxes[i * 6 + k] + boxes[i * 6 + k + 3]) * 0.5f;
+	}
+
+	//a binary tree over count leaves never needs more nodes, so the
+	//vector does not move while Subdivide holds indices into it
+	nodes.reserve(2 * count);
+	nodes.push_back(Node());
+	Subdivide(0, 0, count, 0);
+
+	std::vector<float>().swap(boxes);
+	std::vector<float>().swap(centroids);
+}
+
+void BVH::Clear()
+{
+	nodes.clear();
+	indices.clear();
+}
+
+void BVH::Subdivide(int nodeIdx_, int first_, int count_, int depth_)
+{
+	float bmin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float bmax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	float cmin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float cmax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (int i = first_; i < first_ + count_; i++) {
+		int p = indices[i];
+		Grow(bmin, bmax, &boxes[p * 6]);
+		for (int k = 0; k < 3; k++) {
+			cmin[k] = std::min(cmin[k], centroids[p * 3 + k]);
+			cmax[k] = std::max(cmax[k], centroids[p * 3 + k]);
+		}
+	}
+
+	Node& node = nodes[nodeIdx_];
+	for (int k = 0; k < 3; k++) {
+		node.bmin[k] = bmin[k];
+		node.bmax[k] = bmax[k];
+	}
+
+	if (count_ <= 1) {
+		MakeLeaf(nodeIdx_, first_, count_);
+		return;
+	}
+
+	//binned SAH on every axis
+	int bestAxis = -1, bestBin = 0;
+	float bestCost = FLT_MAX;
+	if (depth_ < MAX_SAH_DEPTH) {
+		for (int axis = 0; axis < 3; axis++) {
+			float extent = cmax[axis] - cmin[axis];
+			if (extent <= 0.0f)
+				continue;
+
+			int binCounts[BIN_COUNT] = { 0 };
+			float binMin[BIN_COUNT][3], binMax[BIN_COUNT][3];
+			for (int b = 0; b < BIN_COUNT; b++)
+				for (int k = 0; k < 3; k++) {
+					binMin[b][k] = FLT_MAX;
+					binMax[b][k] = -FLT_MAX;
+				}
+
+			float scale = BIN_COUNT / extent;
+			for (int i = first_; i < first_ + count_; i++) {
+				int p = indices[i];
+				int b = std::min(BIN_COUNT - 1,
+					(int)((centroids[p * 3 + axis] - cmin[axis]) * scale));
+				binCounts[b]++;
+				Grow(binMin[b], binMax[b], &boxes[p * 6]);
+			}
+
+			//sweep from the right to get the area of every right side
+			float rightArea[BIN_COUNT];
+			int rightCount[BIN_COUNT];
+			float rmin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+			float rmax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			int rcount = 0;
+			for (int b = BIN_COUNT - 1; b > 0; b--) {
+				if (binCounts[b] > 0) {
+					float box[6] = { binMin[b][0], binMin[b][1], binMin[b][2],
+						binMax[b][0], binMax[b][1], binMax[b][2] };
+					Grow(rmin, rmax, box);
+				}
+				rcount += binCounts[b];
+				rightCount[b] = rcount;
+				rightArea[b] = rcount > 0 ? HalfArea(rmin, rmax) : 0.0f;
+			}
+
+			float lmin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+			float lmax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			int lcount = 0;
+			for (int b = 0; b < BIN_COUNT - 1; b++) {
+				if (binCounts[b] > 0) {
+					float box[6] = { binMin[b][0], binMin[b][1], binMin[b][2],
+						binMax[b][0], binMax[b][1], binMax[b][2] };
+					Grow(lmin, lmax, box);
+				}
+				lcount += binCounts[b];
+				if (lcount == 0 || rightCount[b + 1] == 0)
+					continue;
+
+				float cost = HalfArea(lmin, lmax) * lcount +
+					rightArea[b + 1] * rightCount[b + 1];
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestBin = b;
+				}
+			}
+		}
+	}
+
+	float parentArea = HalfArea(bmin, bmax);
+	if (bestAxis >= 0 && parentArea > 0.0f)
+		bestCost = TRAVERSAL_COST + bestCost / parentArea;
+	if (count_ <= maxLeafSize && (bestAxis < 0 || bestCost >= count_)) {
+		MakeLeaf(nodeIdx_, first_, count_);
+		return;
+	}
+
+	int mid = first_ + count_ / 2;
+	if (bestAxis >= 0) {
+		float scale = BIN_COUNT / (cmax[bestAxis] - cmin[bestAxis]);
+		float axisMin = cmin[bestAxis];
+		const std::vector<float>& c = centroids;
+		int* split = std::partition(&indices[first_], &indices[first_] + count_,
+			[&](int p_) {
+			int b = std::min(BIN_COUNT - 1, (int)((c[p_ * 3 + bestAxis] - axisMin) * scale));
+			return b <= bestBin;
+		});
+		mid = (int)(split - &indices[0]);
+	}
+	if (bestAxis < 0 || mid == first_ || mid == first_ + count_) {
+		//no usable SAH split, halve along the widest centroid extent
+		int axis = 0;
+		for (int k = 1; k < 3; k++)
+			if (cmax[k] - cmin[k] > cmax[axis] - cmin[axis])
+				axis = k;
+		mid = first_ + count_ / 2;
+		const std::vector<float>& c = centroids;
+		std::nth_element(&indices[first_], &indices[mid], &indices[first_] + count_,
+			[&](int a_, int b_) { return c[a_ * 3 + axis] < c[b_ * 3 + axis]; });
+	}
+
+	int left = (int)nodes.size();
+	nodes.push_back(Node());
+	nodes.push_back(Node());
+	nodes[nodeIdx_].offset = left;
+	nodes[nodeIdx_].count = 0;
+
+	Subdivide(left, first_, mid - first_, depth_ + 1);
+	Subdivide(left + 1, mid, first_ + count_ - mid, depth_ + 1);
+}
+
+void BVH::MakeLeaf(int nodeIdx_, int first_, int count_)
+{
+	nodes[nodeIdx_].offset = first_;
+	nodes[nodeIdx_].count = count_;
+}
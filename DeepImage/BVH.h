@@ -0,0 +1,210 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <xmmintrin.h>
+
+//binned SAH bounding volume hierarchy over axis aligned boxes. it only
+//knows about boxes, MeshBVH stores triangles in the leaves and Picker
+//uses it as the top level over the models.
+class BVH
+{
+public:
+	//inner nodes have count == 0 and their children at offset and
+	//offset + 1, leaves cover count primitives starting at offset
+	struct Node {
+		float bmin[3];
+		int offset;
+		float bmax[3];
+		int count;
+	};
+
+private:
+	std::vector<Node> nodes;
+	std::vector<int> indices;
+
+	std::vector<float> boxes;
+	std::vector<float> centroids;
+	int maxLeafSize;
+
+public:
+	BVH();
+
+	//boxes_ holds min xyz, max xyz per primitive
+	void Build(const std::vector<float>& boxes_, int maxLeafSize_);
+	void Clear();
+
+	//visits the leaves the ray may hit, nearest child first. leaf_ is
+	//called as leaf_(const Node&, float& tMax) and shrinks tMax on a hit.
+	template <typename LeafFunc>
+	void Traverse(const float origin_[3], const float direction_[3],
+		float& tMax_, LeafFunc leaf_) const;
+
+	//visits the leaves whose box is not outside any of the planes, a
+	//point p is inside when dot(plane.xyz, p) + plane.w >= 0. leaf_ is
+	//called as leaf_(const Node&, bool inside) where inside tells the
+	//whole box passed every plane.
+	template <typename LeafFunc>
+	void Cull(const float (*planes_)[4], int planeCount_, LeafFunc leaf_) const;
+
+	//-1 outside, 0 crossing, 1 inside
+	static int ClassifyBox(const Node& node_, const float (*planes_)[4], int planeCount_);
+
+	inline std::vector<Node>& GetNodes() { return nodes; }
+	inline const std::vector<int>& GetIndices() const { return indices; }
+	inline bool IsEmpty() const { return nodes.empty(); }
+	inline size_t GetMemoryBytes() const {
+		return nodes.capacity() * sizeof(Node) + indices.capacity() * sizeof(int);
+	}
+
+private:
+	void Subdivide(int nodeIdx_, int first_, int count_, int depth_);
+	void MakeLeaf(int nodeIdx_, int first_, int count_);
+
+	static bool IntersectBox(const Node& node_, __m128 origin_, __m128 invDir_,
+		float tMax_, float& tNear_);
+};
+
+inline int BVH::ClassifyBox(const Node & node_, const float(*planes_)[4], int planeCount_)
+{
+	int result = 1;
+	for (int i = 0; i < planeCount_; i++) {
+		const float* plane = planes_[i];
+		//corners furthest along and against the plane normal
+		float maxDistance = plane[3], minDistance = plane[3];
+		for (int k = 0; k < 3; k++) {
+			float a = plane[k] * node_.bmin[k];
+			float b = plane[k] * node_.bmax[k];
+			maxDistance += a > b ? a : b;
+			minDistance += a > b ? b : a;
+		}
+		if (maxDistance < 0.0f)
+			return -1;
+		if (minDistance < 0.0f)
+			result = 0;
+	}
+	return result;
+}
+
+inline bool BVH::IntersectBox(const Node & node_, __m128 origin_, __m128 invDir_,
+	float tMax_, float & tNear_)
+{
+	//the 4th lane carries offset/count bits and is ignored by the shuffles
+	__m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node_.bmin), origin_), invDir_);
+	__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node_.bmax), origin_), invDir_);
+	__m128 tn = _mm_min_ps(t0, t1);
+	__m128 tf = _mm_max_ps(t0, t1);
+	tn = _mm_max_ps(_mm_max_ps(tn, _mm_shuffle_ps(tn, tn, _MM_SHUFFLE(3, 0, 2, 1))),
+		_mm_shuffle_ps(tn, tn, _MM_SHUFFLE(3, 1, 0, 2)));
+	tf = _mm_min_ps(_mm_min_ps(tf, _mm_shuffle_ps(tf, tf, _MM_SHUFFLE(3, 0, 2, 1))),
+		_mm_shuffle_ps(tf, tf, _MM_SHUFFLE(3, 1, 0, 2)));
+
+	float tNear = _mm_cvtss_f32(tn);
+	float tFar = _mm_cvtss_f32(tf);
+	tNear_ = tNear > 0.0f ? tNear : 0.0f;
+	return tNear <= tFar && tFar >= 0.0f && tNear < tMax_;
+}
+
+template <typename LeafFunc>
+void BVH::Cull(const float(*planes_)[4], int planeCount_, LeafFunc leaf_) const
+{
+	if (nodes.empty())
+		return;
+
+	//once a node is inside every plane, so is everything below it
+	int stack[128];
+	bool stackInside[128];
+	int top = 0;
+	stack[top] = 0;
+	stackInside[top++] = false;
+
+	while (top > 0) {
+		top--;
+		const Node& node = nodes[stack[top]];
+		bool inside = stackInside[top];
+		if (!inside) {
+			int side = ClassifyBox(node, planes_, planeCount_);
+			if (side < 0)
+				continue;
+			inside = side > 0;
+		}
+
+		if (node.count > 0) {
+			leaf_(node, inside);
+			continue;
+		}
+
+		stack[top] = node.offset;
+		stackInside[top++] = inside;
+		stack[top] = node.offset + 1;
+		stackInside[top++] = inside;
+	}
+}
+
+template <typename LeafFunc>
+void BVH::Traverse(const float origin_[3], const float direction_[3],
+	float & tMax_, LeafFunc leaf_) const
+{
+	if (nodes.empty())
+		return;
+
+	//tiny instead of zero components keep the slabs free of inf * 0
+	float invDir[4];
+	for (int i = 0; i < 3; i++) {
+		float d = direction_[i];
+		if (d > -1e-20f && d < 1e-20f)
+			d = d < 0.0f ? -1e-20f : 1e-20f;
+		invDir[i] = 1.0f / d;
+	}
+	invDir[3] = 0.0f;
+	__m128 origin = _mm_setr_ps(origin_[0], origin_[1], origin_[2], 0.0f);
+	__m128 inv = _mm_loadu_ps(invDir);
+
+	float tNear;
+	if (!IntersectBox(nodes[0], origin, inv, tMax_, tNear))
+		return;
+
+	int stack[128];
+	float stackNear[128];
+	int top = 0;
+	stack[top] = 0;
+	stackNear[top++] = tNear;
+
+	while (top > 0) {
+		top--;
+		//a closer hit may have been found since this node was pushed
+		if (stackNear[top] >= tMax_)
+			continue;
+		const Node& node = nodes[stack[top]];
+
+		if (node.count > 0) {
+			leaf_(node, tMax_);
+			continue;
+		}
+
+		float nearA, nearB;
+		bool hitA = IntersectBox(nodes[node.offset], origin, inv, tMax_, nearA);
+		bool hitB = IntersectBox(nodes[node.offset + 1], origin, inv, tMax_, nearB);
+		int a = node.offset, b = node.offset + 1;
+		if (hitA && hitB && nearB < nearA) {
+			std::swap(a, b);
+			std::swap(nearA, nearB);
+		}
+		else if (!hitA) {
+			a = b;
+			nearA = nearB;
+			hitA = hitB;
+			hitB = false;
+		}
+
+		//far child below the near one, so the near one pops first
+		if (hitB) {
+			stack[top] = b;
+			stackNear[top++] = nearB;
+		}
+		if (hitA) {
+			stack[top] = a;
+			stackNear[top++] = nearA;
+		}
+	}
+}
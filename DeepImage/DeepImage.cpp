@@ -1,6 +1,17 @@
 #include "DeepImage.h"
 
 #include <QFileDialog>
+#include <fstream>
+#include <sstream>
+
+#include "MeshRepair.h"
+#include "ResourceTracker.h"
+
+static const int RESOURCE_REFRESH_MS = 500;
+static const int REPAIR_POLL_MS = 100;
+static const int SMOOTH_ITERATIONS = 10;
+static const float SMOOTH_LAMBDA = 0.5f;
+static const int RESOURCE_PANEL_OWNERS = 10;
 
 DeepImage::DeepImage(QWidget *parent)
 	: QWidget(parent)
@@ -9,8 +20,18 @@ DeepImage::DeepImage(QWidget *parent)
 	ui.openGLWidget->SetModelManager(modelManager);
 
 	connect(ui.pushButton, SIGNAL(clicked()), this, SLOT(ModelLoaded()));
+	connect(ui.pushButton_2, SIGNAL(clicked()), this, SLOT(ModelDeleted()));
+	connect(ui.pushButton_4, SIGNAL(clicked()), this, SLOT(ModelSmoothed()));
 	connect(ui.radioButton, SIGNAL(toggled(bool)), this, SLOT(GizmoChanged()));
 	connect(ui.radioButton_2, SIGNAL(toggled(bool)), this, SLOT(GizmoChanged()));
+	connect(ui.radioButton_3, SIGNAL(toggled(bool)), this, SLOT(GizmoChanged()));
+	connect(ui.checkBox_2, SIGNAL(toggled(bool)), this, SLOT(TessellationToggled(bool)));
+
+	ui.resourcePanel->hide();
+	connect(ui.checkBox, SIGNAL(toggled(bool)), this, SLOT(ResourcesToggled(bool)));
+	connect(ui.pushButton_3, SIGNAL(clicked()), this, SLOT(ResourcesDumped()));
+	connect(&resourceTimer, SIGNAL(timeout()), this, SLOT(ResourcesRefreshed()));
+	connect(&repairTimer, SIGNAL(timeout()), this, SLOT(RepairsCollected()));
 }
 
 void DeepImage::ModelLoaded()
@@ -21,18 +42,66 @@ void DeepImage::ModelLoaded()
 	if (filePath.isEmpty())
 		return;
 
+	//the reader already reported why
 	Model3D* model = new Model3D;
-	model->Load(filePath.toStdString());
+	if (!model->Load(filePath.toStdString())) {
+		delete model;
+		return;
+	}
 	ui.openGLWidget->makeCurrent();
 	model->Init();
 	modelManager.AddModel(model);
 
+	//the model shows as loaded, the repair swaps itself in when done
+	if (!MeshRepair::Instance().IsIdle())
+		repairTimer.start(REPAIR_POLL_MS);
+
 	ui.openGLWidget->update();
 }
 
 void DeepImage::ModelDeleted()
 {
+	if (!modelManager.HasSelected())
+		return;
+
+	ui.openGLWidget->makeCurrent();
+	modelManager.RemoveSelecteds();
+	ui.openGLWidget->doneCurrent();
 
+	ui.openGLWidget->update();
+}
+
+void DeepImage::ModelSmoothed()
+{
+	if (!modelManager.HasSelected())
+		return;
+
+	//the frames upload the result as the iterations go
+	modelManager.SmoothSelecteds(SMOOTH_ITERATIONS, SMOOTH_LAMBDA);
+	ui.openGLWidget->update();
+}
+
+void DeepImage::RepairsCollected()
+{
+	MeshRepair& repair = MeshRepair::Instance();
+	bool idle = repair.IsIdle();
+	std::vector<MeshRepairResult*> results;
+	repair.Collect(results);
+
+	if (!results.empty()) {
+		ui.openGLWidget->makeCurrent();
+		for (int i = 0; i < results.size(); i++) {
+			modelManager.ApplyRepair(*results[i]);
+			qInfo("Repaired %s: %s", results[i]->name.c_str(),
+				DescribeMeshRepair(results[i]->report).c_str());
+			delete results[i];
+		}
+		ui.openGLWidget->doneCurrent();
+		ui.openGLWidget->update();
+	}
+
+	if (idle)
+		repairTimer.stop();
 }
 
 void DeepImage::GizmoChanged()
@@ -40,11 +109,58 @@ void DeepImage::GizmoChanged()
 	if (ui.radioButton->isChecked()) {
 		ui.openGLWidget->SetGizmoType(Screen::TRANSLATE);
 		ui.radioButton_2->setChecked(false);
+		ui.radioButton_3->setChecked(false);
 	}
 	else if (ui.radioButton_2->isChecked()) {
 		ui.openGLWidget->SetGizmoType(Screen::ROTATE);
 		ui.radioButton->setChecked(false);
+		ui.radioButton_3->setChecked(false);
+	}
+	else if (ui.radioButton_3->isChecked()) {
+		ui.openGLWidget->SetGizmoType(Screen::SCALE);
+		ui.radioButton->setChecked(false);
+		ui.radioButton_2->setChecked(false);
 	}
 
 	ui.openGLWidget->update();
 }
+
+void DeepImage::TessellationToggled(bool on_)
+{
+	ui.openGLWidget->SetTessellation(on_);
+}
+
+void DeepImage::ResourcesToggled(bool on_)
+{
+	ui.resourcePanel->setVisible(on_);
+	if (on_) {
+		ResourcesRefreshed();
+		resourceTimer.start(RESOURCE_REFRESH_MS);
+	}
+	else
+		resourceTimer.stop();
+}
+
+void DeepImage::ResourcesRefreshed()
+{
+	const ResidencyStats& stats = modelManager.GetResidency().GetStats();
+	std::ostringstream stream;
+	stream << "resident " << stats.residentCount << " meshes, "
+		<< (stats.gpuBytes >> 20) << " MB\n"
+		<< "uploads " << stats.uploads << ", evictions " << stats.evictions
+		<< ", cache reads " << stats.cacheLoads << "\n\n"
+		<< ResourceTracker::Instance().Report(RESOURCE_PANEL_OWNERS);
+	ui.resourcePanel->setPlainText(QString::fromStdString(stream.str()));
+}
+
+void DeepImage::ResourcesDumped()
+{
+	QString filePath = QFileDialog::getSaveFileName(this, tr("Save Resources"),
+		"./resources.json",
+		tr("JSON (*.json)"));
+	if (filePath.isEmpty())
+		return;
+
+	std::ofstream file(filePath.toStdString());
+	file << ResourceTracker::Instance().Dump();
+}
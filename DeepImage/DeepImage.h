@@ -1,6 +1,7 @@
 #pragma once
 
 #include <QtWidgets/QWidget>
+#include <QTimer>
 #include "ui_DeepImage.h"
 #include "ModelManager.h"
 
@@ -9,6 +10,8 @@ class DeepImage : public QWidget
 	Q_OBJECT
 private:
 	ModelManager modelManager;
+	QTimer resourceTimer;
+	QTimer repairTimer;
 
 public:
 	DeepImage(QWidget *parent = Q_NULLPTR);
@@ -21,5 +24,11 @@ private:
 private slots:
 	void ModelLoaded();
 	void ModelDeleted();
+	void ModelSmoothed();
+	void RepairsCollected();
 	void GizmoChanged();
+	void TessellationToggled(bool on_);
+	void ResourcesToggled(bool on_);
+	void ResourcesRefreshed();
+	void ResourcesDumped();
 };
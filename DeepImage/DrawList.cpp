@@ -0,0 +1,150 @@
+#include "DrawList.h"
+
+#include <cfloat>
+#include <QOpenGLFunctions_4_5_Core>
+
+#include "ThreadPool.h"
+
+static const int PREPARE_GRAIN = 256;
+static const float MIN_SCREEN_SIZE = 1.0f;
+
+DrawList::DrawList()
+	: lodBias(1.0f),
+	proxyBox(0),
+	proxyScreenSize(0.0f),
+	residency(0)
+{
+}
+
+void DrawList::Prepare(ModelManager & modelManager_, const QMatrix4x4 & view_,
+	const QMatrix4x4 & proj_, int viewportHeight_)
+{
+	proj = proj_;
+
+	const SceneStore& scene = modelManager_.GetScene();
+	const Selection& selection = modelManager_.GetSelection();
+
+	//frustum planes in world space, pointing inwards
+	QMatrix4x4 vp = proj_ * view_;
+	QVector4D planes[6] = {
+		vp.row(3) + vp.row(0), vp.row(3) - vp.row(0),
+		vp.row(3) + vp.row(1), vp.row(3) - vp.row(1),
+		vp.row(3) + vp.row(2), vp.row(3) - vp.row(2)
+	};
+
+	bool perspective = proj_(3, 3) == 0.0f;
+	float pixelScale = proj_(1, 1) * viewportHeight_;
+	float minScreenSize = MIN_SCREEN_SIZE * lodBias;
+	float maxProxySize = proxyBox ? proxyScreenSize : 0.0f;
+
+	int count = scene.GetCount();
+	items.resize(count);
+	ThreadPool::Instance().ParallelFor(0, count, PREPARE_GRAIN,
+		[&](int begin_, int end_) {
+		for (int i = begin_; i < end_; i++) {
+			DrawItem& item = items[i];
+			item.mesh = modelManager_.GetMesh(i);
+			item.modelView = view_ * scene.GetWorld(i);
+
+			QVector3D center = (scene.GetWorldMin(i) + scene.GetWorldMax(i)) * 0.5f;
+			QVector3D extent = (scene.GetWorldMax(i) - scene.GetWorldMin(i)) * 0.5f;
+
+			item.visible = true;
+			for (int p = 0; p < 6 && item.visible; p++) {
+				QVector3D n = planes[p].toVector3D();
+				float d = QVector3D::dotProduct(n, center) + planes[p][3];
+				float r = qAbs(n[0]) * extent[0] + qAbs(n[1]) * extent[1] +
+					qAbs(n[2]) * extent[2];
+				if (d + r < 0)
+					item.visible = false;
+			}
+
+			float radius = extent.length();
+			float depth = -view_.map(center).z();
+			if (!perspective)
+				item.screenSize = radius * pixelScale;
+			else if (depth > radius)
+				item.screenSize = radius * pixelScale / depth;
+			else
+				item.screenSize = FLT_MAX;
+			if (item.screenSize < minScreenSize)
+				item.visible = false;
+
+			item.proxy = item.screenSize < maxProxySize;
+			if (item.proxy) {
+				QMatrix4x4 box;
+				box.translate((scene.GetLocalMin(i) + scene.GetLocalMax(i)) * 0.5f);
+				box.scale((scene.GetLocalMax(i) - scene.GetLocalMin(i)) * 0.5f);
+				item.modelView = item.modelView * box;
+			}
+			item.normalMatrix = item.modelView.normalMatrix();
+
+			if (selection.IsSelected(i))
+				item.color = QVector4D(0.0, 1.0, 0.0, 1.0);
+			else
+				item.color = scene.GetColor(i);
+			item.objectID = i + 1;
+		}
+	});
+
+	visibles.clear();
+	for (int i = 0; i < items.size(); i++) {
+		if (items[i].visible)
+			visibles.push_back(i);
+	}
+}
+
+void DrawList::Submit(ShaderProgram & phong_, ShaderProgram * tessellated_)
+{
+	//proxies stay flat boxes, only meshes go through the tessellator
+	SubmitShaded(phong_, true, !tessellated_);
+	if (tessellated_)
+		SubmitShaded(*tessellated_, false, true);
+}
+
+void DrawList::SubmitGBuffer(ShaderProgram & gbuffer_)
+{
+	gbuffer_.Bind();
+	gbuffer_.SetUniformMat4f("u_Proj", proj.constData());
+
+	for (int i = 0; i < visibles.size(); i++) {
+		const DrawItem& item = items[visibles[i]];
+		gbuffer_.SetUniformMat4f("u_ModelView", item.modelView.constData());
+		gbuffer_.SetUniformMat3f("u_NormalMatrix", item.normalMatrix.constData());
+		gbuffer_.SetUniform4f("u_Color", item.color[0], item.color[1],
+			item.color[2], item.color[3]);
+		gbuffer_.SetUniform1ui("u_ObjectID", item.objectID);
+		Draw(item, false);
+	}
+}
+
+void DrawList::SubmitShaded(ShaderProgram & shader_, bool proxies_, bool meshes_)
+{
+	bool patches = shader_.IsTessellated();
+	shader_.Bind();
+	shader_.SetUniformMat4f("u_Proj", proj.constData());
+
+	for (int i = 0; i < visibles.size(); i++) {
+		const DrawItem& item = items[visibles[i]];
+		if (item.proxy ? !proxies_ : !meshes_)
+			continue;
+		shader_.SetUniformMat4f("u_ModelView", item.modelView.constData());
+		shader_.SetUniformMat3f("u_NormalMatrix", item.normalMatrix.constData());
+		shader_.SetUniform4f("u_Color", item.color[0], item.color[1],
+			item.color[2], item.color[3]);
+		Draw(item, patches);
+	}
+}
+
+void DrawList::Draw(const DrawItem & item_, bool patches_)
+{
+	if (item_.proxy) {
+		proxyBox->Draw();
+		return;
+	}
+
+	//a deferred upload skips the mesh for this frame only,
+	//ResidencyManager::EndFrame asks for the next one
+	if (!residency || residency->Request(item_.mesh))
+		item_.mesh->Draw(patches_);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+#include <QMatrix3x3>
+#include <QMatrix4x4>
+#include <QVector4D>
+
+#include "ModelManager.h"
+#include "ShaderProgram.h"
+#include "ProxyBox.h"
+#include "ResidencyManager.h"
+
+struct DrawItem {
+	QMatrix4x4 modelView;
+	QMatrix3x3 normalMatrix;
+	QVector4D color;
+	unsigned int objectID;
+	Model3D* mesh;
+	float screenSize;
+	bool visible;
+	bool proxy;
+};
+
+class DrawList
+{
+private:
+	std::vector<DrawItem> items;
+	std::vector<int> visibles;
+
+	QMatrix4x4 proj;
+
+	float lodBias;
+
+	ProxyBox* proxyBox;
+	float proxyScreenSize;
+
+	ResidencyManager* residency;
+
+public:
+	DrawList();
+
+	//computes transforms, culling, screen size and colors for every model on the
+	//thread pool. touches no GL state, so it may run off the GL thread.
+	void Prepare(ModelManager& modelManager_, const QMatrix4x4& view_,
+		const QMatrix4x4& proj_, int viewportHeight_);
+
+	//streams the prepared items. must run on the GL thread. with
+	//tessellated_ the meshes are drawn as patches through it, proxies
+	//still with phong_.
+	void Submit(ShaderProgram& phong_, ShaderProgram* tessellated_ = 0);
+	void SubmitGBuffer(ShaderProgram& gbuffer_);
+
+	inline void SetLODBias(float lodBias_) { lodBias = lodBias_; }
+	//models smaller than proxyScreenSize_ pixels are drawn as their bounding
+	//box, 0 disables proxies
+	inline void SetProxy(ProxyBox* proxyBox_, float proxyScreenSize_) {
+		proxyBox = proxyBox_;
+		proxyScreenSize = proxyScreenSize_;
+	}
+
+	//routes every mesh draw through residency_, 0 draws whatever is resident
+	inline void SetResidency(ResidencyManager* residency_) { residency = residency_; }
+
+	inline const std::vector<DrawItem>& GetItems() const { return items; }
+	inline int GetVisibleCount() const { return (int)visibles.size(); }
+
+private:
+	void SubmitShaded(ShaderProgram& shader_, bool proxies_, bool meshes_);
+	void Draw(const DrawItem& item_, bool patches_);
+};
@@ -2,9 +2,14 @@
 
 #include <QOpenGLFunctions_4_5_Core>
 
-FBO::FBO(int width_, int height_)
+#include "ResourceTracker.h"
+
+FBO::FBO(int width_, int height_, bool linearFilter_)
 	: width(width_),
-	height(height_)
+	height(height_),
+	linearFilter(linearFilter_),
+	bytes(0),
+	owner(ResourceTracker::Instance().Allocate(ResourceTracker::FRAMEBUFFER, 0))
 {
 	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
 		versionFunctions<QOpenGLFunctions_4_5_Core>();
@@ -12,23 +17,23 @@ FBO::FBO(int width_, int height_)
 	f->glGenFramebuffers(1, &id);
 	Bind();
 
+	int filter = linearFilter ? GL_LINEAR : GL_NEAREST;
 	f->glGenTextures(1, &colorID);
 	f->glBindTexture(GL_TEXTURE_2D, colorID);
-	f->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_FLOAT, 0);
-	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
 
 	f->glGenTextures(1, &depthID);
 	f->glBindTexture(GL_TEXTURE_2D, depthID);
-	f->glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_STENCIL,
-		width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 0);
 	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
+	Allocate();
+
 	f->glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorID, 0);
 	f->glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthID, 0);
 	f->glFramebufferTexture(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, depthID, 0);
@@ -42,7 +47,21 @@ FBO::~FBO()
 	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
 		versionFunctions<QOpenGLFunctions_4_5_Core>();
 
+	f->glDeleteTextures(1, &colorID);
+	f->glDeleteTextures(1, &depthID);
 	f->glDeleteFramebuffers(1, &id);
+
+	ResourceTracker::Instance().Free(ResourceTracker::FRAMEBUFFER, owner, bytes);
+}
+
+void FBO::Resize(int width_, int height_)
+{
+	if (width_ == width && height_ == height)
+		return;
+
+	width = width_;
+	height = height_;
+	Allocate();
 }
 
 void FBO::Bind() const
@@ -60,3 +79,26 @@ void FBO::Unbind() const
 
 	f->glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
+
+void FBO::Allocate()
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	//respecifying the images keeps the texture names, so the framebuffer
+	//attachments stay valid across resizes
+	f->glBindTexture(GL_TEXTURE_2D, colorID);
+	f->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_FLOAT, 0);
+
+	f->glBindTexture(GL_TEXTURE_2D, depthID);
+	f->glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_STENCIL,
+		width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 0);
+
+	f->glBindTexture(GL_TEXTURE_2D, 0);
+
+	//color plus the packed 24/8 depth stencil
+	ResourceTracker& tracker = ResourceTracker::Instance();
+	tracker.Free(ResourceTracker::FRAMEBUFFER, owner, bytes);
+	bytes = (size_t)width * height * (4 + 4);
+	owner = tracker.Allocate(ResourceTracker::FRAMEBUFFER, bytes);
+}
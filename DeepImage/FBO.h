@@ -6,14 +6,27 @@ private:
 	unsigned int colorID, depthID;
 
 	int width, height;
+	bool linearFilter;
+	size_t bytes;
+	int owner;
 
 public:
-	FBO(int width_, int height_);
+	FBO(int width_, int height_, bool linearFilter_ = false);
 	~FBO();
 
+	//reallocates the attachments, the framebuffer object itself is kept
+	void Resize(int width_, int height_);
+
 	void Bind() const;
 	void Unbind() const;
 
+	inline unsigned int GetID() const { return id; }
+	inline unsigned int GetColorTexture() const { return colorID; }
+	inline unsigned int GetDepthTexture() const { return depthID; }
+
 	inline int GetWidth() const { return width; }
 	inline int GetHeight() const { return height; }
-};
\ No newline at end of file
+
+private:
+	void Allocate();
+};
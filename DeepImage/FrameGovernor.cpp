@@ -0,0 +1,74 @@
+#include "FrameGovernor.h"
+
+#include <QLoggingCategory>
+
+//quality transitions for tuning, off unless enabled with
+//QT_LOGGING_RULES="deepimage.governor.debug=true"
+Q_LOGGING_CATEGORY(lcGovernor, "deepimage.governor", QtInfoMsg)
+
+static const QualitySettings LEVELS[] = {
+	//lodBias, ground, proxy size(px), low detail gizmo, tessellated edge(px)
+	{ 1.0f, true, 0.0f, false, 8.0f },
+	{ 4.0f, true, 0.0f, false, 16.0f },
+	{ 4.0f, false, 0.0f, false, 32.0f },
+	{ 8.0f, false, 24.0f, false, 0.0f },
+	{ 16.0f, false, 48.0f, true, 0.0f }
+};
+static const int LEVEL_COUNT = sizeof(LEVELS) / sizeof(LEVELS[0]);
+
+static const int DEGRADE_FRAMES = 3;
+static const int RESTORE_FRAMES = 15;
+static const float HEADROOM = 0.6f;
+static const float SMOOTHING = 0.3f;
+
+FrameGovernor::FrameGovernor(float frameBudget_)
+	: frameBudget(frameBudget_),
+	smoothedTime(0.0f),
+	level(0),
+	overBudgetFrames(0),
+	underBudgetFrames(0)
+{
+}
+
+void FrameGovernor::Update(float frameTime_, bool interacting_)
+{
+	smoothedTime = smoothedTime == 0.0f ? frameTime_ :
+		(1.0f - SMOOTHING) * smoothedTime + SMOOTHING * frameTime_;
+
+	if (!interacting_) {
+		overBudgetFrames = underBudgetFrames = 0;
+		if (level > 0)
+			SetLevel(level - 1, "camera idle");
+		return;
+	}
+
+	if (smoothedTime > frameBudget) {
+		underBudgetFrames = 0;
+		if (++overBudgetFrames >= DEGRADE_FRAMES && level < LEVEL_COUNT - 1) {
+			overBudgetFrames = 0;
+			SetLevel(level + 1, "over budget");
+		}
+	}
+	else if (smoothedTime < frameBudget * HEADROOM) {
+		overBudgetFrames = 0;
+		if (++underBudgetFrames >= RESTORE_FRAMES && level > 0) {
+			underBudgetFrames = 0;
+			SetLevel(level - 1, "headroom");
+		}
+	}
+	else {
+		overBudgetFrames = underBudgetFrames = 0;
+	}
+}
+
+QualitySettings FrameGovernor::GetSettings() const
+{
+	return LEVELS[level];
+}
+
+void FrameGovernor::SetLevel(int level_, const char * reason_)
+{
+	qCDebug(lcGovernor, "Quality level %d -> %d (%s, frame %.2f ms, budget %.2f ms)",
+		level, level_, reason_, smoothedTime, frameBudget);
+	level = level_;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+struct QualitySettings {
+	float lodBias;
+	bool drawGround;
+	float proxyScreenSize;
+	bool lowDetailGizmo;
+	//target screen length of a tessellated edge, 0 draws the plain mesh
+	float tessellationPixels;
+};
+
+//steps quality down while frames miss the budget during interaction and
+//back up when there is headroom. once the camera rests it refines one
+//level per frame until the still image is back at full quality.
+class FrameGovernor
+{
+private:
+	float frameBudget;
+	float smoothedTime;
+
+	int level;
+	int overBudgetFrames;
+	int underBudgetFrames;
+
+public:
+	FrameGovernor(float frameBudget_ = 16.0f);
+
+	inline void SetFrameBudget(float frameBudget_) { frameBudget = frameBudget_; }
+	inline float GetFrameBudget() const { return frameBudget; }
+
+	//feeds the cost of the frame just drawn, in milliseconds
+	void Update(float frameTime_, bool interacting_);
+
+	QualitySettings GetSettings() const;
+	inline int GetLevel() const { return level; }
+	//true while a resting camera still needs refinement frames
+	inline bool NeedsRefinement(bool interacting_) const {
+		return !interacting_ && level > 0;
+	}
+
+private:
+	void SetLevel(int level_, const char* reason_);
+};
@@ -1,63 +1,150 @@
 #include "Gizmo.h"
 
-static const float EPSILON = 1e-6;
+//hover tolerance in pixels
+static const float HOVERED_DIST = 15.f;
+
+//floats per instance: column major model matrix and colour
+static const int INSTANCE_FLOATS = 20;
+
+//handle meshes, evaluated at compile time
+static constexpr auto TRANSLATE_HIGH = Primitives::Arrow<30>(0.1f, 0.15f, 0.7f);
+static constexpr auto TRANSLATE_LOW = Primitives::Arrow<8>(0.1f, 0.15f, 0.7f);
+static constexpr auto ROTATE_HIGH = Primitives::Torus<30, 30>(1.0f, 0.05f);
+static constexpr auto ROTATE_LOW = Primitives::Torus<16, 6>(1.0f, 0.05f);
+static constexpr auto SCALE_HIGH = Primitives::BoxArrow<16>(0.2f, 0.02f, 0.8f, 0.1f);
+static constexpr auto SCALE_LOW = Primitives::BoxArrow<6>(0.2f, 0.02f, 0.8f, 0.1f);
+static constexpr auto SCALE_CUBE = Primitives::Cube(0.12f);
+
+static GizmoGeometry* translateGeometry[Gizmo::DETAIL_COUNT] = { 0, 0 };
+static GizmoGeometry* rotateGeometry[Gizmo::DETAIL_COUNT] = { 0, 0 };
+static GizmoGeometry* scaleGeometry[Gizmo::DETAIL_COUNT] = { 0, 0 };
+static GizmoGeometry* scaleCubeGeometry = 0;
 
-static bool IntersectPlane(const qglviewer::Vec &n, const qglviewer::Vec &p0,
-	const qglviewer::Vec &l0, const qglviewer::Vec &l, float &t)
+Gizmo::Gizmo()
+	: screenFactor(1.0f),
+	detail(HIGH_DETAIL),
+	dragging(false)
 {
-	// assuming vectors are all normalized
-	float denom = n * l;
-	if (abs(denom) > EPSILON) {
-		qglviewer::Vec p0l0 = p0 - l0;
-		t = (p0l0 * n) / denom;
-		return (t >= 0);
-	}
+	for (int i = 0; i < DETAIL_COUNT; i++)
+		geometry[i] = 0;
+}
 
-	return false;
+Gizmo::~Gizmo()
+{
 }
 
-Gizmo::Gizmo()
-	: vao(0),
-	vbo(0),
-	ibo(0),
-	screenFactor(1.0f),
-	dragging(false)
+void Gizmo::Init()
 {
+	for (int i = 0; i < DETAIL_COUNT; i++)
+		Upload(*geometry[i]);
+}
 
+void Gizmo::Share(GizmoGeometry * shared_[DETAIL_COUNT])
+{
+	for (int i = 0; i < DETAIL_COUNT; i++) {
+		geometry[i] = shared_[i];
+		geometry[i]->users++;
+	}
 }
 
-Gizmo::~Gizmo()
+void Gizmo::Release(GizmoGeometry * shared_[DETAIL_COUNT])
 {
-	delete vao;
-	delete vbo;
-	delete ibo;
+	for (int i = 0; i < DETAIL_COUNT; i++) {
+		if (shared_[i] && --shared_[i]->users == 0) {
+			delete shared_[i];
+			shared_[i] = 0;
+		}
+	}
 }
 
-void Gizmo::Init()
+void Gizmo::AddAxisInstances(GizmoGeometry & geometry_, const QMatrix4x4 & offset_)
 {
-	std::vector<float> vertices;
-	std::vector<unsigned int> indices;
-	mesh.GetVertices(vertices, false, false);
-	mesh.GetIndices(indices);
+	QMatrix4x4 rotations[3];
+	rotations[1].rotate(90, 0, 0, 1);
+	rotations[2].rotate(-90, 0, 1, 0);
+	QVector4D colors[3] = {
+		QVector4D(1, 0, 0, 1), QVector4D(0, 1, 0, 1), QVector4D(0, 0, 1, 1)
+	};
+	for (int i = 0; i < 3; i++) {
+		geometry_.instanceModels.push_back(rotations[i] * offset_);
+		geometry_.instanceColors.push_back(colors[i]);
+	}
+}
+
+void Gizmo::Upload(GizmoGeometry & geometry_)
+{
+	//built by the first gizmo of the type
+	if (geometry_.vao)
+		return;
 
-	vao = new VAO;
-	vbo = new VBO(vertices.data(), vertices.size() * sizeof(float));
+	geometry_.vao = new VAO;
+	geometry_.vbo = new VBO(geometry_.vertices, geometry_.vertexFloatCount * sizeof(float));
 	VBOLayout layout;
 	layout.Push<float>(3);
-	vao->AddBuffer(*vbo, layout);
+	geometry_.vao->AddBuffer(*geometry_.vbo, layout);
+
+	std::vector<float> instances;
+	for (int i = 0; i < geometry_.instanceModels.size(); i++) {
+		const float* m = geometry_.instanceModels[i].constData();
+		instances.insert(instances.end(), m, m + 16);
+		const QVector4D& c = geometry_.instanceColors[i];
+		instances.insert(instances.end(), { c[0], c[1], c[2], c[3] });
+	}
+	geometry_.instances = new VBO(instances.data(), instances.size() * sizeof(float));
+	VBOLayout instanceLayout;
+	instanceLayout.SetDivisor(1);
+	for (int i = 0; i < INSTANCE_FLOATS / 4; i++)
+		instanceLayout.Push<float>(4);
+	geometry_.vao->AddBuffer(*geometry_.instances, instanceLayout, 1);
+
+	geometry_.ibo = new IBO(geometry_.indices, geometry_.indexCount);
+}
 
-	ibo = new IBO(indices.data(), indices.size());
+QMatrix4x4 Gizmo::GetMVP(const QMatrix4x4 & view_, const QMatrix4x4 & proj_)
+{
+	double dm[4][4];
+	frame.getWorldMatrix(dm);
+	QMatrix4x4 modelMatrix;
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++)
+			modelMatrix.data()[i * 4 + j] = dm[i][j];
+	modelMatrix.scale(screenFactor);
+	return proj_ * view_ * modelMatrix;
+}
+
+void Gizmo::DrawGeometry(const GizmoGeometry & geometry_, const QMatrix4x4 & mvp_,
+	int hovered_, ShaderProgram & prog_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	prog_.SetUniformMat4f("u_MVP", mvp_.constData());
+	prog_.SetUniform1i("u_Hovered", hovered_);
+	geometry_.vao->Bind();
+	geometry_.ibo->Bind();
+	f->glDrawElementsInstanced(GL_TRIANGLES, geometry_.ibo->GetCount(), GL_UNSIGNED_INT, 0,
+		(int)geometry_.instanceModels.size());
 }
 
 GizmoTranslate::GizmoTranslate()
 	: translateType(NONE)
 {
-	Create();
+	if (!translateGeometry[HIGH_DETAIL]) {
+		QMatrix4x4 offset;
+		offset.translate(1, 0, 0);
+		for (int i = 0; i < DETAIL_COUNT; i++) {
+			translateGeometry[i] = new GizmoGeometry;
+			AddAxisInstances(*translateGeometry[i], offset);
+		}
+		translateGeometry[HIGH_DETAIL]->SetMesh(TRANSLATE_HIGH);
+		translateGeometry[LOW_DETAIL]->SetMesh(TRANSLATE_LOW);
+	}
+	Share(translateGeometry);
 }
 
 GizmoTranslate::~GizmoTranslate()
 {
-
+	Release(translateGeometry);
 }
 
 void GizmoTranslate::Init()
@@ -67,54 +154,9 @@ void GizmoTranslate::Init()
 
 void GizmoTranslate::Draw(QMatrix4x4 view_, QMatrix4x4 proj_, ShaderProgram& prog_)
 {
-	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
-		versionFunctions<QOpenGLFunctions_4_5_Core>();
-
-	f->glClear(GL_DEPTH_BUFFER_BIT);
-
-	QMatrix4x4 translation;
-	translation.translate(1, 0, 0);
-	QMatrix4x4 scaleMatrix;
-	scaleMatrix.scale(screenFactor);
-	const double* dm = frame.worldMatrix();
-	QMatrix4x4 modelMatrix;
-	for (int i = 0; i < 16; i++)
-		modelMatrix.data()[i] = dm[i];
-	QMatrix4x4 mvp = proj_ * view_ * modelMatrix * scaleMatrix * translation;
-
 	prog_.Bind();
-
-	//x-axis
-	prog_.SetUniformMat4f("u_MVP", mvp.data());
-	vao->Bind();
-	ibo->Bind();
-	if (translateType == X_AXIS)
-		prog_.SetUniform4f("u_Color", 1, 1, 1, 1);
-	else
-		prog_.SetUniform4f("u_Color", 1, 0, 0, 1);
-	f->glDrawElements(GL_TRIANGLES, ibo->GetCount(), GL_UNSIGNED_INT, 0);
-
-	//y-axis
-	QMatrix4x4 rotation1;
-	rotation1.rotate(90, 0, 0, 1);
-	mvp = proj_ * view_*modelMatrix*rotation1*scaleMatrix * translation;
-	prog_.SetUniformMat4f("u_MVP", mvp.data());
-	if (translateType == Y_AXIS)
-		prog_.SetUniform4f("u_Color", 1, 1, 1, 1);
-	else
-		prog_.SetUniform4f("u_Color", 0, 1, 0, 1);
-	f->glDrawElements(GL_TRIANGLES, ibo->GetCount(), GL_UNSIGNED_INT, 0);
-
-	//z-axis
-	QMatrix4x4 rotation2;
-	rotation2.rotate(-90, 0, 1, 0);
-	mvp = proj_ * view_*modelMatrix*rotation2*scaleMatrix * translation;
-	prog_.SetUniformMat4f("u_MVP", mvp.data());
-	if (translateType == Z_AXIS)
-		prog_.SetUniform4f("u_Color", 1, 1, 1, 1);
-	else
-		prog_.SetUniform4f("u_Color", 0, 0, 1, 1);
-	f->glDrawElements(GL_TRIANGLES, ibo->GetCount(), GL_UNSIGNED_INT, 0);
+	DrawGeometry(*geometry[detail], GetMVP(view_, proj_),
+		translateType == NONE ? -1 : translateType, prog_);
 }
 
 void GizmoTranslate::MousePressed(QPoint p_, const qglviewer::Camera & cam_)
@@ -164,91 +206,43 @@ void GizmoTranslate::AdjustScale(const qglviewer::Camera & cam_)
 	screenFactor = -posC[2] * SCALETODEPTH;
 }
 
-void GizmoTranslate::Create()
+void GizmoTranslate::BuildHitShapes()
 {
-	static const int SEGMENT_COUNT = 30;
-	static const float INNER_RADIUS = 0.1f;
-	static const float OUTER_RADIUS = 0.15f;
-	static const float CYLINDER_LEN = 0.7f;
-
-	TriMesh::VertexHandle vhEnd1 = mesh.add_vertex(TriMesh::Point(0, 0, 0));
-	TriMesh::VertexHandle vhEnd2 = mesh.add_vertex(TriMesh::Point(1, 0, 0));
-
-	std::vector<TriMesh::VertexHandle> vhs1, vhs2, vhs3;
-	for (int i = 0; i < SEGMENT_COUNT; i++) {
-		float angle = 2 * M_PI*(i / (float)SEGMENT_COUNT);
-		float x1 = 0;
-		float x2 = CYLINDER_LEN;
-		float yi = INNER_RADIUS * cos(angle);
-		float zi = INNER_RADIUS * sin(angle);
-		float yo = OUTER_RADIUS * cos(angle);
-		float zo = OUTER_RADIUS * sin(angle);
-
-		vhs1.push_back(mesh.add_vertex(TriMesh::Point(x1, yi, zi)));
-		vhs2.push_back(mesh.add_vertex(TriMesh::Point(x2, yi, zi)));
-		vhs3.push_back(mesh.add_vertex(TriMesh::Point(x2, yo, zo)));
-	}
-
-	for (int i = 0; i < SEGMENT_COUNT; i++) {
-		int nextIndex = (i + 1) % SEGMENT_COUNT;
-
-		mesh.add_face(vhEnd1, vhs1[nextIndex], vhs1[i]);
-		mesh.add_face(vhs1[i], vhs2[nextIndex], vhs2[i]);
-		mesh.add_face(vhs1[i], vhs1[nextIndex], vhs2[nextIndex]);
-		mesh.add_face(vhs2[i], vhs3[nextIndex], vhs3[i]);
-		mesh.add_face(vhs2[i], vhs2[nextIndex], vhs3[nextIndex]);
-		mesh.add_face(vhEnd2, vhs3[i], vhs3[nextIndex]);
-	}
-}
-
-void GizmoTranslate::UpdateConstraint(QPoint p_, const qglviewer::Camera & cam_)
-{
-	static const float HOVERED_DIST = 15.f;
-	qglviewer::Vec cursor(p_.x(), p_.y(), 0);
-
 	qglviewer::Vec axisDir[3] = {
 		qglviewer::Vec(1, 0, 0),
 		qglviewer::Vec(0, 1, 0),
 		qglviewer::Vec(0, 0, 1)
 	};
-	for (int i = 0; i < 3; i++) {
-		qglviewer::Vec model1 = screenFactor * axisDir[i];
-		qglviewer::Vec model2 = 2 * screenFactor*axisDir[i];
-		qglviewer::Vec world1 = frame.inverseCoordinatesOf(model1);
-		qglviewer::Vec world2 = frame.inverseCoordinatesOf(model2);
-		qglviewer::Vec screen1 = cam_.projectedCoordinatesOf(world1);
-		qglviewer::Vec screen2 = cam_.projectedCoordinatesOf(world2);
-		screen1[2] = screen2[2] = 0.0;
-
-		qglviewer::Vec disp = cursor - screen1;
-		qglviewer::Vec dir = screen2 - screen1;
-		float len = dir.normalize();
-
-		if (abs(len) < EPSILON && disp.norm() < HOVERED_DIST) {
-			translateType = static_cast<TranslateType>(i);
-			return;
-		}
-		else {
-			float t = qMax(0.0f, qMin(len, (float)(disp*dir)));
-			qglviewer::Vec proj = screen1 + t * dir;
-			float dist = (cursor - proj).norm();
-			if (dist < HOVERED_DIST) {
-				translateType = static_cast<TranslateType>(i);
-				return;
-			}
-		}
-	}
+	for (int i = 0; i < 3; i++)
+		hitTester.AddSegment(i, screenFactor * axisDir[i], 2 * screenFactor * axisDir[i]);
+}
+
+void GizmoTranslate::UpdateConstraint(QPoint p_, const qglviewer::Camera & cam_)
+{
+	if (hitTester.Begin(cam_, frame, screenFactor))
+		BuildHitShapes();
 
-	translateType = static_cast<TranslateType>(3);
+	int part = hitTester.Hit(p_, HOVERED_DIST);
+	translateType = part < 0 ? NONE : static_cast<TranslateType>(part);
 }
 
 GizmoRotate::GizmoRotate()
+	: rotateType(NONE)
 {
-	Create();
+	if (!rotateGeometry[HIGH_DETAIL]) {
+		for (int i = 0; i < DETAIL_COUNT; i++) {
+			rotateGeometry[i] = new GizmoGeometry;
+			AddAxisInstances(*rotateGeometry[i], QMatrix4x4());
+		}
+		rotateGeometry[HIGH_DETAIL]->SetMesh(ROTATE_HIGH);
+		rotateGeometry[LOW_DETAIL]->SetMesh(ROTATE_LOW);
+	}
+	Share(rotateGeometry);
 }
 
 GizmoRotate::~GizmoRotate()
 {
+	Release(rotateGeometry);
 }
 
 void GizmoRotate::Init()
@@ -258,51 +252,9 @@ void GizmoRotate::Init()
 
 void GizmoRotate::Draw(QMatrix4x4 view_, QMatrix4x4 proj_, ShaderProgram& prog_)
 {
-	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
-		versionFunctions<QOpenGLFunctions_4_5_Core>();
-
-	f->glClear(GL_DEPTH_BUFFER_BIT);
-	QMatrix4x4 scaleMatrix;
-	scaleMatrix.scale(screenFactor);
-	const double* dm = frame.worldMatrix();
-	QMatrix4x4 modelMatrix;
-	for (int i = 0; i < 16; i++)
-		modelMatrix.data()[i] = dm[i];
-	QMatrix4x4 mvp = proj_ * view_ * modelMatrix * scaleMatrix;
-
 	prog_.Bind();
-
-	//x-axis
-	prog_.SetUniformMat4f("u_MVP", mvp.data());
-	vao->Bind();
-	ibo->Bind();
-	if (rotateType == X_AXIS)
-		prog_.SetUniform4f("u_Color", 1, 1, 1, 1);
-	else
-		prog_.SetUniform4f("u_Color", 1, 0, 0, 1);
-	f->glDrawElements(GL_TRIANGLES, ibo->GetCount(), GL_UNSIGNED_INT, 0);
-
-	//y-axis
-	QMatrix4x4 rotation1;
-	rotation1.rotate(90, 0, 0, 1);
-	mvp = proj_ * view_*modelMatrix*rotation1*scaleMatrix;
-	prog_.SetUniformMat4f("u_MVP", mvp.data());
-	if (rotateType == Y_AXIS)
-		prog_.SetUniform4f("u_Color", 1, 1, 1, 1);
-	else
-		prog_.SetUniform4f("u_Color", 0, 1, 0, 1);
-	f->glDrawElements(GL_TRIANGLES, ibo->GetCount(), GL_UNSIGNED_INT, 0);
-
-	//z-axis
-	QMatrix4x4 rotation2;
-	rotation2.rotate(-90, 0, 1, 0);
-	mvp = proj_ * view_*modelMatrix*rotation2*scaleMatrix;
-	prog_.SetUniformMat4f("u_MVP", mvp.data());
-	if (rotateType == Z_AXIS)
-		prog_.SetUniform4f("u_Color", 1, 1, 1, 1);
-	else
-		prog_.SetUniform4f("u_Color", 0, 0, 1, 1);
-	f->glDrawElements(GL_TRIANGLES, ibo->GetCount(), GL_UNSIGNED_INT, 0);
+	DrawGeometry(*geometry[detail], GetMVP(view_, proj_),
+		rotateType == NONE ? -1 : rotateType, prog_);
 }
 
 void GizmoRotate::MousePressed(QPoint p_, const qglviewer::Camera & cam_)
@@ -352,77 +304,165 @@ void GizmoRotate::AdjustScale(const qglviewer::Camera & cam_)
 	screenFactor = -posC[2] * SCALETODEPTH;
 }
 
-void GizmoRotate::Create()
+void GizmoRotate::BuildHitShapes()
 {
-	static const int TORUS_SEGMENT_COUNT = 30;
-	static const int CIRCLE_SEGMENT_COUNT = 30;
-	static const float TORUS_RADIUS = 1.0f;
-	static const float CIRCLE_RADIUS = 0.05f;
+	static const int CIRCLE_SEGMENT_COUNT = 48;
 
-	std::vector<qglviewer::Vec> circlePts;
-	for (int i = 0; i < CIRCLE_SEGMENT_COUNT; i++) {
-		float angle = 2 * M_PI*i / (float)CIRCLE_SEGMENT_COUNT;
-		float x = CIRCLE_RADIUS * cos(angle);
-		float y = CIRCLE_RADIUS * sin(angle) + TORUS_RADIUS;
-		circlePts.push_back(qglviewer::Vec(x, y, 0));
-	}
+	qglviewer::Vec axisDir[3] = {
+		qglviewer::Vec(1, 0, 0),
+		qglviewer::Vec(0, 1, 0),
+		qglviewer::Vec(0, 0, 1)
+	};
+	//the ring of an axis lies in the plane of the other two
+	for (int i = 0; i < 3; i++)
+		hitTester.AddCircle(i, axisDir[(i + 1) % 3], axisDir[(i + 2) % 3],
+			screenFactor, CIRCLE_SEGMENT_COUNT);
+}
 
-	std::vector<TriMesh::VertexHandle> vhs;
-	for (int i = 0; i < TORUS_SEGMENT_COUNT; i++) {
-		float angle = 2 * M_PI*i / (float)TORUS_SEGMENT_COUNT;
-		qglviewer::Quaternion q(qglviewer::Vec(1, 0, 0), angle);
-		for (int j = 0; j < CIRCLE_SEGMENT_COUNT; j++) {
-			qglviewer::Vec pt = q.rotate(circlePts[j]);
-			vhs.push_back(mesh.add_vertex(TriMesh::Point(pt[0], pt[1], pt[2])));
+void GizmoRotate::UpdateConstraint(QPoint p_, const qglviewer::Camera & cam_)
+{
+	if (hitTester.Begin(cam_, frame, screenFactor))
+		BuildHitShapes();
+
+	int part = hitTester.Hit(p_, HOVERED_DIST);
+	rotateType = part < 0 ? NONE : static_cast<RotateType>(part);
+}
+
+
+GizmoScale::GizmoScale()
+	: scaleType(NONE),
+	pressPos(0, 0),
+	dragDirX(0.0f),
+	dragDirY(0.0f)
+{
+	if (!scaleGeometry[HIGH_DETAIL]) {
+		for (int i = 0; i < DETAIL_COUNT; i++) {
+			scaleGeometry[i] = new GizmoGeometry;
+			AddAxisInstances(*scaleGeometry[i], QMatrix4x4());
 		}
+		scaleGeometry[HIGH_DETAIL]->SetMesh(SCALE_HIGH);
+		scaleGeometry[LOW_DETAIL]->SetMesh(SCALE_LOW);
+
+		scaleCubeGeometry = new GizmoGeometry;
+		scaleCubeGeometry->SetMesh(SCALE_CUBE);
+		scaleCubeGeometry->instanceModels.push_back(QMatrix4x4());
+		scaleCubeGeometry->instanceColors.push_back(QVector4D(1, 1, 0, 1));
 	}
+	Share(scaleGeometry);
+	cube = scaleCubeGeometry;
+	cube->users++;
+}
+
+GizmoScale::~GizmoScale()
+{
+	Release(scaleGeometry);
+	if (--cube->users == 0) {
+		delete cube;
+		scaleCubeGeometry = 0;
+	}
+}
+
+void GizmoScale::Init()
+{
+	Gizmo::Init();
+	Upload(*cube);
+}
+
+void GizmoScale::Draw(QMatrix4x4 view_, QMatrix4x4 proj_, ShaderProgram& prog_)
+{
+	QMatrix4x4 mvp = GetMVP(view_, proj_);
+	prog_.Bind();
+	DrawGeometry(*geometry[detail], mvp,
+		scaleType == NONE || scaleType == UNIFORM ? -1 : scaleType, prog_);
+	DrawGeometry(*cube, mvp, scaleType == UNIFORM ? 0 : -1, prog_);
+}
 
-	for (int i = 0; i < TORUS_SEGMENT_COUNT; i++) {
-		for (int j = 0; j < CIRCLE_SEGMENT_COUNT; j++) {
-			mesh.add_face(vhs[i*CIRCLE_SEGMENT_COUNT + j],
-				vhs[i*CIRCLE_SEGMENT_COUNT + (j + 1) % CIRCLE_SEGMENT_COUNT],
-				vhs[((i + 1) % TORUS_SEGMENT_COUNT)*CIRCLE_SEGMENT_COUNT + j]);
-			mesh.add_face(vhs[((i + 1) % TORUS_SEGMENT_COUNT)*CIRCLE_SEGMENT_COUNT + j],
-				vhs[i*CIRCLE_SEGMENT_COUNT + (j + 1) % CIRCLE_SEGMENT_COUNT],
-				vhs[((i + 1) % TORUS_SEGMENT_COUNT)*CIRCLE_SEGMENT_COUNT +
-				(j + 1) % CIRCLE_SEGMENT_COUNT]);
+void GizmoScale::MousePressed(QPoint p_, const qglviewer::Camera & cam_)
+{
+	if (scaleType == NONE)
+		return;
+
+	pressPos = p_;
+	dragDirX = dragDirY = 0.0f;
+	if (scaleType != UNIFORM) {
+		qglviewer::Vec axis(0, 0, 0);
+		axis[scaleType] = screenFactor;
+		qglviewer::Vec s0 = cam_.projectedCoordinatesOf(frame.position());
+		qglviewer::Vec s1 = cam_.projectedCoordinatesOf(frame.inverseCoordinatesOf(axis));
+		float dx = s1[0] - s0[0], dy = s1[1] - s0[1];
+		float len2 = dx * dx + dy * dy;
+		if (len2 > 1.0f) {
+			dragDirX = dx / len2;
+			dragDirY = dy / len2;
 		}
 	}
+
+	frame.BeginScale();
+	dragging = true;
 }
 
-void GizmoRotate::UpdateConstraint(QPoint p_, const qglviewer::Camera & cam_)
+void GizmoScale::MouseMoved(QPoint p_, const qglviewer::Camera & cam_)
+{
+	//pixels of drag that double a uniform scale
+	static const float UNIFORM_DRAG = 200.0f;
+	static const float MIN_FACTOR = 0.01f;
+
+	if (!dragging) {
+		UpdateConstraint(p_, cam_);
+		return;
+	}
+
+	//right and up grow the uniform scale, the axes grow along their arrow
+	float dx = p_.x() - pressPos.x(), dy = p_.y() - pressPos.y();
+	float factor;
+	if (scaleType == UNIFORM)
+		factor = 1.0f + (dx - dy) / UNIFORM_DRAG;
+	else
+		factor = 1.0f + dx * dragDirX + dy * dragDirY;
+	factor = qMax(factor, MIN_FACTOR);
+
+	QVector3D factors(1, 1, 1);
+	if (scaleType == UNIFORM)
+		factors = QVector3D(factor, factor, factor);
+	else
+		factors[scaleType] = factor;
+	frame.ScaleFollowers(factors);
+}
+
+void GizmoScale::MouseReleased(QPoint p_, const qglviewer::Camera & cam_)
 {
-	static const float HOVERED_DIST = 15.f;
+	if (scaleType == NONE)
+		return;
 
-	qglviewer::Vec originW, dirW;
-	cam_.convertClickToLine(p_, originW, dirW);
-	qglviewer::Vec originM = frame.coordinatesOf(originW);
-	qglviewer::Vec dirM = frame.transformOf(dirW);
+	dragging = false;
+}
+
+void GizmoScale::AdjustScale(const qglviewer::Camera & cam_)
+{
+	static const float SCALETODEPTH = 0.15f;
 
-	qglviewer::Vec cursor(p_.x(), p_.y(), 0);
+	qglviewer::Vec posW = frame.position();
+	qglviewer::Vec posC = cam_.cameraCoordinatesOf(posW);
+	screenFactor = -posC[2] * SCALETODEPTH;
+}
 
-	qglviewer::Vec planeNormal[3] = {
+void GizmoScale::BuildHitShapes()
+{
+	qglviewer::Vec axisDir[3] = {
 		qglviewer::Vec(1, 0, 0),
 		qglviewer::Vec(0, 1, 0),
 		qglviewer::Vec(0, 0, 1)
 	};
-	for (int i = 0; i < 3; i++) {
-		float t;
-		if (!IntersectPlane(planeNormal[i], qglviewer::Vec(0, 0, 0),
-			originM, dirM, t))
-			continue;
-
-		qglviewer::Vec intersection = originM + t * dirM;
-		qglviewer::Vec closestM = screenFactor * intersection / intersection.norm();
-		qglviewer::Vec closestW = frame.inverseCoordinatesOf(closestM);
-		qglviewer::Vec closestSC = cam_.projectedCoordinatesOf(closestW);
-		closestSC[2] = 0;
-		float dist = (cursor - closestSC).norm();
-		if (dist < HOVERED_DIST) {
-			rotateType = static_cast<RotateType>(i);
-			return;
-		}
-	}
+	for (int i = 0; i < 3; i++)
+		hitTester.AddSegment(i, 0.2f * screenFactor * axisDir[i], screenFactor * axisDir[i]);
+	hitTester.AddPoint(UNIFORM, qglviewer::Vec(0, 0, 0));
+}
+
+void GizmoScale::UpdateConstraint(QPoint p_, const qglviewer::Camera & cam_)
+{
+	if (hitTester.Begin(cam_, frame, screenFactor))
+		BuildHitShapes();
 
-	rotateType = static_cast<RotateType>(3);
+	int part = hitTester.Hit(p_, HOVERED_DIST);
+	scaleType = part < 0 ? NONE : static_cast<ScaleType>(part);
 }
@@ -1,24 +1,64 @@
 #pragma once
 
 #include "GizmoFrame.h"
+#include "GizmoHitTester.h"
 #include "VAO.h"
 #include "VBO.h"
 #include "IBO.h"
-#include "TriMesh.h"
+#include "Primitives.h"
 #include "ShaderProgram.h"
-#include "Model3D.h"
+
+//shape of one gizmo type at one detail, shared by every gizmo of that type.
+//the mesh is drawn once per instance, an instance carries the model matrix
+//and the colour of one handle.
+struct GizmoGeometry {
+	//xyz, static storage from Primitives
+	const float* vertices;
+	int vertexFloatCount;
+	const unsigned int* indices;
+	int indexCount;
+	std::vector<QMatrix4x4> instanceModels;
+	std::vector<QVector4D> instanceColors;
+
+	VAO* vao;
+	VBO* vbo;
+	IBO* ibo;
+	VBO* instances;
+
+	int users;
+
+	GizmoGeometry() : vertices(0), vertexFloatCount(0), indices(0), indexCount(0),
+		vao(0), vbo(0), ibo(0), instances(0), users(0) {}
+
+	template<class P>
+	void SetMesh(const P& primitive_) {
+		vertices = primitive_.vertices;
+		vertexFloatCount = P::VERTEX_FLOATS;
+		indices = primitive_.indices;
+		indexCount = P::INDICES;
+	}
+	~GizmoGeometry() {
+		delete vao;
+		delete vbo;
+		delete ibo;
+		delete instances;
+	}
+};
 
 class Gizmo
 {
+public:
+	enum Detail {
+		HIGH_DETAIL, LOW_DETAIL, DETAIL_COUNT
+	};
+
 protected:
 	GizmoFrame frame;
 	float screenFactor;
+	GizmoHitTester hitTester;
 
-	VAO* vao;
-	VBO* vbo;
-	IBO* ibo;
-
-	TriMesh mesh;
+	GizmoGeometry* geometry[DETAIL_COUNT];
+	Detail detail;
 
 	bool dragging;
 
@@ -35,20 +75,37 @@ public:
 
 	virtual void AdjustScale(const qglviewer::Camera& cam_) = 0;
 	void SetPosition(qglviewer::Vec pos_) { frame.setPosition(pos_); }
+	inline void SetDetail(Detail detail_) { detail = detail_; }
 
 	virtual inline bool IsHover() = 0;
 
 	inline qglviewer::ManipulatedFrame& GetFrame() { return frame; }
 
-	void Followed(Model3D& model_) {
-		frame.Followed(model_.GetFrame());
+	void Followed(SceneStore& store_, SceneHandle handle_) {
+		frame.Followed(store_, handle_);
 	}
-	void UnFollowed(Model3D& model_) {
-		frame.UnFollowed(model_.GetFrame());
+	void UnFollowed(SceneHandle handle_) {
+		frame.UnFollowed(handle_);
 	}
 	void ClearFollower() {
 		frame.ClearFollower();
 	}
+
+protected:
+	//takes a reference on the shared geometry of a gizmo type, Release
+	//drops it and deletes the geometry with the last user. the GL context
+	//must be current for the last Release.
+	void Share(GizmoGeometry* shared_[DETAIL_COUNT]);
+	static void Release(GizmoGeometry* shared_[DETAIL_COUNT]);
+	//the three axis handles share the mesh built along x
+	static void AddAxisInstances(GizmoGeometry& geometry_, const QMatrix4x4& offset_);
+	static void Upload(GizmoGeometry& geometry_);
+
+	//gizmo model matrix times the screen factor
+	QMatrix4x4 GetMVP(const QMatrix4x4& view_, const QMatrix4x4& proj_);
+	//every instance in one call, hovered_ is the instance drawn highlighted
+	void DrawGeometry(const GizmoGeometry& geometry_, const QMatrix4x4& mvp_,
+		int hovered_, ShaderProgram& prog_);
 };
 
 class GizmoTranslate : public Gizmo
@@ -75,8 +132,7 @@ public:
 	virtual inline bool IsHover() { return translateType != NONE; }
 
 private:
-	void Create();
-
+	void BuildHitShapes();
 	void UpdateConstraint(QPoint p_, const qglviewer::Camera & cam_);
 };
 
@@ -104,7 +160,42 @@ public:
 	virtual inline bool IsHover() { return rotateType != NONE; }
 
 private:
-	void Create();
+	void BuildHitShapes();
+	void UpdateConstraint(QPoint p_, const qglviewer::Camera & cam_);
+};
+
+class GizmoScale : public Gizmo
+{
+private:
+	enum ScaleType {
+		X_AXIS, Y_AXIS, Z_AXIS, UNIFORM, NONE
+	};
+	ScaleType scaleType;
 
+	//handle of the uniform scale at the centre
+	GizmoGeometry* cube;
+
+	//drag start and the screen direction of the dragged axis, divided by
+	//its squared length so a dot product gives the scale factor
+	QPoint pressPos;
+	float dragDirX, dragDirY;
+
+public:
+	GizmoScale();
+	~GizmoScale();
+
+	virtual void Init();
+	virtual void Draw(QMatrix4x4 view_, QMatrix4x4 proj_, ShaderProgram& prog_);
+
+	virtual void MousePressed(QPoint p_, const qglviewer::Camera& cam_);
+	virtual void MouseMoved(QPoint p_, const qglviewer::Camera& cam_);
+	virtual void MouseReleased(QPoint p_, const qglviewer::Camera& cam_);
+
+	virtual void AdjustScale(const qglviewer::Camera& cam_);
+
+	virtual inline bool IsHover() { return scaleType != NONE; }
+
+private:
+	void BuildHitShapes();
 	void UpdateConstraint(QPoint p_, const qglviewer::Camera & cam_);
 };
\ No newline at end of file
@@ -40,7 +40,8 @@ void GizmoFrameConstraint::constrainRotation(qglviewer::Quaternion & rotation, q
 }
 
 GizmoFrame::GizmoFrame()
-	: constraint(this)
+	: store(0),
+	constraint(this)
 {
 	setConstraint(&constraint);
 }
@@ -49,36 +50,65 @@ GizmoFrame::~GizmoFrame()
 {
 }
 
-void GizmoFrame::Followed(qglviewer::Frame & frame_)
+void GizmoFrame::Followed(SceneStore & store_, SceneHandle handle_)
 {
-	followers.push_back(&frame_);
+	store = &store_;
+	followers.push_back(handle_);
 }
 
-void GizmoFrame::UnFollowed(qglviewer::Frame & frame_)
+void GizmoFrame::UnFollowed(SceneHandle handle_)
 {
-	std::vector<qglviewer::Frame*>::iterator it = 
-		std::find(followers.begin(), followers.end(), &frame_);
-	if (it != followers.end()) {
-		followers.erase(it);
+	for (int i = 0; i < followers.size(); i++) {
+		if (followers[i].slot == handle_.slot &&
+			followers[i].generation == handle_.generation) {
+			followers.erase(followers.begin() + i);
+			return;
+		}
 	}
 }
 
 void GizmoFrame::TranslateFollowers(qglviewer::Vec t_)
 {
-	for (int i = 0; i < followers.size(); i++) {
-		followers[i]->translate(t_);
-	}
+	ResolveFollowers();
+	if (!followerIndices.empty())
+		store->Translate(followerIndices, t_);
 }
 
 void GizmoFrame::RotateFollowers(qglviewer::Vec axis_, qglviewer::Vec pos_, float angle_)
 {
-	for (int i = 0; i < followers.size(); i++) {
-		qglviewer::Quaternion quatM(followers[i]->transformOf(axis_), angle_);
-		followers[i]->rotate(quatM);
+	ResolveFollowers();
+	if (!followerIndices.empty())
+		store->Rotate(followerIndices, qglviewer::Quaternion(axis_, angle_), pos_);
+}
+
+void GizmoFrame::BeginScale()
+{
+	ResolveFollowers();
+	startScales.resize(followerIndices.size());
+	for (int i = 0; i < followerIndices.size(); i++)
+		startScales[i] = store->GetScale(followerIndices[i]);
+}
+
+void GizmoFrame::ScaleFollowers(const QVector3D & factor_)
+{
+	if (followerIndices.empty())
+		return;
 
-		qglviewer::Quaternion quatW(axis_, angle_);
-		followers[i]->setPosition(
-			pos_ + quatW.rotate(followers[i]->position() - pos_));
+	scales.resize(startScales.size());
+	for (int i = 0; i < startScales.size(); i++)
+		scales[i] = startScales[i] * factor_;
+	store->SetScale(followerIndices, scales);
+}
+
+void GizmoFrame::ResolveFollowers()
+{
+	followerIndices.clear();
+	if (!store)
+		return;
+	for (int i = 0; i < followers.size(); i++) {
+		int idx = store->GetIndex(followers[i]);
+		if (idx >= 0)
+			followerIndices.push_back(idx);
 	}
 }
 
@@ -2,6 +2,8 @@
 
 #include <QGLViewer/manipulatedFrame.h>
 
+#include "SceneStore.h"
+
 class GizmoFrame;
 class GizmoFrameConstraint : public qglviewer::Constraint
 {
@@ -33,21 +35,31 @@ private:
 class GizmoFrame : public qglviewer::ManipulatedFrame
 {
 private:
-	std::vector<qglviewer::Frame*> followers;
+	SceneStore* store;
+	std::vector<SceneHandle> followers;
+	//dense indices of the live followers, resolved once per drag step
+	std::vector<int> followerIndices;
+	//model space scales of the followers when the scale drag started
+	std::vector<QVector3D> startScales, scales;
 	GizmoFrameConstraint constraint;
 
 public:
 	GizmoFrame();
 	~GizmoFrame();
 
-	void Followed(qglviewer::Frame& frame_);
-	void UnFollowed(qglviewer::Frame& frame_);
+	//all followers live in the same store, the last one passed wins
+	void Followed(SceneStore& store_, SceneHandle handle_);
+	void UnFollowed(SceneHandle handle_);
 	inline void ClearFollower() {
 		followers.clear();
 	}
 
 	void TranslateFollowers(qglviewer::Vec t_);
 	void RotateFollowers(qglviewer::Vec axis_, qglviewer::Vec pos_, float angle_);
+	//scale drags are driven by GizmoScale rather than by QGLViewer. factor_
+	//multiplies the start scale along the model axes of every follower.
+	void BeginScale();
+	void ScaleFollowers(const QVector3D& factor_);
 
 	enum ConstraintType {
 		TRANSLATE_ALONG_XAXIS,
@@ -59,4 +71,7 @@ public:
 	};
 	void SetLocalConstraint(ConstraintType type_);
 	void SetWorldConstraint(ConstraintType type_);
+
+private:
+	void ResolveFollowers();
 };
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "GizmoHitTester.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+GizmoHitTester::GizmoHitTester()
+	: width(0),
+	height(0),
+	valid(false)
+{
+}
+
+bool GizmoHitTester::Begin(const qglviewer::Camera & cam_, const qglviewer::Frame & frame_,
+	float screenFactor_)
+{
+	double mvp[16];
+	cam_.getModelViewProjectionMatrix(mvp);
+	qglviewer::Vec pos = frame_.position();
+	qglviewer::Quaternion quat = frame_.orientation();
+
+	double current[26];
+	memcpy(current, mvp, sizeof(mvp));
+	for (int i = 0; i < 3; i++)
+		current[16 + i] = pos[i];
+	for (int i = 0; i < 4; i++)
+		current[19 + i] = quat[i];
+	current[23] = screenFactor_;
+	current[24] = cam_.screenWidth();
+	current[25] = cam_.screenHeight();
+	if (valid && memcmp(current, signature, sizeof(signature)) == 0)
+		return false;
+	memcpy(signature, current, sizeof(signature));
+	valid = true;
+
+	//window from model: mvp * world of the gizmo frame, both column major
+	double world[4][4];
+	frame_.getWorldMatrix(world);
+	for (int c = 0; c < 4; c++)
+		for (int r = 0; r < 4; r++) {
+			double sum = 0.0;
+			for (int k = 0; k < 4; k++)
+				sum += mvp[k * 4 + r] * world[c][k];
+			transform[c * 4 + r] = sum;
+		}
+	width = cam_.screenWidth();
+	height = cam_.screenHeight();
+
+	segments.clear();
+	return true;
+}
+
+void GizmoHitTester::AddSegment(int part_, const qglviewer::Vec & a_, const qglviewer::Vec & b_)
+{
+	Segment segment;
+	segment.part = part_;
+	if (!Project(a_, segment.ax, segment.ay) || !Project(b_, segment.bx, segment.by))
+		return;
+	segments.push_back(segment);
+}
+
+void GizmoHitTester::AddPoint(int part_, const qglviewer::Vec & p_)
+{
+	AddSegment(part_, p_, p_);
+}
+
+void GizmoHitTester::AddCircle(int part_, const qglviewer::Vec & u_, const qglviewer::Vec & v_,
+	float radius_, int segmentCount_)
+{
+	qglviewer::Vec prev = radius_ * u_;
+	for (int i = 1; i <= segmentCount_; i++) {
+		float angle = 2 * M_PI * i / (float)segmentCount_;
+		qglviewer::Vec next = radius_ * (cos(angle) * u_ + sin(angle) * v_);
+		AddSegment(part_, prev, next);
+		prev = next;
+	}
+}
+
+int GizmoHitTester::Hit(QPoint p_, float radius_) const
+{
+	float px = p_.x(), py = p_.y();
+	float best = radius_ * radius_;
+	int part = -1;
+	for (int i = 0; i < segments.size(); i++) {
+		const Segment& s = segments[i];
+		float dx = s.bx - s.ax, dy = s.by - s.ay;
+		float len2 = dx * dx + dy * dy;
+		float t = 0.0f;
+		if (len2 > FLT_EPSILON)
+			t = qBound(0.0f, ((px - s.ax) * dx + (py - s.ay) * dy) / len2, 1.0f);
+		float ex = s.ax + t * dx - px, ey = s.ay + t * dy - py;
+		float dist2 = ex * ex + ey * ey;
+		if (dist2 < best) {
+			best = dist2;
+			part = s.part;
+		}
+	}
+	return part;
+}
+
+bool GizmoHitTester::Project(const qglviewer::Vec & p_, float & x_, float & y_) const
+{
+	double clip[4];
+	for (int r = 0; r < 4; r++)
+		clip[r] = transform[r] * p_[0] + transform[4 + r] * p_[1] +
+		transform[8 + r] * p_[2] + transform[12 + r];
+	if (clip[3] <= 0.0)
+		return false;
+
+	//same convention as Camera::projectedCoordinatesOf, y grows downwards
+	x_ = (float)((clip[0] / clip[3] * 0.5 + 0.5) * width);
+	y_ = (float)((0.5 - clip[1] / clip[3] * 0.5) * height);
+	return true;
+}
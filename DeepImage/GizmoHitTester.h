@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include <QPoint>
+#include <QGLViewer/camera.h>
+
+//screen space shapes of a gizmo for hover tests. the parts are projected
+//once whenever the camera, the viewport, the gizmo frame or its scale
+//changes, a hover query is then a few 2D point to segment distances and
+//never goes through Camera::projectedCoordinatesOf.
+class GizmoHitTester
+{
+private:
+	struct Segment {
+		int part;
+		float ax, ay;
+		float bx, by;
+	};
+
+	std::vector<Segment> segments;
+
+	//model space to window coordinates of the current build
+	double transform[16];
+	int width, height;
+
+	//camera, viewport and gizmo state the shapes were built for
+	double signature[26];
+	bool valid;
+
+public:
+	GizmoHitTester();
+
+	//true when the shapes have to be rebuilt for this state, in that case
+	//the shapes are cleared and the new projection is taken
+	bool Begin(const qglviewer::Camera& cam_, const qglviewer::Frame& frame_,
+		float screenFactor_);
+	inline void Invalidate() { valid = false; }
+
+	//shapes are given in gizmo model space
+	void AddSegment(int part_, const qglviewer::Vec& a_, const qglviewer::Vec& b_);
+	void AddPoint(int part_, const qglviewer::Vec& p_);
+	//circle of radius_ around the origin in the plane spanned by u_ and v_,
+	//projected as a closed polyline of segmentCount_ pieces so perspective
+	//is exact at the vertices
+	void AddCircle(int part_, const qglviewer::Vec& u_, const qglviewer::Vec& v_,
+		float radius_, int segmentCount_);
+
+	//part closest to p_ within radius_ pixels, -1 for none
+	int Hit(QPoint p_, float radius_) const;
+
+private:
+	//false for points behind the camera
+	bool Project(const qglviewer::Vec& p_, float& x_, float& y_) const;
+};
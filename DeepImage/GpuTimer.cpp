@@ -0,0 +1,68 @@
+#include "GpuTimer.h"
+
+#include <QOpenGLFunctions_4_5_Core>
+
+GpuTimer::GpuTimer()
+	: current(0),
+	lastTime(0.0)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	f->glGenQueries(QUERY_COUNT, beginIds);
+	f->glGenQueries(QUERY_COUNT, endIds);
+	for (int i = 0; i < QUERY_COUNT; i++)
+		issued[i] = false;
+}
+
+GpuTimer::~GpuTimer()
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	f->glDeleteQueries(QUERY_COUNT, beginIds);
+	f->glDeleteQueries(QUERY_COUNT, endIds);
+}
+
+void GpuTimer::Begin()
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	Collect();
+	f->glQueryCounter(beginIds[current], GL_TIMESTAMP);
+}
+
+void GpuTimer::End()
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	f->glQueryCounter(endIds[current], GL_TIMESTAMP);
+	issued[current] = true;
+	current = (current + 1) % QUERY_COUNT;
+}
+
+void GpuTimer::Collect()
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	//oldest first, stop at the first query the GPU has not reached yet
+	for (int i = 0; i < QUERY_COUNT; i++) {
+		int idx = (current + i) % QUERY_COUNT;
+		if (!issued[idx])
+			continue;
+
+		int available = 0;
+		f->glGetQueryObjectiv(endIds[idx], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			break;
+
+		GLuint64 begin = 0, end = 0;
+		f->glGetQueryObjectui64v(beginIds[idx], GL_QUERY_RESULT, &begin);
+		f->glGetQueryObjectui64v(endIds[idx], GL_QUERY_RESULT, &end);
+		lastTime = (end - begin) / 1.0e6;
+		issued[idx] = false;
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+//measures GPU time of a block of commands with GL_TIMESTAMP queries, so
+//timers may overlap or nest. results are read a few frames later so the
+//CPU never waits on them.
+class GpuTimer {
+private:
+	static const int QUERY_COUNT = 3;
+
+	unsigned int beginIds[QUERY_COUNT];
+	unsigned int endIds[QUERY_COUNT];
+	bool issued[QUERY_COUNT];
+	int current;
+
+	double lastTime;
+
+public:
+	GpuTimer();
+	~GpuTimer();
+
+	void Begin();
+	void End();
+
+	//milliseconds of the most recent block whose result is available
+	inline double GetLastTime() const { return lastTime; }
+
+private:
+	void Collect();
+};
@@ -2,6 +2,8 @@
 
 #include <QOpenGLFunctions_4_5_Core>
 
+#include "ResourceTracker.h"
+
 IBO::IBO(const unsigned int * data_, unsigned int count_)
 	: count(count_)
 {
@@ -12,6 +14,9 @@ IBO::IBO(const unsigned int * data_, unsigned int count_)
 	f->glBufferData(GL_ELEMENT_ARRAY_BUFFER, 
 		count * sizeof(unsigned int), data_, GL_STATIC_DRAW);
 	Unbind();
+
+	owner = ResourceTracker::Instance().Allocate(ResourceTracker::INDEX_BUFFER,
+		count * sizeof(unsigned int));
 }
 
 IBO::~IBO()
@@ -19,6 +24,9 @@ IBO::~IBO()
 	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
 		versionFunctions<QOpenGLFunctions_4_5_Core>();
 	f->glDeleteBuffers(1, &id);
+
+	ResourceTracker::Instance().Free(ResourceTracker::INDEX_BUFFER, owner,
+		count * sizeof(unsigned int));
 }
 
 void IBO::Bind() const
@@ -4,6 +4,7 @@ class IBO {
 private:
 	unsigned int id;
 	unsigned int count;
+	int owner;
 
 public:
 	IBO(const unsigned int* data_, unsigned int count_);
@@ -0,0 +1,143 @@
+#include "MeshBVH.h"
+
+#include <algorithm>
+#include <cfloat>
+
+static const int LEAF_SIZE = 4;
+static const float DET_EPSILON = 1e-12f;
+
+void MeshBVH::Build(const std::vector<float>& vertices_, int stride_,
+	const std::vector<unsigned int>& indices_)
+{
+	int faceCount = (int)(indices_.size() / 3);
+	std::vector<float> boxes(faceCount * 6);
+	for (int f = 0; f < faceCount; f++) {
+		float* box = &boxes[f * 6];
+		for (int k = 0; k < 3; k++) {
+			box[k] = FLT_MAX;
+			box[k + 3] = -FLT_MAX;
+		}
+		for (int c = 0; c < 3; c++) {
+			const float* p = &vertices_[indices_[f * 3 + c] * stride_];
+			for (int k = 0; k < 3; k++) {
+				box[k] = std::min(box[k], p[k]);
+				box[k + 3] = std::max(box[k + 3], p[k]);
+			}
+		}
+	}
+
+	bvh.Build(boxes, LEAF_SIZE);
+
+	//pack each leaf into one Triangle4, unused lanes get a degenerate
+	//triangle whose zero determinant never passes the test
+	triangles.clear();
+	std::vector<BVH::Node>& nodes = bvh.GetNodes();
+	const std::vector<int>& order = bvh.GetIndices();
+	for (int n = 0; n < nodes.size(); n++) {
+		BVH::Node& node = nodes[n];
+		if (node.count == 0)
+			continue;
+
+		float v0[3][4], e1[3][4], e2[3][4];
+		Triangle4 packed;
+		for (int lane = 0; lane < 4; lane++) {
+			packed.faces[lane] = -1;
+			for (int k = 0; k < 3; k++)
+				v0[k][lane] = e1[k][lane] = e2[k][lane] = 0.0f;
+			if (lane >= node.count)
+				continue;
+
+			int f = order[node.offset + lane];
+			const float* a = &vertices_[indices_[f * 3] * stride_];
+			const float* b = &vertices_[indices_[f * 3 + 1] * stride_];
+			const float* c = &vertices_[indices_[f * 3 + 2] * stride_];
+			for (int k = 0; k < 3; k++) {
+				v0[k][lane] = a[k];
+				e1[k][lane] = b[k] - a[k];
+				e2[k][lane] = c[k] - a[k];
+			}
+			packed.faces[lane] = f;
+		}
+		for (int k = 0; k < 3; k++) {
+			packed.v0[k] = _mm_loadu_ps(v0[k]);
+			packed.e1[k] = _mm_loadu_ps(e1[k]);
+			packed.e2[k] = _mm_loadu_ps(e2[k]);
+		}
+
+		node.offset = (int)triangles.size();
+		triangles.push_back(packed);
+	}
+}
+
+bool MeshBVH::Intersect(const float origin_[3], const float direction_[3],
+	float tMax_, TriangleHit & hit_) const
+{
+	__m128 o[3], d[3];
+	for (int k = 0; k < 3; k++) {
+		o[k] = _mm_set1_ps(origin_[k]);
+		d[k] = _mm_set1_ps(direction_[k]);
+	}
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 epsilon = _mm_set1_ps(DET_EPSILON);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	bool found = false;
+	float tBest = tMax_;
+
+	bvh.Traverse(origin_, direction_, tBest, [&](const BVH::Node& node_, float& tMax_) {
+		const Triangle4& tri = triangles[node_.offset];
+
+		//p = d x e2, det = e1 . p
+		__m128 px = _mm_sub_ps(_mm_mul_ps(d[1], tri.e2[2]), _mm_mul_ps(d[2], tri.e2[1]));
+		__m128 py = _mm_sub_ps(_mm_mul_ps(d[2], tri.e2[0]), _mm_mul_ps(d[0], tri.e2[2]));
+		__m128 pz = _mm_sub_ps(_mm_mul_ps(d[0], tri.e2[1]), _mm_mul_ps(d[1], tri.e2[0]));
+		__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tri.e1[0], px),
+			_mm_mul_ps(tri.e1[1], py)), _mm_mul_ps(tri.e1[2], pz));
+		__m128 valid = _mm_cmpgt_ps(_mm_andnot_ps(signMask, det), epsilon);
+		__m128 invDet = _mm_div_ps(one, det);
+
+		//u = (s . p) / det
+		__m128 sx = _mm_sub_ps(o[0], tri.v0[0]);
+		__m128 sy = _mm_sub_ps(o[1], tri.v0[1]);
+		__m128 sz = _mm_sub_ps(o[2], tri.v0[2]);
+		__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px),
+			_mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), invDet);
+
+		//q = s x e1, v = (d . q) / det, t = (e2 . q) / det
+		__m128 qx = _mm_sub_ps(_mm_mul_ps(sy, tri.e1[2]), _mm_mul_ps(sz, tri.e1[1]));
+		__m128 qy = _mm_sub_ps(_mm_mul_ps(sz, tri.e1[0]), _mm_mul_ps(sx, tri.e1[2]));
+		__m128 qz = _mm_sub_ps(_mm_mul_ps(sx, tri.e1[1]), _mm_mul_ps(sy, tri.e1[0]));
+		__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(d[0], qx),
+			_mm_mul_ps(d[1], qy)), _mm_mul_ps(d[2], qz)), invDet);
+		__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tri.e2[0], qx),
+			_mm_mul_ps(tri.e2[1], qy)), _mm_mul_ps(tri.e2[2], qz)), invDet);
+
+		valid = _mm_and_ps(valid, _mm_cmpge_ps(u, zero));
+		valid = _mm_and_ps(valid, _mm_cmpge_ps(v, zero));
+		valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(u, v), one));
+		valid = _mm_and_ps(valid, _mm_cmpgt_ps(t, zero));
+		valid = _mm_and_ps(valid, _mm_cmplt_ps(t, _mm_set1_ps(tMax_)));
+
+		int mask = _mm_movemask_ps(valid);
+		if (mask == 0)
+			return;
+
+		float ts[4], us[4], vs[4];
+		_mm_storeu_ps(ts, t);
+		_mm_storeu_ps(us, u);
+		_mm_storeu_ps(vs, v);
+		for (int lane = 0; lane < 4; lane++) {
+			if (!(mask & (1 << lane)) || ts[lane] >= tMax_)
+				continue;
+			tMax_ = ts[lane];
+			hit_.face = tri.faces[lane];
+			hit_.t = ts[lane];
+			hit_.u = us[lane];
+			hit_.v = vs[lane];
+			found = true;
+		}
+	});
+
+	return found;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <xmmintrin.h>
+
+#include "BVH.h"
+
+struct TriangleHit {
+	int face;
+	float t;
+	float u, v;
+};
+
+//BVH over the triangles of one mesh, in model space. every leaf holds
+//up to four triangles packed lane by lane, so a leaf is a single 4 wide
+//SSE Moller-Trumbore test.
+class MeshBVH
+{
+private:
+	struct Triangle4 {
+		__m128 v0[3];
+		__m128 e1[3];
+		__m128 e2[3];
+		int faces[4];
+	};
+
+	BVH bvh;
+	std::vector<Triangle4> triangles;
+
+public:
+	//vertices_ holds xyz at the start of every stride_ floats, faces are
+	//numbered by their position in indices_
+	void Build(const std::vector<float>& vertices_, int stride_,
+		const std::vector<unsigned int>& indices_);
+
+	//closest hit with t in (0, tMax_), both faces count. the ray need not
+	//be normalized, t is in units of direction_.
+	bool Intersect(const float origin_[3], const float direction_[3],
+		float tMax_, TriangleHit& hit_) const;
+
+	inline bool IsEmpty() const { return bvh.IsEmpty(); }
+	inline size_t GetMemoryBytes() const {
+		return bvh.GetMemoryBytes() + triangles.capacity() * sizeof(Triangle4);
+	}
+};
@@ -0,0 +1,108 @@
+#include "MeshCache.h"
+
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QDir>
+#include <QFile>
+
+static const unsigned int MESH_CACHE_MAGIC = 0x434d4944; //"DIMC"
+static const unsigned int MESH_CACHE_VERSION = 2;
+
+struct MeshCacheHeader {
+	unsigned int magic;
+	unsigned int version;
+	unsigned int vertexCount;
+	unsigned int indexCount;
+	unsigned int flags;
+};
+
+MeshCache::MeshCache()
+{
+	QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+		"/meshes";
+	QDir().mkpath(dir);
+	cacheDir = dir.toStdString();
+}
+
+MeshCache & MeshCache::Instance()
+{
+	static MeshCache cache;
+	return cache;
+}
+
+std::string MeshCache::MakeKey(const std::string & filePath_)
+{
+	QFileInfo info(QString::fromStdString(filePath_));
+	QString id = info.absoluteFilePath() + "|" + QString::number(info.size()) +
+		"|" + QString::number(info.lastModified().toMSecsSinceEpoch());
+
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	hash.addData(id.toUtf8());
+	return hash.result().toHex().toStdString();
+}
+
+bool MeshCache::Load(const std::string & key_, std::vector<float>& vertices_,
+	std::vector<unsigned int>& indices_, unsigned int* flags_)
+{
+	QFile file(QString::fromStdString(FilePath(key_)));
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	MeshCacheHeader header;
+	if (file.read((char*)&header, sizeof(header)) != sizeof(header) ||
+		header.magic != MESH_CACHE_MAGIC || header.version != MESH_CACHE_VERSION)
+		return false;
+
+	qint64 vertexBytes = (qint64)header.vertexCount * sizeof(float);
+	qint64 indexBytes = (qint64)header.indexCount * sizeof(unsigned int);
+	if (file.size() != sizeof(header) + vertexBytes + indexBytes) {
+		file.close();
+		file.remove();
+		return false;
+	}
+
+	if (flags_)
+		*flags_ = header.flags;
+	vertices_.resize(header.vertexCount);
+	indices_.resize(header.indexCount);
+	return file.read((char*)vertices_.data(), vertexBytes) == vertexBytes &&
+		file.read((char*)indices_.data(), indexBytes) == indexBytes;
+}
+
+bool MeshCache::Store(const std::string & key_, const std::vector<float>& vertices_,
+	const std::vector<unsigned int>& indices_, unsigned int flags_)
+{
+	//written aside and renamed, a crash never leaves a truncated entry
+	QString path = QString::fromStdString(FilePath(key_));
+	QFile file(path + ".tmp");
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+
+	MeshCacheHeader header;
+	header.magic = MESH_CACHE_MAGIC;
+	header.version = MESH_CACHE_VERSION;
+	header.vertexCount = (unsigned int)vertices_.size();
+	header.indexCount = (unsigned int)indices_.size();
+	header.flags = flags_;
+
+	qint64 vertexBytes = (qint64)vertices_.size() * sizeof(float);
+	qint64 indexBytes = (qint64)indices_.size() * sizeof(unsigned int);
+	bool ok = file.write((const char*)&header, sizeof(header)) == sizeof(header) &&
+		file.write((const char*)vertices_.data(), vertexBytes) == vertexBytes &&
+		file.write((const char*)indices_.data(), indexBytes) == indexBytes;
+	file.close();
+
+	QFile::remove(path);
+	if (!ok || !file.rename(path)) {
+		file.remove();
+		return false;
+	}
+	return true;
+}
+
+std::string MeshCache::FilePath(const std::string & key_) const
+{
+	return cacheDir + "/" + key_ + ".mesh";
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+//on-disk cache of the render buffers of loaded meshes. entries are keyed by
+//the source path, size and modification time, so loading a cached file skips
+//the parser, and buffers evicted from memory can be read back quickly.
+class MeshCache
+{
+private:
+	std::string cacheDir;
+
+public:
+	enum Flags {
+		//MeshRepair already ran on the entry
+		REPAIRED = 1
+	};
+
+	MeshCache();
+
+	static MeshCache& Instance();
+
+	std::string MakeKey(const std::string& filePath_);
+
+	//safe to call from any thread, a Store racing a Load of the same key
+	//either fails or replaces the whole entry
+	bool Load(const std::string& key_, std::vector<float>& vertices_,
+		std::vector<unsigned int>& indices_, unsigned int* flags_ = 0);
+	bool Store(const std::string& key_, const std::vector<float>& vertices_,
+		const std::vector<unsigned int>& indices_, unsigned int flags_ = 0);
+
+private:
+	std::string FilePath(const std::string& key_) const;
+};
@@ -0,0 +1,663 @@
+#include "MeshRepair.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <sstream>
+#include <OpenMesh/Tools/Utils/MeshCheckerT.hh>
+
+#include "MeshCache.h"
+#include "ThreadPool.h"
+#include "TriMesh.h"
+
+static const int REPAIR_GRAIN = 8192;
+static const int SORT_GRAIN = 1 << 16;
+//components oriented per task, most meshes have few, broken scans many
+//tiny ones
+static const int COMPONENT_GRAIN = 64;
+//vertices in the same cell of this size relative to the bounding box
+//diagonal are merged
+static const double MERGE_TOLERANCE = 1e-6;
+//faces whose doubled area is below this relative to the squared diagonal
+//are dropped
+static const double DEGENERATE_AREA = 1e-12;
+
+struct VertexKey {
+	long long cell[3];
+	unsigned int vertex;
+};
+
+struct EdgeKey {
+	unsigned long long edge;
+	int halfedge;
+};
+
+//sorted runs of SORT_GRAIN, then merged pairwise, every round in parallel
+template<class T, class Less>
+static void ParallelSort(std::vector<T>& items_, Less less_)
+{
+	ThreadPool& pool = ThreadPool::Instance();
+	int count = (int)items_.size();
+	pool.ParallelFor(0, count, SORT_GRAIN, [&](int begin_, int end_) {
+		std::sort(items_.begin() + begin_, items_.begin() + end_, less_);
+	});
+
+	for (long long width = SORT_GRAIN; width < count; width *= 2) {
+		int pairs = (int)((count + 2 * width - 1) / (2 * width));
+		pool.ParallelFor(0, pairs, 1, [&](int begin_, int end_) {
+			for (int i = begin_; i < end_; i++) {
+				long long b = i * 2 * width;
+				long long m = std::min((long long)count, b + width);
+				long long e = std::min((long long)count, b + 2 * width);
+				std::inplace_merge(items_.begin() + b, items_.begin() + m,
+					items_.begin() + e, less_);
+			}
+		});
+	}
+}
+
+static inline const float* Point(const std::vector<float>& vertices_, int stride_,
+	unsigned int i_)
+{
+	return vertices_.data() + (size_t)i_ * stride_;
+}
+
+static inline void Cross(const float* a_, const float* b_, const float* c_, double n_[3])
+{
+	double u[3], v[3];
+	for (int k = 0; k < 3; k++) {
+		u[k] = (double)b_[k] - a_[k];
+		v[k] = (double)c_[k] - a_[k];
+	}
+	n_[0] = u[1] * v[2] - u[2] * v[1];
+	n_[1] = u[2] * v[0] - u[0] * v[2];
+	n_[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+//builds the half-edge mesh and runs MeshCheckerT on it. faces with
+//repeated or invalid indices are left to the repair.
+static void Validate(const std::vector<float>& vertices_, int stride_,
+	const std::vector<unsigned int>& indices_, MeshRepairReport& report_)
+{
+	int vertexCount = (int)(vertices_.size() / stride_);
+	int faceCount = (int)(indices_.size() / 3);
+
+	TriMesh mesh;
+	mesh.reserve(vertexCount, faceCount * 3 / 2, faceCount);
+	std::vector<TriMesh::VertexHandle> handles(vertexCount);
+	for (int i = 0; i < vertexCount; i++) {
+		const float* p = Point(vertices_, stride_, i);
+		handles[i] = mesh.add_vertex(TriMesh::Point(p[0], p[1], p[2]));
+	}
+
+	//add_face would log every complex vertex and edge, broken scans have
+	//thousands of them and they are counted anyway
+	for (int f = 0; f < faceCount; f++) {
+		unsigned int a = indices_[3 * f], b = indices_[3 * f + 1], c = indices_[3 * f + 2];
+		if (a >= (unsigned int)vertexCount || b >= (unsigned int)vertexCount ||
+			c >= (unsigned int)vertexCount ||
+			a == b || b == c || a == c)
+			continue;
+		if (!mesh.CanAddFace(handles[a], handles[b], handles[c]) ||
+			!mesh.add_face(handles[a], handles[b], handles[c]).is_valid())
+			report_.rejectedFaces++;
+	}
+	mesh.TrackMemory();
+
+	std::ostringstream log;
+	OpenMesh::Utils::MeshCheckerT<TriMesh> checker(mesh);
+	report_.checkPassed = checker.check(OpenMesh::Utils::MeshCheckerT<TriMesh>::CHECK_ALL, log);
+	std::string text = log.str();
+	report_.checkErrors = (int)std::count(text.begin(), text.end(), '\n');
+}
+
+//remap_[v] is the lowest vertex in the cell of v
+static int MergeVertices(const std::vector<float>& vertices_, int stride_,
+	double cellSize_, std::vector<unsigned int>& remap_)
+{
+	ThreadPool& pool = ThreadPool::Instance();
+	int vertexCount = (int)(vertices_.size() / stride_);
+
+	std::vector<VertexKey> keys(vertexCount);
+	double scale = cellSize_ > 0.0 ? 1.0 / cellSize_ : 1.0;
+	pool.ParallelFor(0, vertexCount, REPAIR_GRAIN, [&](int begin_, int end_) {
+		for (int i = begin_; i < end_; i++) {
+			const float* p = Point(vertices_, stride_, i);
+			for (int k = 0; k < 3; k++)
+				keys[i].cell[k] = (long long)std::floor(p[k] * scale);
+			keys[i].vertex = i;
+		}
+	});
+
+	ParallelSort(keys, [](const VertexKey& a_, const VertexKey& b_) {
+		for (int k = 0; k < 3; k++) {
+			if (a_.cell[k] != b_.cell[k])
+				return a_.cell[k] < b_.cell[k];
+		}
+		return a_.vertex < b_.vertex;
+	});
+
+	remap_.resize(vertexCount);
+	std::atomic<int> merged(0);
+	pool.ParallelFor(0, vertexCount, REPAIR_GRAIN, [&](int begin_, int end_) {
+		int count = 0;
+		for (int i = begin_; i < end_; i++) {
+			const long long* cell = keys[i].cell;
+			if (i > 0 && cell[0] == keys[i - 1].cell[0] &&
+				cell[1] == keys[i - 1].cell[1] && cell[2] == keys[i - 1].cell[2])
+				continue;
+
+			//a run may reach into the next chunk, only its start walks it
+			unsigned int first = keys[i].vertex;
+			remap_[first] = first;
+			for (int j = i + 1; j < vertexCount && keys[j].cell[0] == cell[0] &&
+				keys[j].cell[1] == cell[1] && keys[j].cell[2] == cell[2]; j++) {
+				remap_[keys[j].vertex] = first;
+				count++;
+			}
+		}
+		merged += count;
+	});
+	return merged;
+}
+
+//remaps the indices and drops faces that are out of range or have no area
+static int RemoveDegenerateFaces(const std::vector<float>& vertices_, int stride_,
+	const std::vector<unsigned int>& remap_, double areaLimit_,
+	std::vector<unsigned int>& indices_)
+{
+	ThreadPool& pool = ThreadPool::Instance();
+	unsigned int vertexCount = (unsigned int)remap_.size();
+	int faceCount = (int)(indices_.size() / 3);
+	int chunkCount = (faceCount + REPAIR_GRAIN - 1) / REPAIR_GRAIN;
+
+	std::vector<unsigned char> keep(faceCount);
+	std::vector<int> offsets(chunkCount + 1, 0);
+	pool.ParallelFor(0, faceCount, REPAIR_GRAIN, [&](int begin_, int end_) {
+		int count = 0;
+		for (int f = begin_; f < end_; f++) {
+			unsigned int* face = indices_.data() + 3 * f;
+			keep[f] = 0;
+			if (face[0] >= vertexCount || face[1] >= vertexCount || face[2] >= vertexCount)
+				continue;
+			for (int k = 0; k < 3; k++)
+				face[k] = remap_[face[k]];
+			if (face[0] == face[1] || face[1] == face[2] || face[0] == face[2])
+				continue;
+
+			double n[3];
+			Cross(Point(vertices_, stride_, face[0]), Point(vertices_, stride_, face[1]),
+				Point(vertices_, stride_, face[2]), n);
+			if (n[0] * n[0] + n[1] * n[1] + n[2] * n[2] <= areaLimit_ * areaLimit_)
+				continue;
+
+			keep[f] = 1;
+			count++;
+		}
+		offsets[begin_ / REPAIR_GRAIN + 1] = count;
+	});
+
+	for (int c = 0; c < chunkCount; c++)
+		offsets[c + 1] += offsets[c];
+
+	std::vector<unsigned int> kept((size_t)offsets[chunkCount] * 3);
+	pool.ParallelFor(0, faceCount, REPAIR_GRAIN, [&](int begin_, int end_) {
+		size_t out = (size_t)offsets[begin_ / REPAIR_GRAIN] * 3;
+		for (int f = begin_; f < end_; f++) {
+			if (!keep[f])
+				continue;
+			kept[out++] = indices_[3 * f];
+			kept[out++] = indices_[3 * f + 1];
+			kept[out++] = indices_[3 * f + 2];
+		}
+	});
+
+	indices_.swap(kept);
+	return faceCount - offsets[chunkCount];
+}
+
+//union-find root with path halving, safe against concurrent Unite calls
+static int FindRoot(std::vector<std::atomic<int>>& parents_, int f_)
+{
+	while (true) {
+		int parent = parents_[f_].load(std::memory_order_relaxed);
+		if (parent == f_)
+			return f_;
+		int grandParent = parents_[parent].load(std::memory_order_relaxed);
+		if (grandParent != parent)
+			parents_[f_].compare_exchange_weak(parent, grandParent, std::memory_order_relaxed);
+		f_ = grandParent;
+	}
+}
+
+//links the higher root under the lower one, retried when another thread
+//moved either root meanwhile
+static void Unite(std::vector<std::atomic<int>>& parents_, int a_, int b_)
+{
+	while (true) {
+		a_ = FindRoot(parents_, a_);
+		b_ = FindRoot(parents_, b_);
+		if (a_ == b_)
+			return;
+		if (a_ > b_)
+			std::swap(a_, b_);
+		int expected = b_;
+		if (parents_[b_].compare_exchange_strong(expected, a_, std::memory_order_relaxed))
+			return;
+	}
+}
+
+//walks the faces across manifold edges, one component per task, and
+//flips the ones that disagree with their component. a closed component ends up with positive volume,
+//an open one keeps the orientation most of its faces had.
+static int OrientFaces(const std::vector<float>& vertices_, int stride_,
+	const double center_[3], std::vector<unsigned int>& indices_,
+	MeshRepairReport& report_)
+{
+	ThreadPool& pool = ThreadPool::Instance();
+	int faceCount = (int)(indices_.size() / 3);
+	int halfedgeCount = faceCount * 3;
+
+	std::vector<EdgeKey> edges(halfedgeCount);
+	pool.ParallelFor(0, faceCount, REPAIR_GRAIN, [&](int begin_, int end_) {
+		for (int f = begin_; f < end_; f++) {
+			for (int k = 0; k < 3; k++) {
+				unsigned long long a = indices_[3 * f + k];
+				unsigned long long b = indices_[3 * f + (k + 1) % 3];
+				edges[3 * f + k].edge = a < b ? (a << 32) | b : (b << 32) | a;
+				edges[3 * f + k].halfedge = 3 * f + k;
+			}
+		}
+	});
+
+	ParallelSort(edges, [](const EdgeKey& a_, const EdgeKey& b_) {
+		return a_.edge != b_.edge ? a_.edge < b_.edge : a_.halfedge < b_.halfedge;
+	});
+
+	//only edges with exactly two faces connect them
+	std::vector<int> twins(halfedgeCount, -1);
+	std::atomic<int> boundary(0), nonManifold(0);
+	pool.ParallelFor(0, halfedgeCount, REPAIR_GRAIN, [&](int begin_, int end_) {
+		int boundaryCount = 0, nonManifoldCount = 0;
+		for (int i = begin_; i < end_; i++) {
+			if (i > 0 && edges[i].edge == edges[i - 1].edge)
+				continue;
+			int j = i + 1;
+			while (j < halfedgeCount && edges[j].edge == edges[i].edge)
+				j++;
+
+			if (j - i == 1)
+				boundaryCount++;
+			else if (j - i == 2) {
+				twins[edges[i].halfedge] = edges[i + 1].halfedge;
+				twins[edges[i + 1].halfedge] = edges[i].halfedge;
+			}
+			else
+				nonManifoldCount++;
+		}
+		boundary += boundaryCount;
+		nonManifold += nonManifoldCount;
+	});
+	report_.boundaryEdges = boundary;
+	report_.nonManifoldEdges = nonManifold;
+	std::vector<EdgeKey>().swap(edges);
+
+	//components first, with a lock free union-find over the manifold
+	//edges. roots link to the lower face, so every root is the lowest face
+	//of its component.
+	std::vector<std::atomic<int>> parents(faceCount);
+	pool.ParallelFor(0, faceCount, REPAIR_GRAIN, [&](int begin_, int end_) {
+		for (int f = begin_; f < end_; f++)
+			parents[f].store(f, std::memory_order_relaxed);
+	});
+	pool.ParallelFor(0, faceCount, REPAIR_GRAIN, [&](int begin_, int end_) {
+		for (int f = begin_; f < end_; f++) {
+			for (int k = 0; k < 3; k++) {
+				int twin = twins[3 * f + k];
+				if (twin >= 0 && twin / 3 > f)
+					Unite(parents, f, twin / 3);
+			}
+		}
+	});
+
+	std::vector<int> components(faceCount);
+	pool.ParallelFor(0, faceCount, REPAIR_GRAIN, [&](int begin_, int end_) {
+		for (int f = begin_; f < end_; f++)
+			components[f] = FindRoot(parents, f);
+	});
+	std::vector<int> seeds;
+	for (int f = 0; f < faceCount; f++) {
+		if (components[f] == f)
+			seeds.push_back(f);
+	}
+	std::vector<std::atomic<int>>().swap(parents);
+	int componentCount = (int)seeds.size();
+	report_.components = componentCount;
+
+	std::vector<int> seedLabels(faceCount, -1);
+	for (int c = 0; c < componentCount; c++)
+		seedLabels[seeds[c]] = c;
+	pool.ParallelFor(0, faceCount, REPAIR_GRAIN, [&](int begin_, int end_) {
+		for (int f = begin_; f < end_; f++)
+			components[f] = seedLabels[components[f]];
+	});
+	std::vector<int>().swap(seedLabels);
+
+	//then breadth first from every seed, the components in parallel. a
+	//task only ever touches the faces of its own components. flips[f] is
+	//relative to the seed, the volume sums decide the final orientation.
+	std::vector<unsigned char> flips(faceCount, 0), visited(faceCount, 0);
+	std::vector<double> volumes(componentCount, 0.0);
+	std::vector<int> sizes(componentCount, 0), flipCounts(componentCount, 0);
+	std::vector<unsigned char> open(componentCount, 0);
+	pool.ParallelFor(0, componentCount, COMPONENT_GRAIN, [&](int begin_, int end_) {
+		std::vector<int> queue;
+		for (int c = begin_; c < end_; c++) {
+			queue.clear();
+			queue.push_back(seeds[c]);
+			visited[seeds[c]] = 1;
+			for (int q = 0; q < queue.size(); q++) {
+				int f = queue[q];
+				for (int k = 0; k < 3; k++) {
+					int twin = twins[3 * f + k];
+					if (twin < 0) {
+						open[c] = 1;
+						continue;
+					}
+					int g = twin / 3;
+					if (visited[g])
+						continue;
+
+					//neighbours agree when they run along the edge in opposite
+					//directions, i.e. start at different vertices
+					bool sameDirection = indices_[3 * f + k] == indices_[twin];
+					visited[g] = 1;
+					flips[g] = flips[f] ^ (unsigned char)sameDirection;
+					queue.push_back(g);
+				}
+
+				double p[3][3];
+				for (int k = 0; k < 3; k++) {
+					const float* v = Point(vertices_, stride_, indices_[3 * f + k]);
+					for (int d = 0; d < 3; d++)
+						p[k][d] = v[d] - center_[d];
+				}
+				double volume = p[0][0] * (p[1][1] * p[2][2] - p[1][2] * p[2][1]) -
+					p[0][1] * (p[1][0] * p[2][2] - p[1][2] * p[2][0]) +
+					p[0][2] * (p[1][0] * p[2][1] - p[1][1] * p[2][0]);
+				volumes[c] += flips[f] ? -volume : volume;
+				flipCounts[c] += flips[f];
+			}
+			sizes[c] = (int)queue.size();
+		}
+	});
+
+	std::vector<unsigned char> inverts(componentCount);
+	for (int c = 0; c < componentCount; c++)
+		inverts[c] = open[c] ? flipCounts[c] * 2 > sizes[c] : volumes[c] < 0.0;
+
+	std::atomic<int> flipped(0);
+	pool.ParallelFor(0, faceCount, REPAIR_GRAIN, [&](int begin_, int end_) {
+		int count = 0;
+		for (int f = begin_; f < end_; f++) {
+			if (!(flips[f] ^ inverts[components[f]]))
+				continue;
+			std::swap(indices_[3 * f + 1], indices_[3 * f + 2]);
+			count++;
+		}
+		flipped += count;
+	});
+	return flipped;
+}
+
+//drops vertices no face uses, returns how many
+static int RemoveUnusedVertices(std::vector<float>& vertices_, int stride_,
+	std::vector<unsigned int>& indices_)
+{
+	ThreadPool& pool = ThreadPool::Instance();
+	int vertexCount = (int)(vertices_.size() / stride_);
+
+	std::vector<unsigned int> remap(vertexCount, 0);
+	for (int i = 0; i < indices_.size(); i++)
+		remap[indices_[i]] = 1;
+	unsigned int used = 0;
+	for (int i = 0; i < vertexCount; i++)
+		remap[i] = remap[i] ? used++ : ~0u;
+	if (used == (unsigned int)vertexCount)
+		return 0;
+
+	std::vector<float> kept((size_t)used * stride_);
+	pool.ParallelFor(0, vertexCount, REPAIR_GRAIN, [&](int begin_, int end_) {
+		for (int i = begin_; i < end_; i++) {
+			if (remap[i] != ~0u)
+				std::copy(vertices_.begin() + (size_t)i * stride_,
+					vertices_.begin() + (size_t)(i + 1) * stride_,
+					kept.begin() + (size_t)remap[i] * stride_);
+		}
+	});
+	pool.ParallelFor(0, (int)indices_.size(), REPAIR_GRAIN, [&](int begin_, int end_) {
+		for (int i = begin_; i < end_; i++)
+			indices_[i] = remap[indices_[i]];
+	});
+
+	vertices_.swap(kept);
+	return vertexCount - used;
+}
+
+//area weighted vertex normals at offset 3, gathered per vertex through a
+//vertex to face table so every vertex is written by one thread
+static void UpdateNormals(std::vector<float>& vertices_, int stride_,
+	const std::vector<unsigned int>& indices_)
+{
+	ThreadPool& pool = ThreadPool::Instance();
+	int vertexCount = (int)(vertices_.size() / stride_);
+	int faceCount = (int)(indices_.size() / 3);
+
+	std::vector<double> faceNormals((size_t)faceCount * 3);
+	pool.ParallelFor(0, faceCount, REPAIR_GRAIN, [&](int begin_, int end_) {
+		for (int f = begin_; f < end_; f++) {
+			Cross(Point(vertices_, stride_, indices_[3 * f]),
+				Point(vertices_, stride_, indices_[3 * f + 1]),
+				Point(vertices_, stride_, indices_[3 * f + 2]),
+				faceNormals.data() + (size_t)f * 3);
+		}
+	});
+
+	std::vector<int> offsets(vertexCount + 1, 0);
+	for (int i = 0; i < indices_.size(); i++)
+		offsets[indices_[i] + 1]++;
+	for (int i = 0; i < vertexCount; i++)
+		offsets[i + 1] += offsets[i];
+	std::vector<int> faces(indices_.size());
+	std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+	for (int i = 0; i < indices_.size(); i++)
+		faces[cursor[indices_[i]]++] = i / 3;
+
+	pool.ParallelFor(0, vertexCount, REPAIR_GRAIN, [&](int begin_, int end_) {
+		for (int i = begin_; i < end_; i++) {
+			double n[3] = { 0.0, 0.0, 0.0 };
+			for (int j = offsets[i]; j < offsets[i + 1]; j++) {
+				const double* fn = faceNormals.data() + (size_t)faces[j] * 3;
+				n[0] += fn[0];
+				n[1] += fn[1];
+				n[2] += fn[2];
+			}
+			double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			double scale = length > 0.0 ? 1.0 / length : 0.0;
+			float* v = vertices_.data() + (size_t)i * stride_;
+			v[3] = (float)(n[0] * scale);
+			v[4] = (float)(n[1] * scale);
+			v[5] = (float)(n[2] * scale);
+		}
+	});
+}
+
+std::string DescribeMeshRepair(const MeshRepairReport & report_)
+{
+	std::ostringstream stream;
+	stream << report_.vertexCount << " vertices, " << report_.faceCount << " faces, "
+		<< report_.components << " components, "
+		<< (report_.checkPassed ? "check passed" : "check failed")
+		<< " (" << report_.checkErrors << " errors, " << report_.rejectedFaces
+		<< " faces rejected, " << report_.boundaryEdges << " boundary and "
+		<< report_.nonManifoldEdges << " non-manifold edges), merged "
+		<< report_.mergedVertices << " vertices, removed " << report_.degenerateFaces
+		<< " degenerate faces and " << report_.unusedVertices
+		<< " unused vertices, flipped " << report_.flippedFaces << " faces";
+	return stream.str();
+}
+
+bool RepairMesh(std::vector<float>& vertices_, int stride_,
+	std::vector<unsigned int>& indices_, MeshRepairReport & report_)
+{
+	report_ = MeshRepairReport();
+	indices_.resize(indices_.size() / 3 * 3);
+	Validate(vertices_, stride_, indices_, report_);
+
+	int vertexCount = (int)(vertices_.size() / stride_);
+	double bmin[3] = { 0.0, 0.0, 0.0 }, bmax[3] = { 0.0, 0.0, 0.0 };
+	for (int i = 0; i < vertexCount; i++) {
+		const float* p = Point(vertices_, stride_, i);
+		for (int k = 0; k < 3; k++) {
+			bmin[k] = i ? std::min(bmin[k], (double)p[k]) : p[k];
+			bmax[k] = i ? std::max(bmax[k], (double)p[k]) : p[k];
+		}
+	}
+	double diagonal = std::sqrt((bmax[0] - bmin[0]) * (bmax[0] - bmin[0]) +
+		(bmax[1] - bmin[1]) * (bmax[1] - bmin[1]) +
+		(bmax[2] - bmin[2]) * (bmax[2] - bmin[2]));
+	double center[3] = { (bmin[0] + bmax[0]) * 0.5, (bmin[1] + bmax[1]) * 0.5,
+		(bmin[2] + bmax[2]) * 0.5 };
+
+	std::vector<unsigned int> remap;
+	report_.mergedVertices = MergeVertices(vertices_, stride_,
+		MERGE_TOLERANCE * diagonal, remap);
+	report_.degenerateFaces = RemoveDegenerateFaces(vertices_, stride_, remap,
+		DEGENERATE_AREA * diagonal * diagonal, indices_);
+	std::vector<unsigned int>().swap(remap);
+	report_.flippedFaces = OrientFaces(vertices_, stride_, center, indices_, report_);
+	report_.unusedVertices = RemoveUnusedVertices(vertices_, stride_, indices_);
+
+	report_.vertexCount = (int)(vertices_.size() / stride_);
+	report_.faceCount = (int)(indices_.size() / 3);
+
+	bool changed = report_.mergedVertices || report_.degenerateFaces ||
+		report_.flippedFaces || report_.unusedVertices;
+	if (changed && stride_ >= 6)
+		UpdateNormals(vertices_, stride_, indices_);
+	return changed;
+}
+
+MeshRepair::MeshRepair()
+	: pending(0),
+	quit(false)
+{
+	//statics die in reverse order of construction, creating these first
+	//keeps them alive until the thread is joined
+	ThreadPool::Instance();
+	MeshCache::Instance();
+
+	thread = std::thread(&MeshRepair::Run, this);
+}
+
+MeshRepair::~MeshRepair()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+		jobs.clear();
+	}
+	jobCondition.notify_all();
+	thread.join();
+
+	for (int i = 0; i < results.size(); i++)
+		delete results[i];
+}
+
+MeshRepair & MeshRepair::Instance()
+{
+	static MeshRepair repair;
+	return repair;
+}
+
+void MeshRepair::Submit(const std::string & cacheKey_, const std::string & name_, int stride_)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (int i = 0; i < jobs.size(); i++) {
+			if (jobs[i].cacheKey == cacheKey_)
+				return;
+		}
+
+		Job job;
+		job.cacheKey = cacheKey_;
+		job.name = name_;
+		job.stride = stride_;
+		jobs.push_back(job);
+		pending++;
+	}
+	jobCondition.notify_one();
+}
+
+void MeshRepair::Collect(std::vector<MeshRepairResult*>& results_)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	results_.insert(results_.end(), results.begin(), results.end());
+	results.clear();
+}
+
+bool MeshRepair::IsIdle()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return pending == 0 && results.empty();
+}
+
+void MeshRepair::Wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	doneCondition.wait(lock, [this]() { return pending == 0; });
+}
+
+void MeshRepair::Run()
+{
+	MeshCache& cache = MeshCache::Instance();
+
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			jobCondition.wait(lock, [this]() { return quit || !jobs.empty(); });
+			if (quit)
+				return;
+			job = jobs.front();
+			jobs.pop_front();
+		}
+
+		//an entry that went missing has nothing to repair, the mesh is
+		//either still in memory or gets parsed again on the next load
+		MeshRepairResult* result = 0;
+		std::vector<float> vertices;
+		std::vector<unsigned int> indices;
+		if (cache.Load(job.cacheKey, vertices, indices)) {
+			result = new MeshRepairResult;
+			result->cacheKey = job.cacheKey;
+			result->name = job.name;
+			result->changed = RepairMesh(vertices, job.stride, indices, result->report);
+			result->stored = cache.Store(job.cacheKey, vertices, indices, MeshCache::REPAIRED);
+			if (result->changed) {
+				ComputeMeshStats(vertices, job.stride, indices, result->stats);
+				result->bvh.Build(vertices, job.stride, indices);
+				result->vertices.swap(vertices);
+				result->indices.swap(indices);
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (result)
+				results.push_back(result);
+			pending--;
+		}
+		doneCondition.notify_all();
+	}
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MeshBVH.h"
+#include "MeshStats.h"
+
+struct MeshRepairReport {
+	//after the repair
+	int vertexCount;
+	int faceCount;
+
+	//validation of the buffers as they came in. the half-edge mesh refuses
+	//faces around complex edges and vertices, MeshCheckerT then checks the
+	//connectivity of what is left.
+	bool checkPassed;
+	int checkErrors;
+	int rejectedFaces;
+	int boundaryEdges;
+	int nonManifoldEdges;
+	int components;
+
+	//what the repair changed
+	int mergedVertices;
+	int degenerateFaces;
+	int flippedFaces;
+	int unusedVertices;
+};
+
+//one line for the log
+std::string DescribeMeshRepair(const MeshRepairReport& report_);
+
+//validates the mesh, then merges coincident vertices, drops degenerate
+//faces and unused vertices and orients the faces of every connected
+//component consistently, outwards for closed ones. returns true if the
+//buffers changed, the normals at offset 3 are recomputed then when
+//stride_ is at least 6.
+bool RepairMesh(std::vector<float>& vertices_, int stride_,
+	std::vector<unsigned int>& indices_, MeshRepairReport& report_);
+
+struct MeshRepairResult {
+	std::string cacheKey;
+	std::string name;
+	MeshRepairReport report;
+	//false when the cache still holds the buffers from before
+	bool stored;
+
+	//buffers, stats and BVH are only filled when the repair changed
+	//something, so the render thread only has to swap them in
+	bool changed;
+	std::vector<float> vertices;
+	std::vector<unsigned int> indices;
+	MeshStats stats;
+	MeshBVH bvh;
+};
+
+//repairs meshes on a thread of its own, the passes inside fan out to the
+//ThreadPool. jobs read the MeshCache entry and write the result back
+//flagged REPAIRED, so a mesh is only repaired the first time it loads.
+class MeshRepair
+{
+private:
+	struct Job {
+		std::string cacheKey;
+		std::string name;
+		int stride;
+	};
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable jobCondition;
+	std::condition_variable doneCondition;
+	std::deque<Job> jobs;
+	std::vector<MeshRepairResult*> results;
+	int pending;
+	bool quit;
+
+public:
+	MeshRepair();
+	~MeshRepair();
+
+	static MeshRepair& Instance();
+
+	//queues the cache entry of cacheKey_, name_ is for the report
+	void Submit(const std::string& cacheKey_, const std::string& name_, int stride_);
+
+	//hands over the finished repairs, the caller deletes them
+	void Collect(std::vector<MeshRepairResult*>& results_);
+	//true when nothing is queued, running or waiting to be collected
+	bool IsIdle();
+	//blocks until every submitted job finished
+	void Wait();
+
+private:
+	void Run();
+};
@@ -0,0 +1,148 @@
+#include "MeshSmoother.h"
+
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+
+#include "ThreadPool.h"
+
+static const int SMOOTH_GRAIN = 8192;
+
+MeshSmoother::MeshSmoother()
+	: vertexCount(0),
+	current(0)
+{
+}
+
+void MeshSmoother::Build(const std::vector<float>& vertices_, int stride_,
+	const std::vector<unsigned int>& indices_)
+{
+	ThreadPool& pool = ThreadPool::Instance();
+	vertexCount = (int)(vertices_.size() / stride_);
+	indices = indices_;
+	int cornerCount = (int)indices.size();
+
+	//vertex to face table by counting sort
+	faceOffsets.assign(vertexCount + 1, 0);
+	for (int i = 0; i < cornerCount; i++)
+		faceOffsets[indices[i] + 1]++;
+	for (int i = 0; i < vertexCount; i++)
+		faceOffsets[i + 1] += faceOffsets[i];
+	faces.resize(cornerCount);
+	std::vector<int> cursor(faceOffsets.begin(), faceOffsets.end() - 1);
+	for (int i = 0; i < cornerCount; i++)
+		faces[cursor[indices[i]]++] = i / 3;
+
+	//every incident face gives two ring candidates, sorted and made
+	//unique in place. a vertex whose ring is not as long as its fan is on
+	//a boundary or a non-manifold edge.
+	std::vector<int> candidates((size_t)cornerCount * 2);
+	std::vector<int> ringSizes(vertexCount);
+	fixed.assign(vertexCount, 0);
+	pool.ParallelFor(0, vertexCount, SMOOTH_GRAIN, [&](int begin_, int end_) {
+		for (int v = begin_; v < end_; v++) {
+			int* ring = candidates.data() + (size_t)faceOffsets[v] * 2;
+			int count = 0;
+			for (int j = faceOffsets[v]; j < faceOffsets[v + 1]; j++) {
+				const unsigned int* face = indices.data() + (size_t)faces[j] * 3;
+				for (int k = 0; k < 3; k++) {
+					if (face[k] != (unsigned int)v)
+						ring[count++] = face[k];
+				}
+			}
+			std::sort(ring, ring + count);
+			ringSizes[v] = (int)(std::unique(ring, ring + count) - ring);
+			fixed[v] = ringSizes[v] != faceOffsets[v + 1] - faceOffsets[v];
+		}
+	});
+
+	ringOffsets.assign(vertexCount + 1, 0);
+	for (int v = 0; v < vertexCount; v++)
+		ringOffsets[v + 1] = ringOffsets[v] + ringSizes[v];
+	rings.resize(ringOffsets[vertexCount]);
+	pool.ParallelFor(0, vertexCount, SMOOTH_GRAIN, [&](int begin_, int end_) {
+		for (int v = begin_; v < end_; v++) {
+			std::copy(candidates.begin() + (size_t)faceOffsets[v] * 2,
+				candidates.begin() + (size_t)faceOffsets[v] * 2 + ringSizes[v],
+				rings.begin() + ringOffsets[v]);
+		}
+	});
+
+	current = 0;
+	positions[0].assign((size_t)vertexCount * 4, 0.0f);
+	positions[1].assign((size_t)vertexCount * 4, 0.0f);
+	pool.ParallelFor(0, vertexCount, SMOOTH_GRAIN, [&](int begin_, int end_) {
+		for (int v = begin_; v < end_; v++) {
+			const float* p = vertices_.data() + (size_t)v * stride_;
+			std::copy(p, p + 3, positions[0].begin() + (size_t)v * 4);
+		}
+	});
+}
+
+void MeshSmoother::Smooth(int iterations_, float lambda_)
+{
+	ThreadPool& pool = ThreadPool::Instance();
+	__m128 lambda = _mm_set1_ps(lambda_);
+
+	for (int it = 0; it < iterations_; it++) {
+		const float* src = positions[current].data();
+		float* dst = positions[1 - current].data();
+
+		pool.ParallelFor(0, vertexCount, SMOOTH_GRAIN, [&](int begin_, int end_) {
+			for (int v = begin_; v < end_; v++) {
+				__m128 p = _mm_loadu_ps(src + (size_t)v * 4);
+				int first = ringOffsets[v], last = ringOffsets[v + 1];
+				if (fixed[v] || first == last) {
+					_mm_storeu_ps(dst + (size_t)v * 4, p);
+					continue;
+				}
+
+				__m128 sum = _mm_setzero_ps();
+				for (int j = first; j < last; j++)
+					sum = _mm_add_ps(sum, _mm_loadu_ps(src + (size_t)rings[j] * 4));
+				__m128 mean = _mm_mul_ps(sum, _mm_set1_ps(1.0f / (last - first)));
+				p = _mm_add_ps(p, _mm_mul_ps(lambda, _mm_sub_ps(mean, p)));
+				_mm_storeu_ps(dst + (size_t)v * 4, p);
+			}
+		});
+
+		current = 1 - current;
+	}
+}
+
+void MeshSmoother::Write(std::vector<float>& vertices_, int stride_, int first_, int last_) const
+{
+	ThreadPool& pool = ThreadPool::Instance();
+	const float* src = positions[current].data();
+
+	//each vertex sums the cross products of its own fan, so no two
+	//threads write the same normal
+	pool.ParallelFor(first_, last_, SMOOTH_GRAIN, [&](int begin_, int end_) {
+		for (int v = begin_; v < end_; v++) {
+			float* out = vertices_.data() + (size_t)v * stride_;
+			out[0] = src[(size_t)v * 4];
+			out[1] = src[(size_t)v * 4 + 1];
+			out[2] = src[(size_t)v * 4 + 2];
+			if (stride_ < 6)
+				continue;
+
+			double n[3] = { 0.0, 0.0, 0.0 };
+			for (int j = faceOffsets[v]; j < faceOffsets[v + 1]; j++) {
+				const unsigned int* face = indices.data() + (size_t)faces[j] * 3;
+				const float* a = src + (size_t)face[0] * 4;
+				const float* b = src + (size_t)face[1] * 4;
+				const float* c = src + (size_t)face[2] * 4;
+				double u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+				double w[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+				n[0] += u[1] * w[2] - u[2] * w[1];
+				n[1] += u[2] * w[0] - u[0] * w[2];
+				n[2] += u[0] * w[1] - u[1] * w[0];
+			}
+			double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			double scale = length > 0.0 ? 1.0 / length : 0.0;
+			out[3] = (float)(n[0] * scale);
+			out[4] = (float)(n[1] * scale);
+			out[5] = (float)(n[2] * scale);
+		}
+	});
+}
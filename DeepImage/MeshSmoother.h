@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+//uniform Laplacian smoothing, the update of OpenMesh's
+//JacobiLaplaceSmootherT: every iteration moves each vertex by lambda_
+//towards the mean of its one-ring, reading the positions of the previous
+//iteration only. the rings are a CSR snapshot of the triangles, so an
+//iteration is a parallel pass over flat arrays with SSE per vertex.
+//boundary and non-manifold vertices stay in place.
+class MeshSmoother
+{
+private:
+	int vertexCount;
+
+	//one-ring and incident faces of every vertex
+	std::vector<int> ringOffsets, rings;
+	std::vector<int> faceOffsets, faces;
+	std::vector<unsigned char> fixed;
+	std::vector<unsigned int> indices;
+
+	//xyz0 per vertex, iterations ping-pong between the two
+	std::vector<float> positions[2];
+	int current;
+
+public:
+	MeshSmoother();
+
+	//vertices_ holds xyz at the start of every stride_ floats
+	void Build(const std::vector<float>& vertices_, int stride_,
+		const std::vector<unsigned int>& indices_);
+
+	void Smooth(int iterations_, float lambda_);
+
+	//positions and area weighted normals of vertices [first_, last_) into
+	//vertices_, the normals at offset 3
+	void Write(std::vector<float>& vertices_, int stride_, int first_, int last_) const;
+
+	inline int GetVertexCount() const { return vertexCount; }
+};
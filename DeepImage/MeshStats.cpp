@@ -0,0 +1,324 @@
+#include "MeshStats.h"
+
+#include <cfloat>
+#include <cmath>
+#include <emmintrin.h>
+
+#include "ThreadPool.h"
+
+static const int VERTEX_GRAIN = 16384;
+static const int TRIANGLE_GRAIN = 8192;
+static const int JACOBI_SWEEPS = 32;
+
+struct VertexPartial {
+	double sum[4];
+	float bmin[4], bmax[4];
+};
+
+struct TrianglePartial {
+	double area;
+	double areaSum[4];
+	double volume;
+	double volumeSum[4];
+};
+
+struct MomentPartial {
+	double diagonal[4];
+	double offDiagonal[4];
+};
+
+struct ExtentPartial {
+	float pmin[4], pmax[4];
+};
+
+//xyz of vertex i_, w cleared
+static inline __m128 LoadPoint(const float* vertices_, int stride_, int i_, __m128 mask_)
+{
+	return _mm_and_ps(_mm_loadu_ps(vertices_ + (size_t)i_ * stride_), mask_);
+}
+
+//widens the four lanes of v_ into the double accumulators
+static inline void Accumulate(__m128 v_, __m128d& xy_, __m128d& zw_)
+{
+	xy_ = _mm_add_pd(xy_, _mm_cvtps_pd(v_));
+	zw_ = _mm_add_pd(zw_, _mm_cvtps_pd(_mm_movehl_ps(v_, v_)));
+}
+
+static inline __m128 YZX(__m128 v_)
+{
+	return _mm_shuffle_ps(v_, v_, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+static inline __m128 Cross(__m128 a_, __m128 b_)
+{
+	return YZX(_mm_sub_ps(_mm_mul_ps(a_, YZX(b_)), _mm_mul_ps(YZX(a_), b_)));
+}
+
+static inline float Dot(__m128 a_, __m128 b_)
+{
+	__m128 m = _mm_mul_ps(a_, b_);
+	__m128 s = _mm_add_ps(m, _mm_movehl_ps(m, m));
+	s = _mm_add_ss(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1)));
+	return _mm_cvtss_f32(s);
+}
+
+//eigen decomposition of the symmetric a_, cyclic Jacobi rotations. the
+//columns of v_ are the eigenvectors of eigen_.
+static void Jacobi(double a_[3][3], double v_[3][3], double eigen_[3])
+{
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			v_[i][j] = i == j ? 1.0 : 0.0;
+
+	for (int sweep = 0; sweep < JACOBI_SWEEPS; sweep++) {
+		double off = a_[0][1] * a_[0][1] + a_[0][2] * a_[0][2] + a_[1][2] * a_[1][2];
+		double diagonal = a_[0][0] * a_[0][0] + a_[1][1] * a_[1][1] + a_[2][2] * a_[2][2];
+		if (off <= 1e-24 * diagonal || off == 0.0)
+			break;
+
+		for (int p = 0; p < 2; p++) {
+			for (int q = p + 1; q < 3; q++) {
+				if (a_[p][q] == 0.0)
+					continue;
+
+				double theta = (a_[q][q] - a_[p][p]) / (2.0 * a_[p][q]);
+				double t = (theta >= 0.0 ? 1.0 : -1.0) /
+					(fabs(theta) + sqrt(theta * theta + 1.0));
+				double c = 1.0 / sqrt(t * t + 1.0);
+				double s = t * c;
+
+				for (int k = 0; k < 3; k++) {
+					double kp = a_[k][p], kq = a_[k][q];
+					a_[k][p] = c * kp - s * kq;
+					a_[k][q] = s * kp + c * kq;
+				}
+				for (int k = 0; k < 3; k++) {
+					double pk = a_[p][k], qk = a_[q][k];
+					a_[p][k] = c * pk - s * qk;
+					a_[q][k] = s * pk + c * qk;
+				}
+				for (int k = 0; k < 3; k++) {
+					double kp = v_[k][p], kq = v_[k][q];
+					v_[k][p] = c * kp - s * kq;
+					v_[k][q] = s * kp + c * kq;
+				}
+			}
+		}
+	}
+
+	for (int i = 0; i < 3; i++)
+		eigen_[i] = a_[i][i];
+}
+
+void ComputeMeshStats(const std::vector<float>& vertices_, int stride_,
+	const std::vector<unsigned int>& indices_, MeshStats& stats_)
+{
+	ThreadPool& pool = ThreadPool::Instance();
+	const float* data = vertices_.data();
+	int vertexCount = (int)(vertices_.size() / stride_);
+	int triangleCount = (int)(indices_.size() / 3);
+	__m128 mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+
+	for (int k = 0; k < 3; k++) {
+		stats_.vertexCentroid[k] = stats_.areaCentroid[k] = stats_.volumeCentroid[k] = 0.0f;
+		stats_.aabbMin[k] = stats_.aabbMax[k] = 0.0f;
+		stats_.obbCenter[k] = stats_.obbHalfExtents[k] = 0.0f;
+		for (int j = 0; j < 3; j++)
+			stats_.obbAxes[k][j] = k == j ? 1.0f : 0.0f;
+	}
+	stats_.area = stats_.volume = 0.0f;
+	if (vertexCount == 0)
+		return;
+
+	//centroid and bounds of the vertices
+	std::vector<VertexPartial> vertexPartials((vertexCount + VERTEX_GRAIN - 1) / VERTEX_GRAIN);
+	pool.ParallelFor(0, vertexCount, VERTEX_GRAIN, [&](int begin_, int end_) {
+		__m128d xy = _mm_setzero_pd(), zw = _mm_setzero_pd();
+		__m128 bmin = _mm_set1_ps(FLT_MAX), bmax = _mm_set1_ps(-FLT_MAX);
+		for (int i = begin_; i < end_; i++) {
+			__m128 p = LoadPoint(data, stride_, i, mask);
+			Accumulate(p, xy, zw);
+			bmin = _mm_min_ps(bmin, p);
+			bmax = _mm_max_ps(bmax, p);
+		}
+
+		VertexPartial& partial = vertexPartials[begin_ / VERTEX_GRAIN];
+		_mm_storeu_pd(partial.sum, xy);
+		_mm_storeu_pd(partial.sum + 2, zw);
+		_mm_storeu_ps(partial.bmin, bmin);
+		_mm_storeu_ps(partial.bmax, bmax);
+	});
+
+	double sum[3] = { 0.0, 0.0, 0.0 };
+	for (int k = 0; k < 3; k++) {
+		stats_.aabbMin[k] = FLT_MAX;
+		stats_.aabbMax[k] = -FLT_MAX;
+	}
+	for (int c = 0; c < vertexPartials.size(); c++) {
+		for (int k = 0; k < 3; k++) {
+			sum[k] += vertexPartials[c].sum[k];
+			stats_.aabbMin[k] = fminf(stats_.aabbMin[k], vertexPartials[c].bmin[k]);
+			stats_.aabbMax[k] = fmaxf(stats_.aabbMax[k], vertexPartials[c].bmax[k]);
+		}
+	}
+	for (int k = 0; k < 3; k++)
+		stats_.vertexCentroid[k] = (float)(sum[k] / vertexCount);
+
+	//area and volume weighted centroids. positions are taken relative to
+	//the first vertex, so the tetrahedra stay small far from the origin
+	__m128 origin = LoadPoint(data, stride_, 0, mask);
+	std::vector<TrianglePartial> trianglePartials(
+		(triangleCount + TRIANGLE_GRAIN - 1) / TRIANGLE_GRAIN);
+	pool.ParallelFor(0, triangleCount, TRIANGLE_GRAIN, [&](int begin_, int end_) {
+		double area = 0.0, volume = 0.0;
+		__m128d areaXY = _mm_setzero_pd(), areaZW = _mm_setzero_pd();
+		__m128d volumeXY = _mm_setzero_pd(), volumeZW = _mm_setzero_pd();
+		for (int t = begin_; t < end_; t++) {
+			__m128 a = _mm_sub_ps(LoadPoint(data, stride_, indices_[t * 3], mask), origin);
+			__m128 b = _mm_sub_ps(LoadPoint(data, stride_, indices_[t * 3 + 1], mask), origin);
+			__m128 c = _mm_sub_ps(LoadPoint(data, stride_, indices_[t * 3 + 2], mask), origin);
+			__m128 s = _mm_add_ps(_mm_add_ps(a, b), c);
+
+			//twice the area and six times the signed volume with the origin
+			__m128 n = Cross(_mm_sub_ps(b, a), _mm_sub_ps(c, a));
+			float area2 = sqrtf(Dot(n, n));
+			float volume6 = Dot(a, Cross(b, c));
+
+			area += area2;
+			volume += volume6;
+			Accumulate(_mm_mul_ps(s, _mm_set1_ps(area2)), areaXY, areaZW);
+			Accumulate(_mm_mul_ps(s, _mm_set1_ps(volume6)), volumeXY, volumeZW);
+		}
+
+		TrianglePartial& partial = trianglePartials[begin_ / TRIANGLE_GRAIN];
+		partial.area = area;
+		partial.volume = volume;
+		_mm_storeu_pd(partial.areaSum, areaXY);
+		_mm_storeu_pd(partial.areaSum + 2, areaZW);
+		_mm_storeu_pd(partial.volumeSum, volumeXY);
+		_mm_storeu_pd(partial.volumeSum + 2, volumeZW);
+	});
+
+	double area2 = 0.0, volume6 = 0.0;
+	double areaSum[3] = { 0.0, 0.0, 0.0 }, volumeSum[3] = { 0.0, 0.0, 0.0 };
+	for (int c = 0; c < trianglePartials.size(); c++) {
+		area2 += trianglePartials[c].area;
+		volume6 += trianglePartials[c].volume;
+		for (int k = 0; k < 3; k++) {
+			areaSum[k] += trianglePartials[c].areaSum[k];
+			volumeSum[k] += trianglePartials[c].volumeSum[k];
+		}
+	}
+
+	float base[4];
+	_mm_storeu_ps(base, origin);
+	double diagonal = 0.0;
+	for (int k = 0; k < 3; k++)
+		diagonal += (double)(stats_.aabbMax[k] - stats_.aabbMin[k]) *
+		(stats_.aabbMax[k] - stats_.aabbMin[k]);
+
+	stats_.area = (float)(area2 * 0.5);
+	stats_.volume = (float)(volume6 / 6.0);
+	for (int k = 0; k < 3; k++) {
+		//a triangle contributes area * (a + b + c) / 3, a tetrahedron
+		//volume * (a + b + c) / 4
+		stats_.areaCentroid[k] = area2 > 0.0 ?
+			(float)(base[k] + areaSum[k] / (3.0 * area2)) : stats_.vertexCentroid[k];
+		stats_.volumeCentroid[k] = fabs(volume6) > 1e-9 * diagonal * sqrt(diagonal) ?
+			(float)(base[k] + volumeSum[k] / (4.0 * volume6)) : stats_.areaCentroid[k];
+	}
+
+	//covariance of the vertices around their centroid
+	__m128 centroid = _mm_setr_ps(stats_.vertexCentroid[0], stats_.vertexCentroid[1],
+		stats_.vertexCentroid[2], 0.0f);
+	std::vector<MomentPartial> momentPartials(vertexPartials.size());
+	pool.ParallelFor(0, vertexCount, VERTEX_GRAIN, [&](int begin_, int end_) {
+		__m128d diagonalXY = _mm_setzero_pd(), diagonalZW = _mm_setzero_pd();
+		__m128d offXY = _mm_setzero_pd(), offZW = _mm_setzero_pd();
+		for (int i = begin_; i < end_; i++) {
+			__m128 d = _mm_sub_ps(LoadPoint(data, stride_, i, mask), centroid);
+			//xx yy zz and xy yz zx
+			Accumulate(_mm_mul_ps(d, d), diagonalXY, diagonalZW);
+			Accumulate(_mm_mul_ps(d, YZX(d)), offXY, offZW);
+		}
+
+		MomentPartial& partial = momentPartials[begin_ / VERTEX_GRAIN];
+		_mm_storeu_pd(partial.diagonal, diagonalXY);
+		_mm_storeu_pd(partial.diagonal + 2, diagonalZW);
+		_mm_storeu_pd(partial.offDiagonal, offXY);
+		_mm_storeu_pd(partial.offDiagonal + 2, offZW);
+	});
+
+	double covariance[3][3] = { { 0.0 } };
+	for (int c = 0; c < momentPartials.size(); c++) {
+		const MomentPartial& partial = momentPartials[c];
+		for (int k = 0; k < 3; k++)
+			covariance[k][k] += partial.diagonal[k];
+		covariance[0][1] += partial.offDiagonal[0];
+		covariance[1][2] += partial.offDiagonal[1];
+		covariance[0][2] += partial.offDiagonal[2];
+	}
+	covariance[1][0] = covariance[0][1];
+	covariance[2][1] = covariance[1][2];
+	covariance[2][0] = covariance[0][2];
+
+	double vectors[3][3], eigen[3];
+	Jacobi(covariance, vectors, eigen);
+
+	int order[3] = { 0, 1, 2 };
+	for (int i = 0; i < 2; i++)
+		for (int j = i + 1; j < 3; j++)
+			if (eigen[order[j]] > eigen[order[i]]) {
+				int swap = order[i];
+				order[i] = order[j];
+				order[j] = swap;
+			}
+	for (int a = 0; a < 2; a++)
+		for (int k = 0; k < 3; k++)
+			stats_.obbAxes[a][k] = (float)vectors[k][order[a]];
+	float* x = stats_.obbAxes[0];
+	float* y = stats_.obbAxes[1];
+	stats_.obbAxes[2][0] = x[1] * y[2] - x[2] * y[1];
+	stats_.obbAxes[2][1] = x[2] * y[0] - x[0] * y[2];
+	stats_.obbAxes[2][2] = x[0] * y[1] - x[1] * y[0];
+
+	//extents along the axes. the rows hold the k-th component of every
+	//axis, so one multiply-add per component projects onto all three
+	__m128 rows[3];
+	for (int k = 0; k < 3; k++)
+		rows[k] = _mm_setr_ps(stats_.obbAxes[0][k], stats_.obbAxes[1][k],
+			stats_.obbAxes[2][k], 0.0f);
+	std::vector<ExtentPartial> extentPartials(vertexPartials.size());
+	pool.ParallelFor(0, vertexCount, VERTEX_GRAIN, [&](int begin_, int end_) {
+		__m128 pmin = _mm_set1_ps(FLT_MAX), pmax = _mm_set1_ps(-FLT_MAX);
+		for (int i = begin_; i < end_; i++) {
+			__m128 d = _mm_sub_ps(LoadPoint(data, stride_, i, mask), centroid);
+			__m128 p = _mm_mul_ps(_mm_shuffle_ps(d, d, _MM_SHUFFLE(0, 0, 0, 0)), rows[0]);
+			p = _mm_add_ps(p, _mm_mul_ps(_mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 1, 1, 1)), rows[1]));
+			p = _mm_add_ps(p, _mm_mul_ps(_mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 2, 2, 2)), rows[2]));
+			pmin = _mm_min_ps(pmin, p);
+			pmax = _mm_max_ps(pmax, p);
+		}
+
+		ExtentPartial& partial = extentPartials[begin_ / VERTEX_GRAIN];
+		_mm_storeu_ps(partial.pmin, pmin);
+		_mm_storeu_ps(partial.pmax, pmax);
+	});
+
+	float pmin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float pmax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (int c = 0; c < extentPartials.size(); c++) {
+		for (int a = 0; a < 3; a++) {
+			pmin[a] = fminf(pmin[a], extentPartials[c].pmin[a]);
+			pmax[a] = fmaxf(pmax[a], extentPartials[c].pmax[a]);
+		}
+	}
+	for (int k = 0; k < 3; k++)
+		stats_.obbCenter[k] = stats_.vertexCentroid[k];
+	for (int a = 0; a < 3; a++) {
+		float middle = (pmin[a] + pmax[a]) * 0.5f;
+		stats_.obbHalfExtents[a] = (pmax[a] - pmin[a]) * 0.5f;
+		for (int k = 0; k < 3; k++)
+			stats_.obbCenter[k] += stats_.obbAxes[a][k] * middle;
+	}
+}
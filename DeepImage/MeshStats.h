@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+
+//model space statistics of a triangle mesh, computed once at load
+struct MeshStats {
+	float vertexCentroid[3];
+	float areaCentroid[3];
+	//centre of the enclosed volume, falls back to the area centroid when
+	//the mesh encloses none. volume is signed by the winding.
+	float volumeCentroid[3];
+	float area;
+	float volume;
+
+	float aabbMin[3], aabbMax[3];
+
+	//box along the principal axes of the vertex covariance, the axes are
+	//orthonormal, sorted by decreasing variance and right handed
+	float obbCenter[3];
+	float obbAxes[3][3];
+	float obbHalfExtents[3];
+};
+
+//vertices_ holds xyz at the start of every stride_ floats, stride_ of at
+//least 4. vertex and triangle ranges are reduced in parallel on the
+//ThreadPool with SSE, partial sums are kept in double.
+void ComputeMeshStats(const std::vector<float>& vertices_, int stride_,
+	const std::vector<unsigned int>& indices_, MeshStats& stats_);
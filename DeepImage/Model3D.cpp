@@ -1,28 +1,151 @@
 #include "Model3D.h"
 
+#include <QOpenGLFunctions_4_5_Core>
+#include <atomic>
+#include <iostream>
+
+#include "MeshCache.h"
+#include "MeshRepair.h"
+#include "ResourceTracker.h"
+#include "ThreadPool.h"
+#include "TriMesh.h"
+
+struct Model3D::CacheRead {
+	std::vector<float> vertices;
+	std::vector<unsigned int> indices;
+	bool ok;
+	//set by the task once ok and the buffers are final
+	std::atomic<bool> done;
+};
+
 Model3D::Model3D()
 	: vao(0),
 	vbo(0),
 	ibo(0),
-	color(0, 0, 0, 1),
-	scaleVec(1, 1, 1)
+	cached(false),
+	edited(false),
+	gpuBytes(0),
+	owner(ResourceTracker::SHARED_OWNER),
+	copyOwner(-1),
+	bvhOwner(-1),
+	copyBytes(0),
+	bvhBytes(0)
 {
 }
 
 Model3D::~Model3D()
 {
-	delete vao;
-	delete vbo;
-	delete ibo;
+	Evict();
+
+	ResourceTracker& tracker = ResourceTracker::Instance();
+	if (copyOwner >= 0)
+		tracker.Free(ResourceTracker::MESH_COPY, copyOwner, copyBytes);
+	if (bvhOwner >= 0)
+		tracker.Free(ResourceTracker::MESH_BVH, bvhOwner, bvhBytes);
+	tracker.RemoveOwner(owner);
 }
 
 void Model3D::Init()
 {
-	std::vector<float> vertices;
-	std::vector<unsigned int> indices;
-	mesh.GetVertices(vertices, true, false);
-	mesh.GetIndices(indices);
+	ResourceScope scope(owner);
+
+	ComputeMeshStats(vertices, VERTEX_STRIDE, indices, stats);
+	UpdateBounds();
+
+	bvh.Build(vertices, VERTEX_STRIDE, indices);
+	TrackBVH();
+
+	Upload();
+}
+
+void Model3D::Draw(bool patches_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	if (!vao)
+		return;
+
+	vao->Bind();
+	ibo->Bind();
+	if (patches_) {
+		f->glPatchParameteri(GL_PATCH_VERTICES, 3);
+		f->glDrawElements(GL_PATCHES, ibo->GetCount(), GL_UNSIGNED_INT, 0);
+	}
+	else
+		f->glDrawElements(GL_TRIANGLES, ibo->GetCount(), GL_UNSIGNED_INT, 0);
+}
+
+bool Model3D::Load(const std::string & filePath_)
+{
+	ResourceTracker& tracker = ResourceTracker::Instance();
+	tracker.RemoveOwner(owner);
+	owner = tracker.AddOwner(filePath_.substr(filePath_.find_last_of("/\\") + 1));
+	ResourceScope scope(owner);
+
+	MeshCache& cache = MeshCache::Instance();
+	cacheKey = cache.MakeKey(filePath_);
+	unsigned int flags = 0;
+	cached = cache.Load(cacheKey, vertices, indices, &flags);
+	if (!cached) {
+		TriMesh mesh;
+		if (!mesh.Read(filePath_))
+			return false;
+		if (mesh.n_faces() == 0) {
+			std::cerr << "File Open Error: no faces in " << filePath_ << std::endl;
+			return false;
+		}
+		mesh.GetVertices(vertices, true, false);
+		mesh.GetIndices(indices);
+		cached = cache.Store(cacheKey, vertices, indices);
+	}
+
+	TrackCpuCopy();
+
+	if (cached && !(flags & MeshCache::REPAIRED))
+		MeshRepair::Instance().Submit(cacheKey,
+			filePath_.substr(filePath_.find_last_of("/\\") + 1), VERTEX_STRIDE);
+	return true;
+}
+
+void Model3D::ApplyRepair(MeshRepairResult & result_)
+{
+	if (edited)
+		return;
+
+	//the entry may be gone when the store failed, keep what is in memory
+	if (!result_.stored && HasCpuCopy())
+		cached = false;
+	if (!result_.changed)
+		return;
+
+	ResourceScope scope(owner);
+	bool resident = IsResident();
+	Evict();
 
+	vertices.swap(result_.vertices);
+	indices.swap(result_.indices);
+	cached = result_.stored;
+	TrackCpuCopy();
+
+	stats = result_.stats;
+	UpdateBounds();
+	bvh = std::move(result_.bvh);
+	TrackBVH();
+
+	if (resident)
+		Upload();
+}
+
+bool Model3D::Upload()
+{
+	if (vao)
+		return true;
+
+	if (vertices.empty())
+		return false;
+
+	ResourceScope scope(owner);
 	vao = new VAO;
 	vbo = new VBO(vertices.data(), vertices.size() * sizeof(float));
 	VBOLayout layout;
@@ -31,46 +154,161 @@ void Model3D::Init()
 	vao->AddBuffer(*vbo, layout);
 
 	ibo = new IBO(indices.data(), indices.size());
+
+	gpuBytes = vertices.size() * sizeof(float) + indices.size() * sizeof(unsigned int);
+	return true;
 }
 
-void Model3D::Draw()
+void Model3D::Evict()
 {
-	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
-		versionFunctions<QOpenGLFunctions_4_5_Core>();
+	delete vao;
+	delete vbo;
+	delete ibo;
+	vao = 0;
+	vbo = 0;
+	ibo = 0;
+	gpuBytes = 0;
+}
 
-	vao->Bind();
-	ibo->Bind();
-	f->glDrawElements(GL_TRIANGLES, ibo->GetCount(), GL_UNSIGNED_INT, 0);
+bool Model3D::ReleaseCpuCopy()
+{
+	if (!cached)
+		return false;
+
+	std::vector<float>().swap(vertices);
+	std::vector<unsigned int>().swap(indices);
+	TrackCpuCopy();
+	return true;
 }
 
-void Model3D::Load(const std::string & filePath_)
+bool Model3D::FetchCpuCopy()
 {
-	mesh.Read(filePath_);
+	if (HasCpuCopy()) {
+		//an edit or a repair filled the copy meanwhile, the read is stale
+		cacheRead.reset();
+		return true;
+	}
+	if (!cached)
+		return false;
+
+	//the task owns its share of the read, the model may be gone by the
+	//time it runs
+	if (!cacheRead) {
+		std::shared_ptr<CacheRead> read = std::make_shared<CacheRead>();
+		read->ok = false;
+		read->done = false;
+		std::string key = cacheKey;
+		ThreadPool::Instance().Submit([read, key]() {
+			read->ok = MeshCache::Instance().Load(key, read->vertices, read->indices);
+			read->done = true;
+		});
+		cacheRead = read;
+		return false;
+	}
+	if (!cacheRead->done)
+		return false;
+
+	bool ok = cacheRead->ok;
+	if (ok) {
+		vertices.swap(cacheRead->vertices);
+		indices.swap(cacheRead->indices);
+		TrackCpuCopy();
+	}
+	else {
+		//the entry is gone, there is nothing left to read back
+		std::cerr << "Mesh Cache Error: cannot read back " << cacheKey << std::endl;
+		cached = false;
+	}
+	cacheRead.reset();
+	return ok;
 }
 
-QMatrix4x4 Model3D::ModelMatrix()
+bool Model3D::BeginEdit()
 {
-	QMatrix4x4 scaleMatrix;
-	scaleMatrix.scale(scaleVec);
-	const double* dm = frame.worldMatrix();
-	QMatrix4x4 modelMatrix;
-	for (int i = 0; i < 16; i++)
-		modelMatrix.data()[i] = dm[i];
-	return modelMatrix * scaleMatrix;
+	if (!FetchCpuCopy())
+		return false;
+
+	cached = false;
+	edited = true;
+	return true;
 }
 
-qglviewer::Vec Model3D::CenterOfMass()
+void Model3D::UploadVertices(int first_, int count_)
 {
-	TriMesh::Point com(0, 0, 0);
-	for (TriMesh::VertexIter vit = mesh.vertices_begin();
-		vit != mesh.vertices_end();
-		vit++) {
-		com += mesh.point(*vit);
-	}
-	com /= mesh.n_vertices();
-	QVector3D scaled = QVector3D(com[0], com[1], com[2]) * scaleVec;
-	return frame.inverseCoordinatesOf(
-		qglviewer::Vec(scaled[0], scaled[1], scaled[2]));
+	if (!vbo || count_ <= 0)
+		return;
+
+	unsigned int vertexBytes = VERTEX_STRIDE * sizeof(float);
+	vbo->SetSubData(first_ * vertexBytes, vertices.data() + (size_t)first_ * VERTEX_STRIDE,
+		count_ * vertexBytes);
 }
 
+void Model3D::EndEdit()
+{
+	ResourceScope scope(owner);
 
+	ComputeMeshStats(vertices, VERTEX_STRIDE, indices, stats);
+	UpdateBounds();
+
+	bvh.Build(vertices, VERTEX_STRIDE, indices);
+	TrackBVH();
+}
+
+void Model3D::EndEdit(MeshStats & stats_, MeshBVH & bvh_)
+{
+	ResourceScope scope(owner);
+
+	stats = stats_;
+	UpdateBounds();
+
+	bvh = std::move(bvh_);
+	TrackBVH();
+}
+
+void Model3D::Replace(std::vector<float>& vertices_, std::vector<unsigned int>& indices_)
+{
+	ResourceScope scope(owner);
+	bool resident = IsResident();
+	Evict();
+
+	vertices.swap(vertices_);
+	indices.swap(indices_);
+	cached = false;
+	edited = true;
+	TrackCpuCopy();
+	EndEdit();
+
+	if (resident)
+		Upload();
+}
+
+void Model3D::UpdateBounds()
+{
+	bboxMin = QVector3D(stats.aabbMin[0], stats.aabbMin[1], stats.aabbMin[2]);
+	bboxMax = QVector3D(stats.aabbMax[0], stats.aabbMax[1], stats.aabbMax[2]);
+	centroid = QVector3D(stats.vertexCentroid[0], stats.vertexCentroid[1],
+		stats.vertexCentroid[2]);
+}
+
+void Model3D::TrackCpuCopy()
+{
+	ResourceTracker& tracker = ResourceTracker::Instance();
+	if (copyOwner >= 0)
+		tracker.Free(ResourceTracker::MESH_COPY, copyOwner, copyBytes);
+
+	copyOwner = -1;
+	copyBytes = GetCpuBytes();
+	if (copyBytes) {
+		ResourceScope scope(owner);
+		copyOwner = tracker.Allocate(ResourceTracker::MESH_COPY, copyBytes);
+	}
+}
+
+void Model3D::TrackBVH()
+{
+	ResourceTracker& tracker = ResourceTracker::Instance();
+	if (bvhOwner >= 0)
+		tracker.Free(ResourceTracker::MESH_BVH, bvhOwner, bvhBytes);
+	bvhBytes = bvh.GetMemoryBytes();
+	bvhOwner = tracker.Allocate(ResourceTracker::MESH_BVH, bvhBytes);
+}
@@ -1,41 +1,121 @@
 #pragma once
 
-#include <QVector4D>
+#include <memory>
+#include <string>
+#include <vector>
 #include <QVector3D>
-#include <QMatrix4x4>
-#include <QGLViewer/frame.h>
 
 #include "VAO.h"
 #include "VBO.h"
 #include "IBO.h"
-#include "TriMesh.h"
+#include "MeshBVH.h"
+#include "MeshStats.h"
 
+struct MeshRepairResult;
+
+//mesh resource: GPU buffers, bounds and BVH. placement and color of the
+//models that show it live in the SceneStore
 class Model3D
 {
+public:
+	//floats per vertex in the CPU copy and the VBO, position and normal
+	static const int VERTEX_STRIDE = 6;
+
 private:
 	VAO* vao;
 	VBO* vbo;
 	IBO* ibo;
 
-	TriMesh mesh;
-	qglviewer::Frame frame;
-	QVector3D scaleVec;
+	//interleaved position and normal, the CPU copy the buffers are made of
+	std::vector<float> vertices;
+	std::vector<unsigned int> indices;
+	std::string cacheKey;
+	bool cached;
+	//cache entry being read back on the ThreadPool, empty when none
+	struct CacheRead;
+	std::shared_ptr<CacheRead> cacheRead;
+	//moved by a tool since the load, repairs no longer apply
+	bool edited;
+	size_t gpuBytes;
+
+	//ResourceTracker owner of everything allocated for this mesh, and the
+	//charges of the CPU side data, -1 while not charged
+	int owner;
+	int copyOwner, bvhOwner;
+	size_t copyBytes, bvhBytes;
 
-	QVector4D color;
+	QVector3D bboxMin, bboxMax;
+	QVector3D centroid;
+	MeshStats stats;
+	MeshBVH bvh;
 	
 public:
 	Model3D();
 	~Model3D();
 
 	void Init();
-	void Draw();
+	//patches_ draws every triangle as a three vertex patch for the
+	//tessellation stages, the buffers are the same
+	void Draw(bool patches_ = false);
 
-	void Load(const std::string& filePath_);
-	QMatrix4x4 ModelMatrix();
+	//reads the mesh cache entry of filePath_, or parses the file and fills
+	//the cache. the half-edge mesh only lives during the call. an entry
+	//that was never repaired is handed to the MeshRepair thread. returns
+	//false when the file cannot be read or has no faces.
+	bool Load(const std::string& filePath_);
+	//swaps in the repaired buffers, stats and BVH and uploads again if
+	//the mesh was resident, so the GL context has to be current. they are
+	//moved out of result_, not copied.
+	void ApplyRepair(MeshRepairResult& result_);
 
-	qglviewer::Vec CenterOfMass();
+	//GPU residency, driven by the ResidencyManager. Upload needs the CPU
+	//copy and fails without it.
+	bool Upload();
+	void Evict();
+	//returns false when the copy is needed because the cache has no entry
+	bool ReleaseCpuCopy();
+	//brings a released copy back without blocking: the first call starts
+	//reading the cache entry on the ThreadPool, a later one takes the
+	//buffers once they are read. true when the copy is in memory.
+	bool FetchCpuCopy();
 
-	inline void SetColor(QVector4D color_) { color = color_; }
-	inline QVector4D GetColor() const { return color; }
-	inline qglviewer::Frame& GetFrame() { return frame; }
+	//for tools that move vertices through GetVertices. a released copy is
+	//read back like FetchCpuCopy does, false until it is in memory and for
+	//good once IsFetchingCpuCopy is false too. the edited copy no longer
+	//matches the cache, so it is never released again.
+	bool BeginEdit();
+	//uploads vertices [first_, first_ + count_) of the copy when resident
+	void UploadVertices(int first_, int count_);
+	//stats, bounds and BVH of the edited vertices
+	void EndEdit();
+	//the same with stats_ and bvh_ already built from the edited vertices,
+	//e.g. on the ThreadPool. they are moved out of the arguments.
+	void EndEdit(MeshStats& stats_, MeshBVH& bvh_);
+	//swaps in generated buffers, e.g. a subdivided mesh, and uploads again
+	//if resident. like an edit it no longer matches the cache.
+	void Replace(std::vector<float>& vertices_, std::vector<unsigned int>& indices_);
+
+	inline bool IsResident() const { return vao != 0; }
+	inline bool HasCpuCopy() const { return !vertices.empty(); }
+	inline bool IsFetchingCpuCopy() const { return (bool)cacheRead; }
+	inline std::vector<float>& GetVertices() { return vertices; }
+	inline const std::vector<unsigned int>& GetIndices() const { return indices; }
+	inline int GetVertexCount() const { return (int)(vertices.size() / VERTEX_STRIDE); }
+	inline size_t GetCpuBytes() const {
+		return vertices.size() * sizeof(float) + indices.size() * sizeof(unsigned int);
+	}
+	inline size_t GetGpuBytes() const { return gpuBytes; }
+
+	inline QVector3D GetBBoxMin() const { return bboxMin; }
+	inline QVector3D GetBBoxMax() const { return bboxMax; }
+	inline QVector3D GetCentroid() const { return centroid; }
+	inline const MeshStats& GetStats() const { return stats; }
+	inline const MeshBVH& GetBVH() const { return bvh; }
+	inline int GetOwner() const { return owner; }
+	inline const std::string& GetCacheKey() const { return cacheKey; }
+
+private:
+	void UpdateBounds();
+	void TrackCpuCopy();
+	void TrackBVH();
 };
\ No newline at end of file
@@ -1,52 +1,257 @@
 #include "ModelManager.h"
 
-static const int MODELS_OFFSET = 100;
+#include <QElapsedTimer>
+#include <memory>
 
-void ModelManager::AddModel(Model3D * model_)
+#include "ThreadPool.h"
+
+//iterations keep going until this is spent, at least one per frame
+static const qint64 SMOOTH_BUDGET_NS = 8000000;
+//vertices uploaded per frame, 12 MB of position and normal
+static const int SMOOTH_UPLOAD_VERTICES = 1 << 19;
+
+//func_ on the ThreadPool, the future rethrows what it threw
+static std::future<void> RunOnPool(std::function<void()> func_)
+{
+	std::shared_ptr<std::packaged_task<void()>> task =
+		std::make_shared<std::packaged_task<void()>>(std::move(func_));
+	std::future<void> result = task->get_future();
+	ThreadPool::Instance().Submit([task]() { (*task)(); });
+	return result;
+}
+
+ModelManager::~ModelManager()
 {
-	models.push_back(model_);
+	while (!smoothJobs.empty())
+		DropSmoothJob((int)smoothJobs.size() - 1);
 }
 
-QVector4D ModelManager::GetIndexColor(int idx_)
+SceneHandle ModelManager::AddModel(Model3D * mesh_)
 {
-	int num = idx_ + MODELS_OFFSET;
+	meshes.push_back(mesh_);
+	meshUsers.push_back(1);
+	residency.Add(mesh_);
+	SceneHandle handle = scene.Create((int)meshes.size() - 1,
+		mesh_->GetBBoxMin(), mesh_->GetBBoxMax(), mesh_->GetCentroid());
+	selection.Resize(scene.GetCount());
+	return handle;
+}
+
+void ModelManager::RemoveModel(SceneHandle handle_)
+{
+	int idx = scene.GetIndex(handle_);
+	if (idx < 0)
+		return;
+
+	int mesh = scene.GetMesh(idx);
+	if (--meshUsers[mesh] == 0) {
+		for (int i = 0; i < smoothJobs.size(); i++) {
+			if (smoothJobs[i]->mesh == meshes[mesh]) {
+				DropSmoothJob(i);
+				break;
+			}
+		}
+		residency.Remove(meshes[mesh]);
+		delete meshes[mesh];
+		meshes[mesh] = 0;
+	}
 
-	int r = num / 65536;
-	int g = (num - r * 65536) / 256;
-	int b = (num - r * 65536 - g * 256);
-	return QVector4D(r / 255.0, g / 255.0, b / 255.0, 1.0);
+	//both move the last entity into the hole
+	scene.Remove(handle_);
+	selection.Remove(idx);
 }
 
-int ModelManager::GetIndexFromColor(QVector4D color_)
+void ModelManager::RemoveSelecteds()
 {
-	color_ = color_ * 255.0;
-	int num = color_[2] + color_[1] * 256 + color_[0] * 256 * 256;
+	std::vector<SceneHandle> handles;
+	const std::vector<int>& indices = selection.GetIndices();
+	for (int i = 0; i < indices.size(); i++)
+		handles.push_back(scene.GetHandle(indices[i]));
 
-	return num - MODELS_OFFSET;
+	selection.BeginBatch();
+	for (int i = 0; i < handles.size(); i++)
+		RemoveModel(handles[i]);
+	selection.EndBatch();
 }
 
-void ModelManager::ToggleSelection(int idx_, bool& onoff_)
+void ModelManager::ApplyRepair(MeshRepairResult & result_)
 {
-	if (std::find(selecteds.begin(), selecteds.end(),
-		models[idx_]) == selecteds.end()) {
-		selecteds.push_back(models[idx_]);
+	std::vector<int> targets;
+	for (int i = 0; i < meshes.size(); i++) {
+		if (meshes[i] && meshes[i]->GetCacheKey() == result_.cacheKey)
+			targets.push_back(i);
+	}
+
+	for (int i = 0; i < targets.size(); i++) {
+		Model3D* mesh = meshes[targets[i]];
 
-		onoff_ = true;
+		//the residency stats are kept incrementally, so the mesh leaves and
+		//comes back with its new sizes. a file loaded more than once gets
+		//copies, the last mesh takes the buffers themselves.
+		residency.Remove(mesh);
+		if (i + 1 < targets.size()) {
+			MeshRepairResult copy = result_;
+			mesh->ApplyRepair(copy);
+		}
+		else
+			mesh->ApplyRepair(result_);
+		residency.Add(mesh);
+		UpdateEntityBounds(targets[i]);
 	}
-	else {
-		selecteds.remove(models[idx_]);
+}
 
-		onoff_ = false;
+void ModelManager::ReplaceMesh(int mesh_, std::vector<float>& vertices_,
+	std::vector<unsigned int>& indices_)
+{
+	Model3D* mesh = meshes[mesh_];
+	for (int i = 0; i < smoothJobs.size(); i++) {
+		if (smoothJobs[i]->mesh == mesh) {
+			DropSmoothJob(i);
+			break;
+		}
 	}
+
+	residency.Remove(mesh);
+	mesh->Replace(vertices_, indices_);
+	residency.Add(mesh);
+	UpdateEntityBounds(mesh_);
+}
+
+void ModelManager::SmoothSelecteds(int iterations_, float lambda_)
+{
+	const std::vector<int>& indices = selection.GetIndices();
+	for (int i = 0; i < indices.size(); i++) {
+		Model3D* mesh = meshes[scene.GetMesh(indices[i])];
+
+		SmoothJob* job = 0;
+		for (int j = 0; j < smoothJobs.size(); j++) {
+			if (smoothJobs[j]->mesh == mesh)
+				job = smoothJobs[j];
+		}
+		if (job) {
+			job->remaining += iterations_;
+			job->lambda = lambda_;
+			continue;
+		}
+
+		job = new SmoothJob;
+		job->mesh = mesh;
+		job->started = false;
+		job->finishing = false;
+		job->remaining = iterations_;
+		job->lambda = lambda_;
+		job->uploadNext = 0;
+		smoothJobs.push_back(job);
+	}
+}
+
+bool ModelManager::StepSmoothing()
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	for (int i = 0; i < smoothJobs.size();) {
+		SmoothJob* job = smoothJobs[i];
+
+		if (!job->started) {
+			//a released copy comes back from the cache over later frames
+			residency.Remove(job->mesh);
+			bool editable = job->mesh->BeginEdit();
+			residency.Add(job->mesh);
+			if (editable) {
+				job->task = RunOnPool([job]() {
+					job->smoother.Build(job->mesh->GetVertices(), Model3D::VERTEX_STRIDE,
+						job->mesh->GetIndices());
+				});
+				job->started = true;
+			}
+			else if (!job->mesh->IsFetchingCpuCopy()) {
+				DropSmoothJob(i);
+				continue;
+			}
+			i++;
+			continue;
+		}
+
+		if (job->task.valid()) {
+			if (job->task.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+				i++;
+				continue;
+			}
+			job->task.get();
+
+			if (job->finishing) {
+				job->finishing = false;
+				job->mesh->EndEdit(job->stats, job->bvh);
+				for (int j = 0; j < meshes.size(); j++) {
+					if (meshes[j] == job->mesh)
+						UpdateEntityBounds(j);
+				}
+				//more iterations may have been queued meanwhile
+				if (job->remaining == 0) {
+					DropSmoothJob(i);
+					continue;
+				}
+			}
+			else
+				job->uploadNext = job->smoother.GetVertexCount();
+		}
+
+		int count = job->smoother.GetVertexCount();
+		if (job->uploadNext < count) {
+			int slice = qMin(SMOOTH_UPLOAD_VERTICES, count - job->uploadNext);
+			job->mesh->UploadVertices(job->uploadNext, slice);
+			job->uploadNext += slice;
+		}
+		else if (job->remaining > 0) {
+			do {
+				job->smoother.Smooth(1, job->lambda);
+				job->remaining--;
+			} while (job->remaining > 0 && timer.nsecsElapsed() < SMOOTH_BUDGET_NS);
+
+			job->smoother.Write(job->mesh->GetVertices(), Model3D::VERTEX_STRIDE, 0, count);
+			job->uploadNext = 0;
+		}
+		else {
+			job->task = RunOnPool([job]() {
+				ComputeMeshStats(job->mesh->GetVertices(), Model3D::VERTEX_STRIDE,
+					job->mesh->GetIndices(), job->stats);
+				job->bvh.Build(job->mesh->GetVertices(), Model3D::VERTEX_STRIDE,
+					job->mesh->GetIndices());
+			});
+			job->finishing = true;
+		}
+		i++;
+	}
+
+	return !smoothJobs.empty();
+}
+
+void ModelManager::UpdateEntityBounds(int mesh_)
+{
+	Model3D* mesh = meshes[mesh_];
+	for (int i = 0; i < scene.GetCount(); i++) {
+		if (scene.GetMesh(i) == mesh_)
+			scene.SetLocalBounds(i, mesh->GetBBoxMin(), mesh->GetBBoxMax(),
+				mesh->GetCentroid());
+	}
+}
+
+void ModelManager::DropSmoothJob(int idx_)
+{
+	SmoothJob* job = smoothJobs[idx_];
+	if (job->task.valid())
+		job->task.wait();
+	delete job;
+	smoothJobs.erase(smoothJobs.begin() + idx_);
 }
 
 qglviewer::Vec ModelManager::GetSelectedsCOG()
 {
+	const std::vector<int>& indices = selection.GetIndices();
 	qglviewer::Vec pos(0, 0, 0);
-	for (std::list<Model3D*>::iterator it = selecteds.begin();
-		it != selecteds.end();
-		it++)
-		pos += (*it)->CenterOfMass();
-	pos /= selecteds.size();
+	for (int i = 0; i < indices.size(); i++)
+		pos += scene.CenterOfMass(indices[i]);
+	pos /= indices.size();
 	return pos;
 }
@@ -1,25 +1,89 @@
 #pragma once
 
+#include <future>
+
 #include "Model3D.h"
+#include "MeshRepair.h"
+#include "MeshSmoother.h"
+#include "ResidencyManager.h"
+#include "SceneStore.h"
+#include "Selection.h"
 
+//meshes and the scene entities that show them. selection indices are the
+//dense entity indices of the scene.
 class ModelManager
 {
 private:
-	std::vector<Model3D*> models;
-	std::list<Model3D*> selecteds;
+	//smoothing spread over frames: a batch of iterations, then the vertex
+	//buffer goes up in slices before the next batch starts. the rings
+	//before the first batch and the stats and BVH after the last one are
+	//built on the ThreadPool.
+	struct SmoothJob {
+		Model3D* mesh;
+		//false while a released copy is read back for the edit
+		bool started;
+		//the ThreadPool part running, it reads the copy of the mesh, so
+		//nothing else touches the job or the copy until it is done
+		std::future<void> task;
+		bool finishing;
+		MeshSmoother smoother;
+		MeshStats stats;
+		MeshBVH bvh;
+		int remaining;
+		float lambda;
+		int uploadNext;
+	};
+
+	std::vector<Model3D*> meshes;
+	std::vector<int> meshUsers;
+	SceneStore scene;
+	Selection selection;
+	ResidencyManager residency;
+	std::vector<SmoothJob*> smoothJobs;
 
 public:
-	void AddModel(Model3D* model_);
+	~ModelManager();
+
+	//takes ownership of mesh_ and creates one entity showing it
+	SceneHandle AddModel(Model3D* mesh_);
+	//deletes the mesh together with its last entity, so the GL context
+	//has to be current
+	void RemoveModel(SceneHandle handle_);
+	//removes every selected entity in one batch
+	void RemoveSelecteds();
+	//hands the result to every mesh made from its cache entry and updates
+	//the bounds of the entities showing them. the last mesh takes the
+	//buffers out of result_. GL context current.
+	void ApplyRepair(MeshRepairResult& result_);
 
-	QVector4D GetIndexColor(int idx_);
-	int GetIndexFromColor(QVector4D color_);
+	//swaps generated buffers into mesh_ and updates the bounds of its
+	//entities, queued smoothing of the old mesh is dropped. GL context
+	//current.
+	void ReplaceMesh(int mesh_, std::vector<float>& vertices_,
+		std::vector<unsigned int>& indices_);
 
-	void ToggleSelection(int idx_, bool & onoff_);
+	//queues iterations_ smoothing iterations on the meshes of the selected
+	//entities, on top of what is still queued for them
+	void SmoothSelecteds(int iterations_, float lambda_);
+	//one frame worth of smoothing and uploads, true while more frames are
+	//needed. GL context current.
+	bool StepSmoothing();
 
 	qglviewer::Vec GetSelectedsCOG();
 
-	inline std::vector<Model3D*>& GetModels() { return models; }
-	inline std::list<Model3D*>& GetSelecteds() { return selecteds; }
+	inline int GetModelCount() const { return scene.GetCount(); }
+	inline Model3D* GetMesh(int idx_) { return meshes[scene.GetMesh(idx_)]; }
+	inline std::vector<Model3D*>& GetMeshes() { return meshes; }
+	inline SceneStore& GetScene() { return scene; }
+	inline Selection& GetSelection() { return selection; }
+	inline ResidencyManager& GetResidency() { return residency; }
 
-	inline bool HasSelected() { return !selecteds.empty(); }
+	inline bool HasSelected() { return !selection.IsEmpty(); }
+
+private:
+	//after the model space bounds of mesh_ changed
+	void UpdateEntityBounds(int mesh_);
+	//waits for its ThreadPool part first, so dropping a job that is still
+	//being built or finished stalls
+	void DropSmoothJob(int idx_);
 };
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "Picker.h"
+
+#include <cfloat>
+
+static bool PointInPolygon(QVector2D point_, const std::vector<QVector2D>& polygon_)
+{
+	//even-odd rule
+	bool inside = false;
+	for (int i = 0, j = (int)polygon_.size() - 1; i < polygon_.size(); j = i++) {
+		QVector2D a = polygon_[i], b = polygon_[j];
+		if ((a.y() > point_.y()) != (b.y() > point_.y()) &&
+			point_.x() < (b.x() - a.x()) * (point_.y() - a.y()) / (b.y() - a.y()) + a.x())
+			inside = !inside;
+	}
+	return inside;
+}
+
+static const int TOP_LEVEL_LEAF_SIZE = 2;
+
+bool Picker::Pick(ModelManager & modelManager_, const QVector3D & origin_,
+	const QVector3D & direction_, PickHit & hit_)
+{
+	hit_.model = hit_.face = -1;
+	hit_.t = FLT_MAX;
+	hit_.u = hit_.v = 0.0f;
+
+	BuildTopLevel(modelManager_);
+
+	const SceneStore& scene = modelManager_.GetScene();
+	const std::vector<int>& order = topLevel.GetIndices();
+	float origin[3] = { origin_[0], origin_[1], origin_[2] };
+	float direction[3] = { direction_[0], direction_[1], direction_[2] };
+	float tBest = FLT_MAX;
+
+	topLevel.Traverse(origin, direction, tBest, [&](const BVH::Node& node_, float& tMax_) {
+		for (int i = 0; i < node_.count; i++) {
+			int idx = order[node_.offset + i];
+			const MeshBVH& bvh = modelManager_.GetMesh(idx)->GetBVH();
+			if (bvh.IsEmpty())
+				continue;
+
+			//into model space, the direction keeps its scale so t stays comparable
+			QMatrix4x4 inverse = scene.GetWorld(idx).inverted();
+			QVector3D o = inverse.map(origin_);
+			QVector3D d = inverse.mapVector(direction_);
+			float localOrigin[3] = { o[0], o[1], o[2] };
+			float localDirection[3] = { d[0], d[1], d[2] };
+
+			TriangleHit triangleHit;
+			if (bvh.Intersect(localOrigin, localDirection, tMax_, triangleHit)) {
+				tMax_ = triangleHit.t;
+				hit_.model = idx;
+				hit_.face = triangleHit.face;
+				hit_.t = triangleHit.t;
+				hit_.u = triangleHit.u;
+				hit_.v = triangleHit.v;
+			}
+		}
+	});
+
+	if (hit_.model < 0)
+		return false;
+
+	hit_.point = origin_ + hit_.t * direction_;
+	return true;
+}
+
+void Picker::BuildTopLevel(ModelManager & modelManager_)
+{
+	const SceneStore& scene = modelManager_.GetScene();
+	boxes.resize(scene.GetCount() * 6);
+	for (int i = 0; i < scene.GetCount(); i++) {
+		const QVector3D& bmin = scene.GetWorldMin(i);
+		const QVector3D& bmax = scene.GetWorldMax(i);
+		for (int r = 0; r < 3; r++) {
+			boxes[i * 6 + r] = bmin[r];
+			boxes[i * 6 + r + 3] = bmax[r];
+		}
+	}
+
+	topLevel.Build(boxes, TOP_LEVEL_LEAF_SIZE);
+}
+
+void Picker::SelectBox(ModelManager & modelManager_, const QMatrix4x4 & viewProj_,
+	QVector2D ndcMin_, QVector2D ndcMax_, bool crossing_, std::vector<int>& indices_)
+{
+	SelectRegion(modelManager_, viewProj_, ndcMin_, ndcMax_, crossing_, 0, indices_);
+}
+
+void Picker::SelectLasso(ModelManager & modelManager_, const QMatrix4x4 & viewProj_,
+	const std::vector<QVector2D>& polygon_, bool crossing_, std::vector<int>& indices_)
+{
+	if (polygon_.size() < 3)
+		return;
+
+	QVector2D ndcMin(FLT_MAX, FLT_MAX), ndcMax(-FLT_MAX, -FLT_MAX);
+	for (int i = 0; i < polygon_.size(); i++) {
+		ndcMin = QVector2D(qMin(ndcMin.x(), polygon_[i].x()), qMin(ndcMin.y(), polygon_[i].y()));
+		ndcMax = QVector2D(qMax(ndcMax.x(), polygon_[i].x()), qMax(ndcMax.y(), polygon_[i].y()));
+	}
+	SelectRegion(modelManager_, viewProj_, ndcMin, ndcMax, crossing_, &polygon_, indices_);
+}
+
+void Picker::SelectRegion(ModelManager & modelManager_, const QMatrix4x4 & viewProj_,
+	QVector2D ndcMin_, QVector2D ndcMax_, bool crossing_,
+	const std::vector<QVector2D>* polygon_, std::vector<int>& indices_)
+{
+	BuildTopLevel(modelManager_);
+
+	//clip space planes of the rectangle, pointing inwards
+	QVector4D r0 = viewProj_.row(0), r1 = viewProj_.row(1);
+	QVector4D r2 = viewProj_.row(2), r3 = viewProj_.row(3);
+	QVector4D rows[6] = {
+		r0 - ndcMin_.x() * r3, ndcMax_.x() * r3 - r0,
+		r1 - ndcMin_.y() * r3, ndcMax_.y() * r3 - r1,
+		r3 + r2, r3 - r2
+	};
+	float planes[6][4];
+	for (int p = 0; p < 6; p++)
+		for (int k = 0; k < 4; k++)
+			planes[p][k] = rows[p][k];
+
+	const std::vector<int>& order = topLevel.GetIndices();
+	BVH::Node box;
+	topLevel.Cull(planes, 6, [&](const BVH::Node& node_, bool inside_) {
+		for (int i = 0; i < node_.count; i++) {
+			int idx = order[node_.offset + i];
+			const float* bounds = &boxes[idx * 6];
+
+			int side = 1;
+			if (!inside_) {
+				for (int k = 0; k < 3; k++) {
+					box.bmin[k] = bounds[k];
+					box.bmax[k] = bounds[k + 3];
+				}
+				side = BVH::ClassifyBox(box, planes, 6);
+			}
+			if (side < 0 || (side == 0 && !crossing_))
+				continue;
+			if (polygon_ && !InsidePolygon(viewProj_, bounds, *polygon_, crossing_))
+				continue;
+
+			indices_.push_back(idx);
+		}
+	});
+}
+
+bool Picker::InsidePolygon(const QMatrix4x4 & viewProj_, const float * box_,
+	const std::vector<QVector2D>& polygon_, bool crossing_)
+{
+	QVector2D cornerMin(FLT_MAX, FLT_MAX), cornerMax(-FLT_MAX, -FLT_MAX);
+	int insideCount = 0;
+	for (int c = 0; c < 8; c++) {
+		QVector4D p = viewProj_ * QVector4D(box_[c & 1 ? 3 : 0],
+			box_[c & 2 ? 4 : 1], box_[c & 4 ? 5 : 2], 1.0f);
+		//behind the eye, the projection flips. the frustum test let it
+		//through, so only a crossing selection can keep it
+		if (p.w() <= 0.0f)
+			return crossing_;
+
+		QVector2D ndc(p.x() / p.w(), p.y() / p.w());
+		if (PointInPolygon(ndc, polygon_))
+			insideCount++;
+		cornerMin = QVector2D(qMin(cornerMin.x(), ndc.x()), qMin(cornerMin.y(), ndc.y()));
+		cornerMax = QVector2D(qMax(cornerMax.x(), ndc.x()), qMax(cornerMax.y(), ndc.y()));
+	}
+
+	if (!crossing_)
+		return insideCount == 8;
+	if (insideCount > 0)
+		return true;
+
+	//a lasso drawn inside the projected bounds still crosses them
+	QVector2D first = polygon_[0];
+	return first.x() >= cornerMin.x() && first.x() <= cornerMax.x() &&
+		first.y() >= cornerMin.y() && first.y() <= cornerMax.y();
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include <QMatrix4x4>
+#include <QVector2D>
+#include <QVector3D>
+
+#include "BVH.h"
+#include "ModelManager.h"
+
+//result of a pick, model and face are -1 when nothing was hit. the
+//barycentrics u, v weight the face's second and third vertex.
+struct PickHit {
+	int model;
+	int face;
+	float t;
+	float u, v;
+	QVector3D point;
+};
+
+//casts a world space ray against a top level BVH over the model bounds,
+//then against the MeshBVH of every model the ray reaches. region
+//selection culls the same top level against the frustum of the region.
+class Picker
+{
+private:
+	BVH topLevel;
+	std::vector<float> boxes;
+
+public:
+	bool Pick(ModelManager& modelManager_, const QVector3D& origin_,
+		const QVector3D& direction_, PickHit& hit_);
+
+	//models inside the rectangle between ndcMin_ and ndcMax_, given in
+	//normalized device coordinates of viewProj_. crossing_ also takes
+	//the models whose bounds only overlap it.
+	void SelectBox(ModelManager& modelManager_, const QMatrix4x4& viewProj_,
+		QVector2D ndcMin_, QVector2D ndcMax_, bool crossing_,
+		std::vector<int>& indices_);
+	//same for a closed polygon, tested on the projected bound corners
+	void SelectLasso(ModelManager& modelManager_, const QMatrix4x4& viewProj_,
+		const std::vector<QVector2D>& polygon_, bool crossing_,
+		std::vector<int>& indices_);
+
+private:
+	void SelectRegion(ModelManager& modelManager_, const QMatrix4x4& viewProj_,
+		QVector2D ndcMin_, QVector2D ndcMax_, bool crossing_,
+		const std::vector<QVector2D>* polygon_, std::vector<int>& indices_);
+	bool InsidePolygon(const QMatrix4x4& viewProj_, const float* box_,
+		const std::vector<QVector2D>& polygon_, bool crossing_);
+
+	//models move between picks, the top level is cheap enough to rebuild
+	void BuildTopLevel(ModelManager& modelManager_);
+};
@@ -0,0 +1,253 @@
+#pragma once
+
+//compile time geometry for gizmos and helpers. a generator fills a
+//Primitive in a constexpr evaluation, so a static constexpr instance is
+//plain read-only data and costs nothing at startup. vertices are xyz
+//unless the generator says otherwise, triangles wind counter clockwise
+//seen from outside.
+namespace Primitives {
+
+constexpr double PI = 3.14159265358979323846;
+
+//C++14 has no constexpr trig. Taylor series on [-PI, PI], below 1e-8.
+constexpr double Sin(double x_)
+{
+	while (x_ > PI)
+		x_ -= 2 * PI;
+	while (x_ < -PI)
+		x_ += 2 * PI;
+
+	double term = x_, sum = x_;
+	for (int k = 1; k < 11; k++) {
+		term *= -x_ * x_ / ((2 * k) * (2 * k + 1));
+		sum += term;
+	}
+	return sum;
+}
+
+constexpr double Cos(double x_)
+{
+	return Sin(x_ + PI / 2);
+}
+
+template<int VERTEX_COUNT, int INDEX_COUNT, int STRIDE>
+struct Primitive {
+	enum {
+		VERTEX_FLOATS = VERTEX_COUNT * STRIDE,
+		INDICES = INDEX_COUNT
+	};
+
+	float vertices[VERTEX_COUNT * STRIDE];
+	unsigned int indices[INDEX_COUNT];
+};
+
+//appends vertices and triangles to the arrays of a Primitive
+struct Writer {
+	float* vertices;
+	unsigned int* indices;
+	int stride;
+	unsigned int vertexCount;
+	int indexCount;
+
+	constexpr Writer(float* vertices_, unsigned int* indices_, int stride_)
+		: vertices(vertices_), indices(indices_), stride(stride_),
+		vertexCount(0), indexCount(0) {}
+
+	//returns the index of the new vertex, attributes past xyz are set
+	//through Attribute
+	constexpr unsigned int Vertex(float x_, float y_, float z_) {
+		float* v = vertices + vertexCount * stride;
+		v[0] = x_;
+		v[1] = y_;
+		v[2] = z_;
+		return vertexCount++;
+	}
+	constexpr void Attribute(unsigned int vertex_, int offset_, float value_) {
+		vertices[vertex_ * stride + offset_] = value_;
+	}
+	constexpr void Triangle(unsigned int a_, unsigned int b_, unsigned int c_) {
+		indices[indexCount++] = a_;
+		indices[indexCount++] = b_;
+		indices[indexCount++] = c_;
+	}
+};
+
+//ring of segments_ points around the x axis, as the cos and sin of every
+//segment angle
+template<int SEGMENTS>
+struct Ring {
+	double cosines[SEGMENTS];
+	double sines[SEGMENTS];
+
+	constexpr Ring() : cosines(), sines() {
+		for (int i = 0; i < SEGMENTS; i++) {
+			cosines[i] = Cos(2 * PI * i / SEGMENTS);
+			sines[i] = Sin(2 * PI * i / SEGMENTS);
+		}
+	}
+};
+
+//side of a truncated cone along x, from radius0_ at x0_ to radius1_ at
+//x1_. with x0_ == x1_ it is an annulus facing -x when radius0_ < radius1_.
+//2 * SEGMENTS vertices, 6 * SEGMENTS indices.
+template<int SEGMENTS>
+constexpr void Tube(Writer& w_, const Ring<SEGMENTS>& ring_,
+	float x0_, float radius0_, float x1_, float radius1_)
+{
+	unsigned int base = w_.vertexCount;
+	for (int i = 0; i < SEGMENTS; i++) {
+		w_.Vertex(x0_, (float)(radius0_ * ring_.cosines[i]), (float)(radius0_ * ring_.sines[i]));
+		w_.Vertex(x1_, (float)(radius1_ * ring_.cosines[i]), (float)(radius1_ * ring_.sines[i]));
+	}
+	for (int i = 0; i < SEGMENTS; i++) {
+		unsigned int a0 = base + 2 * i, a1 = a0 + 1;
+		unsigned int b0 = base + 2 * ((i + 1) % SEGMENTS), b1 = b0 + 1;
+		w_.Triangle(a0, b0, b1);
+		w_.Triangle(a0, b1, a1);
+	}
+}
+
+//cone from a ring of radius_ at x_ to the apex at apexX_, a disc when
+//both are equal. faces +x for facing_ > 0 and -x otherwise.
+//SEGMENTS + 1 vertices, 3 * SEGMENTS indices.
+template<int SEGMENTS>
+constexpr void Fan(Writer& w_, const Ring<SEGMENTS>& ring_,
+	float x_, float radius_, float apexX_, int facing_)
+{
+	unsigned int apex = w_.Vertex(apexX_, 0, 0);
+	for (int i = 0; i < SEGMENTS; i++)
+		w_.Vertex(x_, (float)(radius_ * ring_.cosines[i]), (float)(radius_ * ring_.sines[i]));
+	for (int i = 0; i < SEGMENTS; i++) {
+		unsigned int a = apex + 1 + i;
+		unsigned int b = apex + 1 + (i + 1) % SEGMENTS;
+		if (facing_ > 0)
+			w_.Triangle(apex, a, b);
+		else
+			w_.Triangle(apex, b, a);
+	}
+}
+
+//axis aligned box with shared corners, 8 vertices and 36 indices
+constexpr void Box(Writer& w_, float cx_, float cy_, float cz_, float halfSize_)
+{
+	//corner i has the sign of bit 0, 1 and 2 on x, y and z
+	unsigned int base = w_.vertexCount;
+	for (int i = 0; i < 8; i++)
+		w_.Vertex(cx_ + (i & 1 ? halfSize_ : -halfSize_),
+			cy_ + (i & 2 ? halfSize_ : -halfSize_),
+			cz_ + (i & 4 ? halfSize_ : -halfSize_));
+
+	const int faces[12][3] = {
+		{ 0, 4, 6 },{ 0, 6, 2 },{ 1, 3, 7 },{ 1, 7, 5 },
+		{ 0, 1, 5 },{ 0, 5, 4 },{ 2, 6, 7 },{ 2, 7, 3 },
+		{ 0, 2, 3 },{ 0, 3, 1 },{ 4, 5, 7 },{ 4, 7, 6 }
+	};
+	for (int i = 0; i < 12; i++)
+		w_.Triangle(base + faces[i][0], base + faces[i][1], base + faces[i][2]);
+}
+
+//translate handle along +x: shaft of shaftRadius_ up to shaftLength_ and
+//a cone of headRadius_ ending at 1
+template<int SEGMENTS>
+constexpr Primitive<6 * SEGMENTS + 2, 18 * SEGMENTS, 3> Arrow(
+	float shaftRadius_, float headRadius_, float shaftLength_)
+{
+	Primitive<6 * SEGMENTS + 2, 18 * SEGMENTS, 3> p = {};
+	Writer w(p.vertices, p.indices, 3);
+	Ring<SEGMENTS> ring;
+	Fan(w, ring, 0, shaftRadius_, 0, -1);
+	Tube(w, ring, 0, shaftRadius_, shaftLength_, shaftRadius_);
+	Tube(w, ring, shaftLength_, shaftRadius_, shaftLength_, headRadius_);
+	Fan(w, ring, shaftLength_, headRadius_, 1, 1);
+	return p;
+}
+
+//scale handle along +x: shaft from shaftStart_ to shaftLength_ and a box
+//of headSize_ half extent ending at shaftLength_ + 2 * headSize_
+template<int SEGMENTS>
+constexpr Primitive<4 * SEGMENTS + 10, 12 * SEGMENTS + 36, 3> BoxArrow(
+	float shaftStart_, float shaftRadius_, float shaftLength_, float headSize_)
+{
+	Primitive<4 * SEGMENTS + 10, 12 * SEGMENTS + 36, 3> p = {};
+	Writer w(p.vertices, p.indices, 3);
+	Ring<SEGMENTS> ring;
+	Fan(w, ring, shaftStart_, shaftRadius_, shaftStart_, -1);
+	Tube(w, ring, shaftStart_, shaftRadius_, shaftLength_, shaftRadius_);
+	Fan(w, ring, shaftLength_, shaftRadius_, shaftLength_, 1);
+	Box(w, shaftLength_ + headSize_, 0, 0, headSize_);
+	return p;
+}
+
+//torus around the x axis
+template<int MAJOR_SEGMENTS, int MINOR_SEGMENTS>
+constexpr Primitive<MAJOR_SEGMENTS * MINOR_SEGMENTS, 6 * MAJOR_SEGMENTS * MINOR_SEGMENTS, 3>
+Torus(float majorRadius_, float minorRadius_)
+{
+	Primitive<MAJOR_SEGMENTS * MINOR_SEGMENTS, 6 * MAJOR_SEGMENTS * MINOR_SEGMENTS, 3> p = {};
+	Writer w(p.vertices, p.indices, 3);
+	Ring<MAJOR_SEGMENTS> major;
+	Ring<MINOR_SEGMENTS> minor;
+	for (int i = 0; i < MAJOR_SEGMENTS; i++) {
+		for (int j = 0; j < MINOR_SEGMENTS; j++) {
+			double r = majorRadius_ + minorRadius_ * minor.sines[j];
+			w.Vertex((float)(minorRadius_ * minor.cosines[j]),
+				(float)(r * major.cosines[i]), (float)(r * major.sines[i]));
+		}
+	}
+	for (int i = 0; i < MAJOR_SEGMENTS; i++) {
+		int nextI = (i + 1) % MAJOR_SEGMENTS;
+		for (int j = 0; j < MINOR_SEGMENTS; j++) {
+			int nextJ = (j + 1) % MINOR_SEGMENTS;
+			w.Triangle(i * MINOR_SEGMENTS + j, i * MINOR_SEGMENTS + nextJ,
+				nextI * MINOR_SEGMENTS + j);
+			w.Triangle(nextI * MINOR_SEGMENTS + j, i * MINOR_SEGMENTS + nextJ,
+				nextI * MINOR_SEGMENTS + nextJ);
+		}
+	}
+	return p;
+}
+
+//box of halfSize_ around the origin
+constexpr Primitive<8, 36, 3> Cube(float halfSize_)
+{
+	Primitive<8, 36, 3> p = {};
+	Writer w(p.vertices, p.indices, 3);
+	Box(w, 0, 0, 0, halfSize_);
+	return p;
+}
+
+//[-1, 1] box with its own four corners per face, xyz and a flat normal
+constexpr Primitive<24, 36, 6> FlatBox()
+{
+	Primitive<24, 36, 6> p = {};
+	Writer w(p.vertices, p.indices, 6);
+	const float corners[4][2] = { { -1, -1 },{ 1, -1 },{ 1, 1 },{ -1, 1 } };
+	for (int axis = 0; axis < 3; axis++) {
+		for (int side = -1; side <= 1; side += 2) {
+			int u = (axis + 1) % 3;
+			int v = (axis + 2) % 3;
+
+			unsigned int base = w.vertexCount;
+			for (int k = 0; k < 4; k++) {
+				float pos[3] = { 0, 0, 0 };
+				pos[axis] = (float)side;
+				pos[u] = corners[k][0];
+				pos[v] = corners[k][1];
+				unsigned int vertex = w.Vertex(pos[0], pos[1], pos[2]);
+				w.Attribute(vertex, 3 + axis, (float)side);
+			}
+
+			if (side > 0) {
+				w.Triangle(base, base + 1, base + 2);
+				w.Triangle(base + 2, base + 3, base);
+			}
+			else {
+				w.Triangle(base, base + 2, base + 1);
+				w.Triangle(base + 2, base, base + 3);
+			}
+		}
+	}
+	return p;
+}
+
+}
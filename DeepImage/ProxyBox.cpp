@@ -0,0 +1,43 @@
+#include "ProxyBox.h"
+
+#include <QOpenGLFunctions_4_5_Core>
+
+#include "Primitives.h"
+
+static constexpr auto BOX = Primitives::FlatBox();
+
+ProxyBox::ProxyBox()
+	: vao(0),
+	vbo(0),
+	ibo(0)
+{
+}
+
+ProxyBox::~ProxyBox()
+{
+	delete vao;
+	delete vbo;
+	delete ibo;
+}
+
+void ProxyBox::Init()
+{
+	vao = new VAO;
+	vbo = new VBO(BOX.vertices, sizeof(BOX.vertices));
+	VBOLayout layout;
+	layout.Push<float>(3);
+	layout.Push<float>(3);
+	vao->AddBuffer(*vbo, layout);
+
+	ibo = new IBO(BOX.indices, BOX.INDICES);
+}
+
+void ProxyBox::Draw()
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	vao->Bind();
+	ibo->Bind();
+	f->glDrawElements(GL_TRIANGLES, ibo->GetCount(), GL_UNSIGNED_INT, 0);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "VAO.h"
+#include "VBO.h"
+#include "IBO.h"
+
+//unit box spanning [-1, 1] with flat normals, drawn in place of models
+//that are too small on screen to be worth their full mesh
+class ProxyBox
+{
+private:
+	VAO *vao;
+	VBO *vbo;
+	IBO *ibo;
+
+public:
+	ProxyBox();
+	~ProxyBox();
+
+	void Init();
+	void Draw();
+};
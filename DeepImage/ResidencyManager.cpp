@@ -0,0 +1,159 @@
+#include "ResidencyManager.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const size_t DEFAULT_GPU_BUDGET = (size_t)1024 << 20;
+static const size_t DEFAULT_CPU_BUDGET = (size_t)2048 << 20;
+static const size_t DEFAULT_UPLOAD_BUDGET = (size_t)64 << 20;
+
+ResidencyManager::ResidencyManager()
+	: gpuBudget(DEFAULT_GPU_BUDGET),
+	cpuBudget(DEFAULT_CPU_BUDGET),
+	uploadBudget(DEFAULT_UPLOAD_BUDGET),
+	frame(1),
+	frameUploadBytes(0),
+	deferred(false)
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+void ResidencyManager::SetBudget(size_t gpuBytes_, size_t cpuBytes_, size_t uploadBytes_)
+{
+	gpuBudget = gpuBytes_;
+	cpuBudget = cpuBytes_;
+	uploadBudget = uploadBytes_;
+}
+
+void ResidencyManager::Add(Model3D * mesh_)
+{
+	Entry entry;
+	entry.lastUsed = frame;
+	entries[mesh_] = entry;
+
+	stats.gpuBytes += mesh_->GetGpuBytes();
+	stats.cpuBytes += mesh_->GetCpuBytes();
+	if (mesh_->IsResident())
+		stats.residentCount++;
+}
+
+void ResidencyManager::Remove(Model3D * mesh_)
+{
+	if (!entries.erase(mesh_))
+		return;
+
+	stats.gpuBytes -= mesh_->GetGpuBytes();
+	stats.cpuBytes -= mesh_->GetCpuBytes();
+	if (mesh_->IsResident())
+		stats.residentCount--;
+}
+
+bool ResidencyManager::Request(Model3D * mesh_)
+{
+	std::unordered_map<Model3D*, Entry>::iterator it = entries.find(mesh_);
+	if (it == entries.end())
+		return mesh_->IsResident();
+
+	it->second.lastUsed = frame;
+	if (mesh_->IsResident())
+		return true;
+
+	if (uploadBudget && frameUploadBytes > 0 && frameUploadBytes >= uploadBudget) {
+		deferred = true;
+		return false;
+	}
+
+	//a released copy is read back on the ThreadPool, the mesh waits for
+	//a later frame instead of stalling this one
+	bool fromCache = !mesh_->HasCpuCopy();
+	size_t cpuBefore = mesh_->GetCpuBytes();
+	if (!mesh_->FetchCpuCopy()) {
+		if (mesh_->IsFetchingCpuCopy())
+			deferred = true;
+		return false;
+	}
+	if (!mesh_->Upload())
+		return false;
+
+	size_t bytes = mesh_->GetGpuBytes();
+	frameUploadBytes += bytes;
+	stats.gpuBytes += bytes;
+	stats.cpuBytes += mesh_->GetCpuBytes() - cpuBefore;
+	stats.residentCount++;
+	stats.uploads++;
+	stats.uploadedBytes += bytes;
+	if (fromCache)
+		stats.cacheLoads++;
+	return true;
+}
+
+bool ResidencyManager::EndFrame()
+{
+	std::vector<Model3D*> candidates;
+
+	if (gpuBudget && stats.gpuBytes > gpuBudget) {
+		for (std::unordered_map<Model3D*, Entry>::iterator it = entries.begin();
+			it != entries.end();
+			it++) {
+			if (it->first->IsResident() && it->second.lastUsed < frame)
+				candidates.push_back(it->first);
+		}
+		SortByLastUse(candidates);
+		Evict(candidates, true);
+	}
+
+	if (cpuBudget && stats.cpuBytes > cpuBudget) {
+		//copies of resident meshes are only needed again after an eviction,
+		//so they go first, then the least recently used of the others
+		candidates.clear();
+		for (std::unordered_map<Model3D*, Entry>::iterator it = entries.begin();
+			it != entries.end();
+			it++) {
+			if (it->first->HasCpuCopy())
+				candidates.push_back(it->first);
+		}
+		SortByLastUse(candidates);
+		std::stable_partition(candidates.begin(), candidates.end(),
+			[](Model3D* mesh_) { return mesh_->IsResident(); });
+		Evict(candidates, false);
+	}
+
+	bool needsFrame = deferred;
+	deferred = false;
+	frameUploadBytes = 0;
+	frame++;
+	return needsFrame;
+}
+
+void ResidencyManager::SortByLastUse(std::vector<Model3D*>& meshes_)
+{
+	std::sort(meshes_.begin(), meshes_.end(), [this](Model3D* a_, Model3D* b_) {
+		return entries[a_].lastUsed < entries[b_].lastUsed;
+	});
+}
+
+void ResidencyManager::Evict(const std::vector<Model3D*>& candidates_, bool gpu_)
+{
+	for (int i = 0; i < candidates_.size(); i++) {
+		Model3D* mesh = candidates_[i];
+		if (gpu_) {
+			if (stats.gpuBytes <= gpuBudget)
+				break;
+			size_t bytes = mesh->GetGpuBytes();
+			mesh->Evict();
+			stats.gpuBytes -= bytes;
+			stats.residentCount--;
+			stats.evictions++;
+			stats.evictedBytes += bytes;
+		}
+		else {
+			if (stats.cpuBytes <= cpuBudget)
+				break;
+			size_t bytes = mesh->GetCpuBytes();
+			if (mesh->ReleaseCpuCopy()) {
+				stats.cpuBytes -= bytes;
+				stats.releases++;
+			}
+		}
+	}
+}
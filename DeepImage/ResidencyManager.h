@@ -0,0 +1,66 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "Model3D.h"
+
+struct ResidencyStats {
+	size_t gpuBytes;
+	size_t cpuBytes;
+	int residentCount;
+	int uploads;
+	int evictions;
+	int cacheLoads;
+	int releases;
+	size_t uploadedBytes;
+	size_t evictedBytes;
+};
+
+//keeps the GPU buffers of meshes under a byte budget. the draw loop asks
+//for every mesh it is about to draw, EndFrame then evicts the meshes that
+//went unused for the longest time. CPU copies get the same treatment
+//against their own budget, as far as the mesh cache can give them back.
+class ResidencyManager
+{
+private:
+	struct Entry {
+		unsigned long long lastUsed;
+	};
+	std::unordered_map<Model3D*, Entry> entries;
+
+	size_t gpuBudget;
+	size_t cpuBudget;
+	size_t uploadBudget;
+
+	unsigned long long frame;
+	size_t frameUploadBytes;
+	bool deferred;
+
+	ResidencyStats stats;
+
+public:
+	ResidencyManager();
+
+	//0 disables a limit. uploadBytes_ caps what Request uploads per frame,
+	//the first upload of a frame always goes through
+	void SetBudget(size_t gpuBytes_, size_t cpuBytes_, size_t uploadBytes_);
+
+	void Add(Model3D* mesh_);
+	void Remove(Model3D* mesh_);
+
+	//marks mesh_ as used this frame and uploads it if needed, never waits
+	//for the mesh cache. false means it is not resident yet, the caller
+	//draws a stand-in. GL thread only.
+	bool Request(Model3D* mesh_);
+	//evicts down to the budgets, returns true if a request was deferred
+	//and another frame is needed
+	bool EndFrame();
+
+	inline const ResidencyStats& GetStats() const { return stats; }
+
+private:
+	void SortByLastUse(std::vector<Model3D*>& meshes_);
+	//candidates_ in eviction order, stops once under the budget
+	void Evict(const std::vector<Model3D*>& candidates_, bool gpu_);
+};
@@ -0,0 +1,238 @@
+#include "ResourceTracker.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <vector>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+const int ResourceTracker::SHARED_OWNER;
+
+static thread_local int currentOwner = ResourceTracker::SHARED_OWNER;
+
+static const char* CATEGORY_NAMES[ResourceTracker::CATEGORY_COUNT] = {
+	"vertex_buffer", "index_buffer", "pixel_buffer", "vertex_array", "framebuffer",
+	"half_edge_mesh", "mesh_copy", "mesh_bvh"
+};
+
+static QJsonObject UsageToJson(const ResourceTracker::Usage& usage_)
+{
+	QJsonObject object;
+	object["bytes"] = (double)usage_.bytes;
+	object["peak_bytes"] = (double)usage_.peakBytes;
+	object["count"] = usage_.count;
+	return object;
+}
+
+static std::string FormatBytes(long long bytes_)
+{
+	std::ostringstream stream;
+	stream.precision(1);
+	stream << std::fixed;
+	if (bytes_ >= (1LL << 30))
+		stream << bytes_ / (double)(1LL << 30) << " GB";
+	else if (bytes_ >= (1LL << 20))
+		stream << bytes_ / (double)(1LL << 20) << " MB";
+	else
+		stream << bytes_ / 1024.0 << " KB";
+	return stream.str();
+}
+
+ResourceTracker::ResourceTracker()
+	: nextOwner(SHARED_OWNER + 1)
+{
+	memset(&total, 0, sizeof(total));
+	memset(totals, 0, sizeof(totals));
+
+	Owner shared;
+	shared.name = "shared";
+	memset(&shared.total, 0, sizeof(shared.total));
+	memset(shared.usages, 0, sizeof(shared.usages));
+	owners[SHARED_OWNER] = shared;
+}
+
+ResourceTracker & ResourceTracker::Instance()
+{
+	static ResourceTracker tracker;
+	return tracker;
+}
+
+int ResourceTracker::AddOwner(const std::string & name_)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	Owner owner;
+	owner.name = name_;
+	memset(&owner.total, 0, sizeof(owner.total));
+	memset(owner.usages, 0, sizeof(owner.usages));
+	owners[nextOwner] = owner;
+	return nextOwner++;
+}
+
+void ResourceTracker::RemoveOwner(int owner_)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::map<int, Owner>::iterator it = owners.find(owner_);
+	if (owner_ == SHARED_OWNER || it == owners.end())
+		return;
+
+	Owner& shared = owners[SHARED_OWNER];
+	for (int c = 0; c < CATEGORY_COUNT; c++)
+		Add(shared.usages[c], it->second.usages[c].bytes, it->second.usages[c].count);
+	Add(shared.total, it->second.total.bytes, it->second.total.count);
+	owners.erase(it);
+}
+
+int ResourceTracker::Allocate(Category category_, size_t bytes_)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	//allocations of a removed owner land in the shared one
+	int owner = currentOwner;
+	std::map<int, Owner>::iterator it = owners.find(owner);
+	if (it == owners.end()) {
+		owner = SHARED_OWNER;
+		it = owners.find(owner);
+	}
+
+	Add(it->second.usages[category_], bytes_, 1);
+	Add(it->second.total, bytes_, 1);
+	Add(totals[category_], bytes_, 1);
+	Add(total, bytes_, 1);
+	return owner;
+}
+
+void ResourceTracker::Free(Category category_, int owner_, size_t bytes_)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::map<int, Owner>::iterator it = owners.find(owner_);
+	if (it == owners.end())
+		it = owners.find(SHARED_OWNER);
+
+	Add(it->second.usages[category_], -(long long)bytes_, -1);
+	Add(it->second.total, -(long long)bytes_, -1);
+	Add(totals[category_], -(long long)bytes_, -1);
+	Add(total, -(long long)bytes_, -1);
+}
+
+ResourceTracker::Usage ResourceTracker::GetTotal() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return total;
+}
+
+ResourceTracker::Usage ResourceTracker::GetTotal(Category category_) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return totals[category_];
+}
+
+std::map<int, ResourceTracker::Owner> ResourceTracker::GetOwners() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return owners;
+}
+
+std::string ResourceTracker::Report(int ownerCount_) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::ostringstream stream;
+	stream << "total " << FormatBytes(total.bytes)
+		<< " (peak " << FormatBytes(total.peakBytes) << ")\n";
+	for (int c = 0; c < CATEGORY_COUNT; c++) {
+		const Usage& usage = totals[c];
+		if (usage.peakBytes == 0 && usage.count == 0)
+			continue;
+		stream << "  " << CATEGORY_NAMES[c] << ": " << FormatBytes(usage.bytes)
+			<< " in " << usage.count << " (peak " << FormatBytes(usage.peakBytes) << ")\n";
+	}
+
+	std::vector<const Owner*> sorted;
+	for (std::map<int, Owner>::const_iterator it = owners.begin(); it != owners.end(); it++)
+		sorted.push_back(&it->second);
+	std::sort(sorted.begin(), sorted.end(), [](const Owner* a_, const Owner* b_) {
+		return a_->total.bytes > b_->total.bytes;
+	});
+
+	for (int i = 0; i < sorted.size() && i < ownerCount_; i++) {
+		const Owner& owner = *sorted[i];
+		stream << "\n" << owner.name << ": " << FormatBytes(owner.total.bytes)
+			<< " (peak " << FormatBytes(owner.total.peakBytes) << ")\n";
+		for (int c = 0; c < CATEGORY_COUNT; c++) {
+			if (owner.usages[c].bytes > 0)
+				stream << "  " << CATEGORY_NAMES[c] << ": "
+				<< FormatBytes(owner.usages[c].bytes) << "\n";
+		}
+	}
+	if ((int)sorted.size() > ownerCount_)
+		stream << "\n" << (int)sorted.size() - ownerCount_ << " more\n";
+
+	return stream.str();
+}
+
+std::string ResourceTracker::Dump() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	QJsonObject categories;
+	for (int c = 0; c < CATEGORY_COUNT; c++)
+		categories[CATEGORY_NAMES[c]] = UsageToJson(totals[c]);
+
+	QJsonArray ownerArray;
+	for (std::map<int, Owner>::const_iterator it = owners.begin(); it != owners.end(); it++) {
+		QJsonObject ownerCategories;
+		for (int c = 0; c < CATEGORY_COUNT; c++)
+			ownerCategories[CATEGORY_NAMES[c]] = UsageToJson(it->second.usages[c]);
+
+		QJsonObject owner;
+		owner["id"] = it->first;
+		owner["name"] = QString::fromStdString(it->second.name);
+		owner["total"] = UsageToJson(it->second.total);
+		owner["categories"] = ownerCategories;
+		ownerArray.append(owner);
+	}
+
+	QJsonObject root;
+	root["total"] = UsageToJson(total);
+	root["categories"] = categories;
+	root["owners"] = ownerArray;
+	return QJsonDocument(root).toJson().toStdString();
+}
+
+const char * ResourceTracker::GetCategoryName(Category category_)
+{
+	return CATEGORY_NAMES[category_];
+}
+
+int ResourceTracker::GetCurrentOwner()
+{
+	return currentOwner;
+}
+
+void ResourceTracker::SetCurrentOwner(int owner_)
+{
+	currentOwner = owner_;
+}
+
+void ResourceTracker::Add(Usage & usage_, long long bytes_, int count_)
+{
+	usage_.bytes += bytes_;
+	usage_.count += count_;
+	usage_.peakBytes = std::max(usage_.peakBytes, usage_.bytes);
+}
+
+ResourceScope::ResourceScope(int owner_)
+	: previous(ResourceTracker::GetCurrentOwner())
+{
+	ResourceTracker::SetCurrentOwner(owner_);
+}
+
+ResourceScope::~ResourceScope()
+{
+	ResourceTracker::SetCurrentOwner(previous);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+
+//counts the bytes of GL objects and CPU side mesh data, globally and per
+//owner, with high-water marks. allocations are charged to the owner set for
+//the calling thread by a ResourceScope, everything else to the shared owner.
+class ResourceTracker
+{
+public:
+	enum Category {
+		VERTEX_BUFFER, INDEX_BUFFER, PIXEL_BUFFER, VERTEX_ARRAY, FRAMEBUFFER,
+		HALF_EDGE_MESH, MESH_COPY, MESH_BVH, CATEGORY_COUNT
+	};
+
+	struct Usage {
+		long long bytes;
+		long long peakBytes;
+		int count;
+	};
+
+	struct Owner {
+		std::string name;
+		Usage total;
+		Usage usages[CATEGORY_COUNT];
+	};
+
+	static const int SHARED_OWNER = 0;
+
+private:
+	mutable std::mutex mutex;
+	std::map<int, Owner> owners;
+	int nextOwner;
+
+	Usage total;
+	Usage totals[CATEGORY_COUNT];
+
+public:
+	ResourceTracker();
+
+	static ResourceTracker& Instance();
+
+	int AddOwner(const std::string& name_);
+	//what the owner still holds moves to the shared owner
+	void RemoveOwner(int owner_);
+
+	//returns the owner that was charged, Free takes it back
+	int Allocate(Category category_, size_t bytes_);
+	void Free(Category category_, int owner_, size_t bytes_);
+
+	Usage GetTotal() const;
+	Usage GetTotal(Category category_) const;
+	std::map<int, Owner> GetOwners() const;
+
+	//plain text for the debug panel, owners sorted by size
+	std::string Report(int ownerCount_) const;
+	//everything as JSON
+	std::string Dump() const;
+
+	static const char* GetCategoryName(Category category_);
+
+	static int GetCurrentOwner();
+	static void SetCurrentOwner(int owner_);
+
+private:
+	static void Add(Usage& usage_, long long bytes_, int count_);
+};
+
+//charges the allocations of the enclosing block on this thread to owner_
+class ResourceScope
+{
+private:
+	int previous;
+
+public:
+	ResourceScope(int owner_);
+	~ResourceScope();
+};
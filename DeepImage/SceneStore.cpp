@@ -0,0 +1,307 @@
+#include "SceneStore.h"
+
+#include <emmintrin.h>
+
+#include "ThreadPool.h"
+
+static const int GROUP_GRAIN = 2048;
+
+static inline __m128 Splat(__m128 v_, int lane_)
+{
+	switch (lane_) {
+	case 0: return _mm_shuffle_ps(v_, v_, _MM_SHUFFLE(0, 0, 0, 0));
+	case 1: return _mm_shuffle_ps(v_, v_, _MM_SHUFFLE(1, 1, 1, 1));
+	default: return _mm_shuffle_ps(v_, v_, _MM_SHUFFLE(2, 2, 2, 2));
+	}
+}
+
+//linear part of m_ applied to v_, columns of m_ as registers
+static inline __m128 MulLinear(const __m128 m_[3], __m128 v_)
+{
+	__m128 r = _mm_mul_ps(Splat(v_, 0), m_[0]);
+	r = _mm_add_ps(r, _mm_mul_ps(Splat(v_, 1), m_[1]));
+	return _mm_add_ps(r, _mm_mul_ps(Splat(v_, 2), m_[2]));
+}
+
+static inline __m128 Load(const QVector3D& v_)
+{
+	return _mm_setr_ps(v_[0], v_[1], v_[2], 0.0f);
+}
+
+static inline void Store(QVector3D& v_, __m128 r_)
+{
+	float f[4];
+	_mm_storeu_ps(f, r_);
+	v_ = QVector3D(f[0], f[1], f[2]);
+}
+
+SceneHandle SceneStore::Create(int mesh_, const QVector3D & localMin_,
+	const QVector3D & localMax_, const QVector3D & centroid_)
+{
+	int slot;
+	if (!freeSlots.empty()) {
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else {
+		slot = (int)denseIndices.size();
+		denseIndices.push_back(-1);
+		generations.push_back(0);
+	}
+
+	int idx = GetCount();
+	denseIndices[slot] = idx;
+
+	positions.push_back(qglviewer::Vec(0, 0, 0));
+	orientations.push_back(qglviewer::Quaternion());
+	scales.push_back(QVector3D(1, 1, 1));
+	worlds.push_back(QMatrix4x4());
+	localMins.push_back(localMin_);
+	localMaxs.push_back(localMax_);
+	worldMins.push_back(localMin_);
+	worldMaxs.push_back(localMax_);
+	centroids.push_back(centroid_);
+	colors.push_back(QVector4D(0, 0, 0, 1));
+	meshes.push_back(mesh_);
+	slots.push_back(slot);
+
+	SceneHandle handle;
+	handle.slot = slot;
+	handle.generation = generations[slot];
+	return handle;
+}
+
+bool SceneStore::Remove(SceneHandle handle_)
+{
+	int idx = GetIndex(handle_);
+	if (idx < 0)
+		return false;
+
+	//the last entity takes the place of the removed one
+	int last = GetCount() - 1;
+	positions[idx] = positions[last];
+	orientations[idx] = orientations[last];
+	scales[idx] = scales[last];
+	worlds[idx] = worlds[last];
+	localMins[idx] = localMins[last];
+	localMaxs[idx] = localMaxs[last];
+	worldMins[idx] = worldMins[last];
+	worldMaxs[idx] = worldMaxs[last];
+	centroids[idx] = centroids[last];
+	colors[idx] = colors[last];
+	meshes[idx] = meshes[last];
+	slots[idx] = slots[last];
+	denseIndices[slots[idx]] = idx;
+
+	positions.pop_back();
+	orientations.pop_back();
+	scales.pop_back();
+	worlds.pop_back();
+	localMins.pop_back();
+	localMaxs.pop_back();
+	worldMins.pop_back();
+	worldMaxs.pop_back();
+	centroids.pop_back();
+	colors.pop_back();
+	meshes.pop_back();
+	slots.pop_back();
+
+	denseIndices[handle_.slot] = -1;
+	generations[handle_.slot]++;
+	freeSlots.push_back(handle_.slot);
+	return true;
+}
+
+int SceneStore::GetIndex(SceneHandle handle_) const
+{
+	if (handle_.slot < 0 || handle_.slot >= denseIndices.size() ||
+		generations[handle_.slot] != handle_.generation)
+		return -1;
+	return denseIndices[handle_.slot];
+}
+
+SceneHandle SceneStore::GetHandle(int idx_) const
+{
+	SceneHandle handle;
+	handle.slot = slots[idx_];
+	handle.generation = generations[handle.slot];
+	return handle;
+}
+
+void SceneStore::SetTransform(int idx_, const qglviewer::Vec & position_,
+	const qglviewer::Quaternion & orientation_)
+{
+	positions[idx_] = position_;
+	orientations[idx_] = orientation_;
+	UpdateWorld(idx_);
+}
+
+void SceneStore::SetScale(int idx_, const QVector3D & scale_)
+{
+	scales[idx_] = scale_;
+	UpdateWorld(idx_);
+}
+
+void SceneStore::SetLocalBounds(int idx_, const QVector3D & localMin_,
+	const QVector3D & localMax_, const QVector3D & centroid_)
+{
+	localMins[idx_] = localMin_;
+	localMaxs[idx_] = localMax_;
+	centroids[idx_] = centroid_;
+	UpdateBounds(idx_);
+}
+
+void SceneStore::Translate(int idx_, const qglviewer::Vec & translation_)
+{
+	positions[idx_] += translation_;
+	UpdateWorld(idx_);
+}
+
+void SceneStore::Rotate(int idx_, const qglviewer::Quaternion & rotation_,
+	const qglviewer::Vec & pivot_)
+{
+	orientations[idx_] = rotation_ * orientations[idx_];
+	orientations[idx_].normalize();
+	positions[idx_] = pivot_ + rotation_.rotate(positions[idx_] - pivot_);
+	UpdateWorld(idx_);
+}
+
+void SceneStore::Translate(const std::vector<int>& indices_,
+	const qglviewer::Vec & translation_)
+{
+	ThreadPool::Instance().ParallelFor(0, (int)indices_.size(), GROUP_GRAIN,
+		[&](int begin_, int end_) {
+		for (int i = begin_; i < end_; i++) {
+			int idx = indices_[i];
+			positions[idx] += translation_;
+
+			//only the translation column moves, it is taken from the double
+			//position so repeated steps do not drift
+			float* m = worlds[idx].data();
+			const qglviewer::Vec& pos = positions[idx];
+			m[12] = (float)pos[0];
+			m[13] = (float)pos[1];
+			m[14] = (float)pos[2];
+			UpdateBounds(idx);
+		}
+	});
+}
+
+void SceneStore::Rotate(const std::vector<int>& indices_,
+	const qglviewer::Quaternion & rotation_, const qglviewer::Vec & pivot_)
+{
+	//positions are rotated about the pivot with SSE2 on the double pairs
+	double dm[4][4];
+	rotation_.getMatrix(dm);
+	__m128d columnsXY[3], columnsZ[3];
+	for (int c = 0; c < 3; c++) {
+		columnsXY[c] = _mm_setr_pd(dm[c][0], dm[c][1]);
+		columnsZ[c] = _mm_set_sd(dm[c][2]);
+	}
+	__m128d pivotXY = _mm_setr_pd(pivot_[0], pivot_[1]);
+	__m128d pivotZ = _mm_set_sd(pivot_[2]);
+
+	ThreadPool::Instance().ParallelFor(0, (int)indices_.size(), GROUP_GRAIN,
+		[&](int begin_, int end_) {
+		for (int i = begin_; i < end_; i++) {
+			int idx = indices_[i];
+			orientations[idx] = rotation_ * orientations[idx];
+			orientations[idx].normalize();
+
+			qglviewer::Vec& pos = positions[idx];
+			__m128d dXY = _mm_sub_pd(_mm_setr_pd(pos[0], pos[1]), pivotXY);
+			__m128d dZ = _mm_sub_sd(_mm_set_sd(pos[2]), pivotZ);
+			__m128d d[3] = { _mm_unpacklo_pd(dXY, dXY), _mm_unpackhi_pd(dXY, dXY),
+				_mm_unpacklo_pd(dZ, dZ) };
+			__m128d xy = pivotXY, rz = pivotZ;
+			for (int c = 0; c < 3; c++) {
+				xy = _mm_add_pd(xy, _mm_mul_pd(d[c], columnsXY[c]));
+				rz = _mm_add_sd(rz, _mm_mul_sd(d[c], columnsZ[c]));
+			}
+			double out[2];
+			_mm_storeu_pd(out, xy);
+			pos = qglviewer::Vec(out[0], out[1], _mm_cvtsd_f64(rz));
+
+			SetWorld(idx);
+			UpdateBounds(idx);
+		}
+	});
+}
+
+void SceneStore::SetScale(const std::vector<int>& indices_,
+	const std::vector<QVector3D>& scales_)
+{
+	ThreadPool::Instance().ParallelFor(0, (int)indices_.size(), GROUP_GRAIN,
+		[&](int begin_, int end_) {
+		for (int i = begin_; i < end_; i++) {
+			int idx = indices_[i];
+			qglviewer::Vec com = CenterOfMass(idx);
+			scales[idx] = scales_[i];
+			QVector3D scaled = centroids[idx] * scales[idx];
+			positions[idx] = com - orientations[idx].rotate(
+				qglviewer::Vec(scaled[0], scaled[1], scaled[2]));
+
+			SetWorld(idx);
+			UpdateBounds(idx);
+		}
+	});
+}
+
+qglviewer::Vec SceneStore::CenterOfMass(int idx_) const
+{
+	QVector3D scaled = centroids[idx_] * scales[idx_];
+	return positions[idx_] + orientations[idx_].rotate(
+		qglviewer::Vec(scaled[0], scaled[1], scaled[2]));
+}
+
+void SceneStore::UpdateWorld(int idx_)
+{
+	SetWorld(idx_);
+	UpdateBounds(idx_);
+}
+
+void SceneStore::SetWorld(int idx_)
+{
+	//rotation of the normalized orientation times the scale, written
+	//column major. rebuilt from the double precision state every time so
+	//incremental drags do not accumulate float error in the matrix.
+	const qglviewer::Quaternion& q = orientations[idx_];
+	double x = q[0], y = q[1], z = q[2], w = q[3];
+	double rotation[3][3] = {
+		{ 1.0 - 2.0 * (y * y + z * z), 2.0 * (x * y + z * w), 2.0 * (x * z - y * w) },
+		{ 2.0 * (x * y - z * w), 1.0 - 2.0 * (x * x + z * z), 2.0 * (y * z + x * w) },
+		{ 2.0 * (x * z + y * w), 2.0 * (y * z - x * w), 1.0 - 2.0 * (x * x + y * y) } };
+
+	float* m = worlds[idx_].data();
+	const QVector3D& scale = scales[idx_];
+	for (int c = 0; c < 3; c++) {
+		for (int r = 0; r < 3; r++)
+			m[c * 4 + r] = (float)(rotation[c][r] * scale[c]);
+		m[c * 4 + 3] = 0.0f;
+	}
+	const qglviewer::Vec& pos = positions[idx_];
+	m[12] = (float)pos[0];
+	m[13] = (float)pos[1];
+	m[14] = (float)pos[2];
+	m[15] = 1.0f;
+}
+
+void SceneStore::UpdateBounds(int idx_)
+{
+	//world space box of the transformed model space box
+	const float* m = worlds[idx_].constData();
+	__m128 columns[3] = { _mm_loadu_ps(m), _mm_loadu_ps(m + 4), _mm_loadu_ps(m + 8) };
+	__m128 sign = _mm_set1_ps(-0.0f);
+	__m128 absColumns[3];
+	for (int c = 0; c < 3; c++)
+		absColumns[c] = _mm_andnot_ps(sign, columns[c]);
+
+	__m128 lo = Load(localMins[idx_]), hi = Load(localMaxs[idx_]);
+	__m128 half = _mm_set1_ps(0.5f);
+	__m128 centerM = _mm_mul_ps(_mm_add_ps(lo, hi), half);
+	__m128 extentM = _mm_mul_ps(_mm_sub_ps(hi, lo), half);
+	__m128 center = _mm_add_ps(MulLinear(columns, centerM), _mm_loadu_ps(m + 12));
+	__m128 extent = MulLinear(absColumns, extentM);
+	Store(worldMins[idx_], _mm_sub_ps(center, extent));
+	Store(worldMaxs[idx_], _mm_add_ps(center, extent));
+}
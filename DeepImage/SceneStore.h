@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vector>
+#include <QMatrix4x4>
+#include <QVector3D>
+#include <QVector4D>
+#include <QGLViewer/quaternion.h>
+
+//stable reference to an entity. the slot outlives moves of the entity inside
+//the dense arrays, the generation tells a removed entity from the next one
+//that reuses its slot.
+struct SceneHandle {
+	int slot;
+	unsigned int generation;
+};
+
+//scene entities as one contiguous array per component. loops run over the
+//dense index [0, GetCount()), everything that has to survive removals keeps
+//a SceneHandle. removing moves the last entity into the hole, so dense
+//indices are only valid until the next Remove.
+class SceneStore
+{
+private:
+	//per entity
+	std::vector<qglviewer::Vec> positions;
+	std::vector<qglviewer::Quaternion> orientations;
+	std::vector<QVector3D> scales;
+	std::vector<QMatrix4x4> worlds;
+	std::vector<QVector3D> localMins, localMaxs;
+	std::vector<QVector3D> worldMins, worldMaxs;
+	std::vector<QVector3D> centroids;
+	std::vector<QVector4D> colors;
+	std::vector<int> meshes;
+	std::vector<int> slots;
+
+	//per slot
+	std::vector<int> denseIndices;
+	std::vector<unsigned int> generations;
+	std::vector<int> freeSlots;
+
+public:
+	//localMin_, localMax_ and centroid_ are the model space bounds and
+	//centre of mass of mesh_
+	SceneHandle Create(int mesh_, const QVector3D& localMin_,
+		const QVector3D& localMax_, const QVector3D& centroid_);
+	//returns false for a stale handle
+	bool Remove(SceneHandle handle_);
+
+	//-1 for a stale handle
+	int GetIndex(SceneHandle handle_) const;
+	SceneHandle GetHandle(int idx_) const;
+
+	void SetTransform(int idx_, const qglviewer::Vec& position_,
+		const qglviewer::Quaternion& orientation_);
+	void SetScale(int idx_, const QVector3D& scale_);
+	//after the mesh changed, e.g. by a repair
+	void SetLocalBounds(int idx_, const QVector3D& localMin_,
+		const QVector3D& localMax_, const QVector3D& centroid_);
+	void Translate(int idx_, const qglviewer::Vec& translation_);
+	//world space rotation around pivot_
+	void Rotate(int idx_, const qglviewer::Quaternion& rotation_,
+		const qglviewer::Vec& pivot_);
+
+	//one delta applied to a whole group, e.g. the gizmo followers. world
+	//matrices and boxes are updated with SSE, in parallel for large groups.
+	void Translate(const std::vector<int>& indices_, const qglviewer::Vec& translation_);
+	void Rotate(const std::vector<int>& indices_, const qglviewer::Quaternion& rotation_,
+		const qglviewer::Vec& pivot_);
+	//model space scales_[i] for indices_[i], the centre of mass of every
+	//entity stays in place. bounds and centroids follow from the matrix.
+	void SetScale(const std::vector<int>& indices_, const std::vector<QVector3D>& scales_);
+
+	qglviewer::Vec CenterOfMass(int idx_) const;
+
+	inline int GetCount() const { return (int)meshes.size(); }
+	inline void SetColor(int idx_, const QVector4D& color_) { colors[idx_] = color_; }
+
+	inline const qglviewer::Vec& GetPosition(int idx_) const { return positions[idx_]; }
+	inline const qglviewer::Quaternion& GetOrientation(int idx_) const { return orientations[idx_]; }
+	inline const QVector3D& GetScale(int idx_) const { return scales[idx_]; }
+	inline const QMatrix4x4& GetWorld(int idx_) const { return worlds[idx_]; }
+	inline const QVector3D& GetLocalMin(int idx_) const { return localMins[idx_]; }
+	inline const QVector3D& GetLocalMax(int idx_) const { return localMaxs[idx_]; }
+	inline const QVector3D& GetWorldMin(int idx_) const { return worldMins[idx_]; }
+	inline const QVector3D& GetWorldMax(int idx_) const { return worldMaxs[idx_]; }
+	inline const QVector4D& GetColor(int idx_) const { return colors[idx_]; }
+	inline int GetMesh(int idx_) const { return meshes[idx_]; }
+
+private:
+	void UpdateWorld(int idx_);
+	void SetWorld(int idx_);
+	void UpdateBounds(int idx_);
+};
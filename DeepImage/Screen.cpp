@@ -1,26 +1,67 @@
 #include "Screen.h"
 
 #include <QGLViewer/manipulatedCameraFrame.h>
+#include <QLoggingCategory>
 #include <QMouseEvent>
 
+//startup timings, on by default, QT_LOGGING_RULES="deepimage.startup=false"
+//silences them
+Q_LOGGING_CATEGORY(lcStartup, "deepimage.startup")
+
+static const float SCENE_BUDGET_MS = 10.0f;
+static const float MIN_RENDER_SCALE = 0.5f;
+static const float UPSCALE_SHARPNESS = 0.5f;
+static const QVector3D BACKGROUND(0.7f, 0.7f, 0.7f);
+static const int WHEEL_IDLE_MS = 150;
+//lasso points closer than this to the previous one are dropped
+static const int LASSO_SPACING = 3;
+
 Screen::Screen(QWidget * parent)
 	: QGLViewer(parent),
 	phong(0),
+	phongTess(0),
 	solid(0),
-	vertexColor(0),
-	fbo(0),
-	checkerBoard(10, 10),
-	gizmo(&gizmoTranslate)
+	gizmoShader(0),
+	ground(0),
+	upscale(0),
+	sceneFbo(0),
+	screenTriangle(0),
+	sceneTimer(0),
+	frameTimer(0),
+	renderScale(1.0f),
+	interactiveScale(1.0f),
+	mouseDown(false),
+	wheeling(false),
+	gizmo(&gizmoTranslate),
+	tessellation(false),
+	shaderSetupTime(0),
+	firstFrameDrawn(false),
+	shadersReported(false),
+	regionMode(NO_REGION)
 {
+	startupTimer.start();
+
+	lastPick.model = lastPick.face = -1;
 
+	wheelIdleTimer.setSingleShot(true);
+	connect(&wheelIdleTimer, &QTimer::timeout, [this]() {
+		wheeling = false;
+		update();
+	});
 }
 
 Screen::~Screen()
 {
 	delete phong;
+	delete phongTess;
 	delete solid;
-	delete vertexColor;
-	delete fbo;
+	delete gizmoShader;
+	delete ground;
+	delete upscale;
+	delete sceneFbo;
+	delete screenTriangle;
+	delete sceneTimer;
+	delete frameTimer;
 }
 
 void Screen::SetGizmoType(GizmoType gizmoType_)
@@ -33,18 +74,47 @@ void Screen::SetGizmoType(GizmoType gizmoType_)
 	case ROTATE:
 		gizmo = &gizmoRotate;
 		break;
+	case SCALE:
+		gizmo = &gizmoScale;
+		break;
 	default:
 		break;
 	}
 
+	FollowSelection();
+}
+
+void Screen::SetTessellation(bool tessellation_)
+{
+	tessellation = tessellation_;
+	update();
+}
+
+void Screen::SetModelManager(ModelManager & modelManager_)
+{
+	modelManager = &modelManager_;
+	drawList.SetResidency(&modelManager->GetResidency());
+	modelManager->GetSelection().AddListener([this]() {
+		FollowSelection();
+		update();
+	});
+}
+
+void Screen::FollowSelection()
+{
 	gizmo->ClearFollower();
-	std::list<Model3D*> selecteds = modelManager->GetSelecteds();
-	for (std::list<Model3D*>::iterator it = selecteds.begin();
-		it != selecteds.end();
-		it++)
-		gizmo->Followed(**it);
+	if (!modelManager->HasSelected())
+		return;
+
+	SceneStore& scene = modelManager->GetScene();
+	const std::vector<int>& indices = modelManager->GetSelection().GetIndices();
+	for (int i = 0; i < indices.size(); i++)
+		gizmo->Followed(scene, scene.GetHandle(indices[i]));
 	qglviewer::Vec pos = modelManager->GetSelectedsCOG();
 	gizmo->SetPosition(pos);
+	//scaling works along the model axes, show those of the last selected
+	if (gizmo == &gizmoScale)
+		gizmo->GetFrame().setOrientation(scene.GetOrientation(indices.back()));
 	gizmo->AdjustScale(*camera());
 }
 
@@ -64,14 +134,60 @@ void Screen::init()
 
 	setMouseTracking(true);
 
+	QElapsedTimer shaderTimer;
+	shaderTimer.start();
 	phong = new PhongShader;
+	phongTess = new PhongTessShader;
 	solid = new SolidColorShader;
-	vertexColor = new VertexColorShader;
+	gizmoShader = new GizmoShader;
+	ground = new GroundShader;
+	upscale = new UpscaleShader;
+	shaderManager.Add(phong);
+	shaderManager.Add(phongTess);
+	shaderManager.Add(solid);
+	shaderManager.Add(gizmoShader);
+	shaderManager.Add(ground);
+	shaderManager.Add(upscale);
+	shaderManager.SetErrorCallback(
+		[](const std::string& name_, const std::string& log_) {
+		qWarning("Shader %s failed:\n%s", name_.c_str(), log_.c_str());
+	});
+	shaderManager.SubmitAll();
+	shaderSetupTime = shaderTimer.elapsed();
 
 	gizmoTranslate.Init();
 	gizmoRotate.Init();
+	gizmoScale.Init();
+
+	proxyBox.Init();
+	selectionOverlay.Init();
 
-	checkerBoard.Init();
+	screenTriangle = new VAO;
+	sceneTimer = new GpuTimer;
+	frameTimer = new GpuTimer;
+}
+
+bool Screen::IsInteracting()
+{
+	return mouseDown || wheeling ||
+		camera()->frame()->isManipulated() || gizmo->GetFrame().isManipulated();
+}
+
+void Screen::UpdateRenderScale()
+{
+	if (!IsInteracting()) {
+		renderScale = 1.0f;
+		return;
+	}
+
+	//pixel cost is roughly proportional to the area, hence the sqrt
+	float sceneTime = (float)sceneTimer->GetLastTime();
+	if (sceneTime > 0.0f) {
+		float target = renderScale * sqrt(SCENE_BUDGET_MS / sceneTime);
+		interactiveScale = 0.7f * interactiveScale + 0.3f * target;
+		interactiveScale = qBound(MIN_RENDER_SCALE, interactiveScale, 1.0f);
+	}
+	renderScale = interactiveScale;
 }
 
 void Screen::draw()
@@ -79,43 +195,107 @@ void Screen::draw()
 	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
 		versionFunctions<QOpenGLFunctions_4_5_Core>();
 
-	f->glClearColor(0.7f, 0.7f, 0.7f, 1.0f);
-	f->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	QElapsedTimer cpuTimer;
+	cpuTimer.start();
+	frameTimer->Begin();
+
+	bool shadersReady = shaderManager.Poll();
+
+	bool interacting = IsInteracting();
+	QualitySettings quality = governor.GetSettings();
+	drawList.SetLODBias(quality.lodBias);
+	drawList.SetProxy(&proxyBox, quality.proxyScreenSize);
+	gizmo->SetDetail(quality.lowDetailGizmo ? Gizmo::LOW_DETAIL : Gizmo::HIGH_DETAIL);
 
 	QMatrix4x4 proj, view;
 	camera()->getModelViewMatrix(view.data());
 	camera()->getProjectionMatrix(proj.data());
 
-	checkerBoard.Draw(view, proj, *vertexColor);
+	UpdateRenderScale();
+	int viewWidth = sceneFbo->GetWidth();
+	int viewHeight = sceneFbo->GetHeight();
+	int sceneWidth = qMax(1, (int)(viewWidth * renderScale));
+	int sceneHeight = qMax(1, (int)(viewHeight * renderScale));
+
+	sceneFbo->Bind();
+	f->glViewport(0, 0, sceneWidth, sceneHeight);
+	sceneTimer->Begin();
+
+	f->glClearColor(BACKGROUND.x(), BACKGROUND.y(), BACKGROUND.z(), 1.0f);
+	f->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	//writes its own depth, so the scene still sorts against it
+	if (quality.drawGround && ground->IsReady()) {
+		ground->Predraw(view, proj, BACKGROUND, camera()->zFar());
+		screenTriangle->Bind();
+		f->glDrawArrays(GL_TRIANGLES, 0, 3);
+	}
 
-	std::vector<Model3D*>& models = modelManager->GetModels();
-	std::list<Model3D*>& selecteds = modelManager->GetSelecteds();
-	for (int i = 0; i < models.size(); i++) {
-		if (std::find(selecteds.begin(), selecteds.end(),
-			models[i]) != selecteds.end())
-			models[i]->SetColor(QVector4D(0.0, 1.0, 0.0, 1.0));
-		else
-			models[i]->SetColor(QVector4D(0.0, 0.0, 0.0, 1.0));
+	bool smoothing = modelManager->StepSmoothing();
+	drawList.Prepare(*modelManager, view, proj, sceneHeight);
+	bool uploadsPending = false;
+	if (phong->IsReady()) {
+		//coarser quality levels ask for longer edges and finally none, until
+		//the program is linked the plain meshes are drawn
+		PhongTessShader* tessellated = 0;
+		if (tessellation && quality.tessellationPixels > 0.0f && phongTess->IsReady()) {
+			tessellated = phongTess;
+			tessellated->SetTessellation(sceneWidth, sceneHeight, quality.tessellationPixels);
+		}
+		drawList.Submit(*phong, tessellated);
+		uploadsPending = modelManager->GetResidency().EndFrame();
+	}
 
-		phong->Predraw(view, proj, *models[i]);
-		models[i]->Draw();
+	sceneTimer->End();
+
+	//the scene depth stays in sceneFbo, the overlays only sort against
+	//each other in a depth buffer of their own. until the upscale program
+	//links the colour is cleared too, no stale frame is left behind them.
+	f->glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+	f->glViewport(0, 0, viewWidth, viewHeight);
+	if (upscale->IsReady())
+		f->glClear(GL_DEPTH_BUFFER_BIT);
+	else
+		f->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	if (upscale->IsReady()) {
+		f->glDisable(GL_DEPTH_TEST);
+		upscale->Predraw(sceneFbo->GetColorTexture(),
+			sceneWidth / (float)viewWidth, sceneHeight / (float)viewHeight,
+			viewWidth, viewHeight, renderScale < 1.0f ? UPSCALE_SHARPNESS : 0.0f);
+		screenTriangle->Bind();
+		f->glDrawArrays(GL_TRIANGLES, 0, 3);
+		f->glEnable(GL_DEPTH_TEST);
 	}
 
-	if (modelManager->HasSelected())
-		gizmo->Draw(view, proj, *solid);
+	if (modelManager->HasSelected() && gizmoShader->IsReady())
+		gizmo->Draw(view, proj, *gizmoShader);
 
-	fbo->Bind();
-	f->glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-	f->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	if (regionMode != NO_REGION && solid->IsReady()) {
+		std::vector<QVector2D> polygon;
+		GetRegionPolygon(polygon);
+		selectionOverlay.Draw(polygon, *solid);
+	}
+
+	frameTimer->End();
+	float cpuTime = cpuTimer.nsecsElapsed() / 1.0e6f;
+	governor.Update(qMax(cpuTime, (float)frameTimer->GetLastTime()), interacting);
+	if (governor.NeedsRefinement(interacting) || uploadsPending || smoothing)
+		update();
 
-	for (int i = 0; i < models.size(); i++) {
-		QVector4D color = modelManager->GetIndexColor(i);
-		models[i]->SetColor(color);
-		solid->Predraw(view, proj, *models[i]);
-		models[i]->Draw();
+	if (!firstFrameDrawn) {
+		firstFrameDrawn = true;
+		qCInfo(lcStartup, "First frame after %lld ms (shader submit %lld ms)",
+			startupTimer.elapsed(), shaderSetupTime);
 	}
 
-	fbo->Unbind();
+	//keep frames coming until the driver has finished every program
+	if (!shadersReady)
+		update();
+	else if (!shadersReported) {
+		shadersReported = true;
+		qCInfo(lcStartup, "Shaders ready after %lld ms%s", startupTimer.elapsed(),
+			shaderManager.IsParallel() ? " (parallel compile)" : "");
+	}
 }
 
 void Screen::resizeGL(int width_, int height_)
@@ -124,38 +304,84 @@ void Screen::resizeGL(int width_, int height_)
 
 	gizmo->AdjustScale(*camera());
 
-	delete fbo;
-	fbo = new FBO(width_, height_);
+	if (!sceneFbo)
+		sceneFbo = new FBO(width_, height_, true);
+	sceneFbo->Resize(width_, height_);
+}
+
+void Screen::PickModel(int idx_)
+{
+	if (idx_ < 0 || idx_ >= modelManager->GetModelCount())
+		return;
+
+	//the selection listener moves the gizmo
+	modelManager->GetSelection().Toggle(idx_);
+}
+
+void Screen::GetRegionPolygon(std::vector<QVector2D>& polygon_)
+{
+	polygon_.clear();
+	for (int i = 0; i < regionPoints.size(); i++)
+		polygon_.push_back(QVector2D(2.0f * regionPoints[i].x() / width() - 1.0f,
+			1.0f - 2.0f * regionPoints[i].y() / height()));
+
+	if (regionMode == BOX_REGION && polygon_.size() == 2) {
+		QVector2D a = polygon_[0], b = polygon_[1];
+		polygon_.insert(polygon_.begin() + 1, QVector2D(b.x(), a.y()));
+		polygon_.push_back(QVector2D(a.x(), b.y()));
+	}
+}
+
+void Screen::SelectRegion()
+{
+	std::vector<QVector2D> polygon;
+	GetRegionPolygon(polygon);
+	if (polygon.size() < 3)
+		return;
+
+	QMatrix4x4 proj, view;
+	camera()->getModelViewMatrix(view.data());
+	camera()->getProjectionMatrix(proj.data());
+	QMatrix4x4 viewProj = proj * view;
+
+	std::vector<int> indices;
+	if (regionMode == BOX_REGION) {
+		//like CAD tools: dragged to the right takes what is fully
+		//inside, dragged to the left also what the box crosses
+		QVector2D a = polygon[0], b = polygon[2];
+		bool crossing = b.x() < a.x();
+		picker.SelectBox(*modelManager, viewProj,
+			QVector2D(qMin(a.x(), b.x()), qMin(a.y(), b.y())),
+			QVector2D(qMax(a.x(), b.x()), qMax(a.y(), b.y())), crossing, indices);
+	}
+	else {
+		picker.SelectLasso(*modelManager, viewProj, polygon, false, indices);
+	}
+
+	//one batch for the whole region, the gizmo is rebuilt once
+	modelManager->GetSelection().Select(indices);
 }
 
 void Screen::mousePressEvent(QMouseEvent * e_)
 {
+	if (e_->button() == Qt::LeftButton && !gizmo->IsHover() &&
+		(e_->modifiers() & (Qt::ShiftModifier | Qt::ControlModifier))) {
+		regionMode = e_->modifiers() & Qt::ShiftModifier ? BOX_REGION : LASSO_REGION;
+		regionPoints.assign(1, e_->pos());
+		update();
+		return;
+	}
+
+	mouseDown = true;
 	gizmo->MousePressed(e_->pos(), *camera());
 
 	if (!gizmo->IsHover()) {
-		makeCurrent();
-		QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
-			versionFunctions<QOpenGLFunctions_4_5_Core>();
-		fbo->Bind();
-		float rgb[3];
-		QPoint cursor(e_->pos());
-		f->glReadPixels(cursor.x(), height() - cursor.y(), 1, 1, GL_RGB, GL_FLOAT, rgb);
-		fbo->Unbind();
-
-		QVector4D color(rgb[0], rgb[1], rgb[2], 1.0);
-		int idx = modelManager->GetIndexFromColor(color);
-		if (idx >= 0) {
-			std::vector<Model3D*>& models = modelManager->GetModels();
-			bool onoff;
-			modelManager->ToggleSelection(idx, onoff);
-			qglviewer::Vec pos = modelManager->GetSelectedsCOG();
-			gizmo->SetPosition(pos);
-			gizmo->AdjustScale(*camera());
-			if (onoff) 
-				gizmo->Followed(*models[idx]);
-			else
-				gizmo->UnFollowed(*models[idx]);
-		}	
+		qglviewer::Vec origin, direction;
+		camera()->convertClickToLine(e_->pos(), origin, direction);
+		picker.Pick(*modelManager,
+			QVector3D(origin[0], origin[1], origin[2]),
+			QVector3D(direction[0], direction[1], direction[2]), lastPick);
+		PickModel(lastPick.model);
 	}
 
 	QGLViewer::mousePressEvent(e_);
@@ -165,10 +391,29 @@ void Screen::mousePressEvent(QMouseEvent * e_)
 void Screen::mouseMoveEvent(QMouseEvent * e_)
 {
 	QPoint cursor(e_->pos());
+	if (regionMode == BOX_REGION) {
+		regionPoints.resize(1);
+		regionPoints.push_back(cursor);
+		update();
+		return;
+	}
+	if (regionMode == LASSO_REGION) {
+		if ((cursor - regionPoints.back()).manhattanLength() >= LASSO_SPACING)
+			regionPoints.push_back(cursor);
+		update();
+		return;
+	}
+
 	gizmo->MouseMoved(cursor, *camera());
 	//FIXME : should not depend on QGLviewer functions.
 	//need to handle mouse interaction with my own implementation.
-	if (gizmo->IsHover()) {
+	if (gizmo->IsHover() && gizmo == &gizmoScale) {
+		//GizmoScale drives its own drag, keep the camera still meanwhile
+		setManipulatedFrame(0);
+		setMouseBinding(Qt::NoModifier, Qt::LeftButton, CAMERA,
+			QGLViewer::MouseAction::NO_MOUSE_ACTION);
+	}
+	else if (gizmo->IsHover()) {
 		setManipulatedFrame(&gizmo->GetFrame());
 		if (gizmo == &gizmoTranslate)
 			setMouseBinding(Qt::NoModifier, Qt::LeftButton, FRAME,
@@ -189,15 +434,30 @@ void Screen::mouseMoveEvent(QMouseEvent * e_)
 
 void Screen::mouseReleaseEvent(QMouseEvent * e_)
 {
+	if (regionMode != NO_REGION) {
+		SelectRegion();
+		regionMode = NO_REGION;
+		regionPoints.clear();
+		update();
+		return;
+	}
+
 	gizmo->MouseReleased(e_->pos(), *camera());
 
 	QGLViewer::mouseReleaseEvent(e_);
+
+	//back to full resolution as soon as the interaction ends
+	mouseDown = e_->buttons() != Qt::NoButton;
+	update();
 }
 
 void Screen::wheelEvent(QWheelEvent * e_)
 {
 	QGLViewer::wheelEvent(e_);
 
+	wheeling = true;
+	wheelIdleTimer.start(WHEEL_IDLE_MS);
+
 	gizmo->AdjustScale(*camera());
 	update();
 }
@@ -1,44 +1,98 @@
 #pragma once
 
 #include <QGLViewer/qglviewer.h>
+#include <QElapsedTimer>
+#include <QTimer>
 
 #include "ShaderProgram.h"
+#include "ShaderManager.h"
 #include "Gizmo.h"
 #include "FBO.h"
+#include "Picker.h"
+#include "SelectionOverlay.h"
+#include "GpuTimer.h"
 #include "ModelManager.h"
-#include "CheckerBoard.h"
+#include "DrawList.h"
+#include "ProxyBox.h"
+#include "FrameGovernor.h"
 
 class Screen : public QGLViewer
 {
 private:
 	PhongShader *phong;
+	PhongTessShader *phongTess;
 	SolidColorShader *solid;
-	VertexColorShader *vertexColor;
+	GizmoShader *gizmoShader;
+	GroundShader *ground;
+	UpscaleShader *upscale;
+	ShaderManager shaderManager;
 
-	FBO* fbo;
+	Picker picker;
+	PickHit lastPick;
+
+	//shift drag selects with a rubber band, ctrl drag with a lasso
+	enum RegionMode {
+		NO_REGION, BOX_REGION, LASSO_REGION
+	};
+	RegionMode regionMode;
+	std::vector<QPoint> regionPoints;
+	SelectionOverlay selectionOverlay;
+
+	//main pass target, rendered at renderScale and upscaled to the window
+	FBO* sceneFbo;
+	VAO* screenTriangle;
+	GpuTimer* sceneTimer;
+	float renderScale;
+	float interactiveScale;
+	bool mouseDown;
+	bool wheeling;
+	QTimer wheelIdleTimer;
 
 	Gizmo* gizmo;
 	GizmoTranslate gizmoTranslate;
 	GizmoRotate gizmoRotate;
+	GizmoScale gizmoScale;
+
+	ProxyBox proxyBox;
+
+	//refines the meshes on the GPU with Phong tessellation
+	bool tessellation;
 
-	CheckerBoard checkerBoard;
+	FrameGovernor governor;
+	GpuTimer* frameTimer;
 
 	ModelManager* modelManager;
 
+	DrawList drawList;
+
+	QElapsedTimer startupTimer;
+	qint64 shaderSetupTime;
+	bool firstFrameDrawn;
+	bool shadersReported;
+
 public:
 	Screen(QWidget *parent = 0);
 	~Screen();
 
-	inline void SetModelManager(ModelManager& modelManager_) {
-		modelManager = &modelManager_;
-	}
+	void SetModelManager(ModelManager& modelManager_);
 
 	enum GizmoType {
-		TRANSLATE, ROTATE
+		TRANSLATE, ROTATE, SCALE
 	};
 	void SetGizmoType(GizmoType gizmoType_);
+	void SetTessellation(bool tessellation_);
+
+	inline FrameGovernor& GetGovernor() { return governor; }
+	inline const PickHit& GetLastPick() const { return lastPick; }
 
 private:
+	bool IsInteracting();
+	void UpdateRenderScale();
+	void PickModel(int idx_);
+	void SelectRegion();
+	void GetRegionPolygon(std::vector<QVector2D>& polygon_);
+	void FollowSelection();
+
 	virtual void init();
 	virtual void preDraw() {}
 	virtual void draw();
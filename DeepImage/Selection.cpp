@@ -0,0 +1,175 @@
+#include "Selection.h"
+
+#include <algorithm>
+
+Selection::Selection()
+	: batchDepth(0),
+	changed(false)
+{
+}
+
+void Selection::Resize(int count_)
+{
+	int old = (int)flags.size();
+	flags.resize(count_, 0);
+	if (count_ < old) {
+		BeginBatch();
+		Compact();
+		EndBatch();
+	}
+}
+
+bool Selection::Select(int idx_)
+{
+	if (flags[idx_])
+		return false;
+
+	flags[idx_] = 1;
+	indices.push_back(idx_);
+	Changed();
+	return true;
+}
+
+bool Selection::Deselect(int idx_)
+{
+	if (!flags[idx_])
+		return false;
+
+	//a single deselect keeps the order, so it pays one scan of the selected
+	//indices. region and bulk changes go through the batched overloads.
+	flags[idx_] = 0;
+	indices.erase(std::find(indices.begin(), indices.end(), idx_));
+	Changed();
+	return true;
+}
+
+bool Selection::Toggle(int idx_)
+{
+	if (flags[idx_]) {
+		Deselect(idx_);
+		return false;
+	}
+
+	Select(idx_);
+	return true;
+}
+
+void Selection::Select(const std::vector<int>& indices_)
+{
+	BeginBatch();
+	for (int i = 0; i < indices_.size(); i++) {
+		int idx = indices_[i];
+		if (flags[idx])
+			continue;
+		flags[idx] = 1;
+		indices.push_back(idx);
+		changed = true;
+	}
+	EndBatch();
+}
+
+void Selection::Deselect(const std::vector<int>& indices_)
+{
+	BeginBatch();
+	for (int i = 0; i < indices_.size(); i++)
+		flags[indices_[i]] = 0;
+	Compact();
+	EndBatch();
+}
+
+void Selection::Invert()
+{
+	if (flags.empty())
+		return;
+
+	//the previously unselected models are appended in index order
+	BeginBatch();
+	indices.clear();
+	for (int i = 0; i < flags.size(); i++) {
+		flags[i] = !flags[i];
+		if (flags[i])
+			indices.push_back(i);
+	}
+	changed = true;
+	EndBatch();
+}
+
+void Selection::Clear()
+{
+	if (indices.empty())
+		return;
+
+	BeginBatch();
+	for (int i = 0; i < indices.size(); i++)
+		flags[indices[i]] = 0;
+	indices.clear();
+	changed = true;
+	EndBatch();
+}
+
+void Selection::Remove(int idx_)
+{
+	int last = (int)flags.size() - 1;
+	if (flags[idx_] || flags[last])
+		changed = true;
+
+	int kept = 0;
+	for (int i = 0; i < indices.size(); i++) {
+		int idx = indices[i];
+		if (idx != idx_)
+			indices[kept++] = idx == last ? idx_ : idx;
+	}
+	indices.resize(kept);
+
+	flags[idx_] = flags[last];
+	flags.pop_back();
+
+	BeginBatch();
+	EndBatch();
+}
+
+void Selection::BeginBatch()
+{
+	batchDepth++;
+}
+
+void Selection::EndBatch()
+{
+	if (--batchDepth > 0 || !changed)
+		return;
+
+	changed = false;
+	for (int i = 0; i < listeners.size(); i++)
+		listeners[i]();
+}
+
+void Selection::AddListener(const Listener & listener_)
+{
+	listeners.push_back(listener_);
+}
+
+void Selection::Changed()
+{
+	changed = true;
+	if (batchDepth == 0) {
+		BeginBatch();
+		EndBatch();
+	}
+}
+
+void Selection::Compact()
+{
+	//drops the indices whose flag was cleared or that fell off the end,
+	//keeping the order of the rest in one pass
+	int count = (int)flags.size();
+	int kept = 0;
+	for (int i = 0; i < indices.size(); i++) {
+		int idx = indices[i];
+		if (idx < count && flags[idx])
+			indices[kept++] = idx;
+	}
+	if (kept != indices.size()) {
+		indices.resize(kept);
+		changed = true;
+	}
+}
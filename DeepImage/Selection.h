@@ -0,0 +1,59 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+//selection state of a set of models addressed by index. membership is a
+//per-model flag, so IsSelected is O(1) and safe to call from worker threads
+//while nothing modifies the selection. the ordered index vector keeps the
+//selection order for the gizmo and the centre of mass.
+class Selection
+{
+public:
+	typedef std::function<void()> Listener;
+
+private:
+	std::vector<unsigned char> flags;
+	std::vector<int> indices;
+
+	std::vector<Listener> listeners;
+	int batchDepth;
+	bool changed;
+
+public:
+	Selection();
+
+	//grows or shrinks the flag array, indices past count_ are deselected
+	void Resize(int count_);
+
+	//return whether the state of idx_ changed
+	bool Select(int idx_);
+	bool Deselect(int idx_);
+	//returns the new state of idx_
+	bool Toggle(int idx_);
+
+	//batched operations notify once for the whole call
+	void Select(const std::vector<int>& indices_);
+	void Deselect(const std::vector<int>& indices_);
+	void Invert();
+	void Clear();
+	//drops idx_ and renames the last index to idx_, like the swap and pop
+	//of SceneStore::Remove
+	void Remove(int idx_);
+
+	//nests, listeners are called once when the outermost batch ends and
+	//something changed
+	void BeginBatch();
+	void EndBatch();
+
+	void AddListener(const Listener& listener_);
+
+	inline bool IsSelected(int idx_) const { return flags[idx_] != 0; }
+	inline const std::vector<int>& GetIndices() const { return indices; }
+	inline int GetCount() const { return (int)indices.size(); }
+	inline bool IsEmpty() const { return indices.empty(); }
+
+private:
+	void Changed();
+	void Compact();
+};
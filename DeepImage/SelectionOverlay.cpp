@@ -0,0 +1,47 @@
+#include "SelectionOverlay.h"
+
+#include <QMatrix4x4>
+
+#include "VBOLayout.h"
+
+SelectionOverlay::SelectionOverlay()
+	: vao(0),
+	vbo(0)
+{
+}
+
+SelectionOverlay::~SelectionOverlay()
+{
+	delete vao;
+	delete vbo;
+}
+
+void SelectionOverlay::Init()
+{
+	vao = new VAO;
+	vbo = new VBO(0, 0);
+	VBOLayout layout;
+	layout.Push<float>(2);
+	vao->AddBuffer(*vbo, layout);
+}
+
+void SelectionOverlay::Draw(const std::vector<QVector2D>& points_, ShaderProgram & prog_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	if (points_.size() < 2)
+		return;
+
+	vbo->SetData(points_.data(), points_.size() * sizeof(QVector2D));
+
+	QMatrix4x4 identity;
+	prog_.Bind();
+	prog_.SetUniformMat4f("u_MVP", identity.constData());
+	prog_.SetUniform4f("u_Color", 1.0f, 0.8f, 0.0f, 1.0f);
+
+	f->glDisable(GL_DEPTH_TEST);
+	vao->Bind();
+	f->glDrawArrays(GL_LINE_LOOP, 0, (int)points_.size());
+	f->glEnable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+#include <QVector2D>
+
+#include "VAO.h"
+#include "VBO.h"
+#include "ShaderProgram.h"
+
+//outline of the rubber band or lasso, streamed into a dynamic VBO
+//every frame while the region is dragged
+class SelectionOverlay
+{
+private:
+	VAO* vao;
+	VBO* vbo;
+
+public:
+	SelectionOverlay();
+	~SelectionOverlay();
+
+	void Init();
+	//closed outline through points_, in normalized device coordinates
+	void Draw(const std::vector<QVector2D>& points_, ShaderProgram& prog_);
+};
@@ -0,0 +1,97 @@
+#include "ShaderCache.h"
+
+#include <QOpenGLFunctions_4_5_Core>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <cstring>
+#include <vector>
+
+ShaderCache::ShaderCache()
+{
+	QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+		"/shaders";
+	QDir().mkpath(dir);
+	cacheDir = dir.toStdString();
+}
+
+ShaderCache & ShaderCache::Instance()
+{
+	static ShaderCache cache;
+	return cache;
+}
+
+std::string ShaderCache::MakeKey(const std::string & vs_, const std::string & fs_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	if (driverKey.empty()) {
+		driverKey = std::string((const char*)f->glGetString(GL_VENDOR)) + "|" +
+			(const char*)f->glGetString(GL_RENDERER) + "|" +
+			(const char*)f->glGetString(GL_VERSION);
+	}
+
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	hash.addData(driverKey.data(), (int)driverKey.size());
+	hash.addData(vs_.data(), (int)vs_.size());
+	hash.addData(fs_.data(), (int)fs_.size());
+	return hash.result().toHex().toStdString();
+}
+
+bool ShaderCache::Load(unsigned int program_, const std::string & key_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	QFile file(QString::fromStdString(FilePath(key_)));
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QByteArray bytes = file.readAll();
+	if (bytes.size() <= (int)sizeof(unsigned int))
+		return false;
+
+	unsigned int format;
+	memcpy(&format, bytes.constData(), sizeof(unsigned int));
+	f->glProgramBinary(program_, format, bytes.constData() + sizeof(unsigned int),
+		bytes.size() - (int)sizeof(unsigned int));
+
+	//the driver may still reject a binary it produced itself
+	int result;
+	f->glGetProgramiv(program_, GL_LINK_STATUS, &result);
+	if (result == GL_FALSE) {
+		file.close();
+		file.remove();
+		return false;
+	}
+
+	return true;
+}
+
+void ShaderCache::Store(unsigned int program_, const std::string & key_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	int length = 0;
+	f->glGetProgramiv(program_, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+
+	std::vector<char> binary(length);
+	unsigned int format;
+	f->glGetProgramBinary(program_, length, &length, &format, binary.data());
+
+	QFile file(QString::fromStdString(FilePath(key_)));
+	if (!file.open(QIODevice::WriteOnly))
+		return;
+	file.write((const char*)&format, sizeof(unsigned int));
+	file.write(binary.data(), length);
+}
+
+std::string ShaderCache::FilePath(const std::string & key_) const
+{
+	return cacheDir + "/" + key_ + ".bin";
+}
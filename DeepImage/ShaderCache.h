@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+
+//on-disk cache of linked program binaries. entries are keyed by the
+//driver (vendor, renderer, version) and the shader sources, so a driver
+//update or a shader edit simply misses instead of loading a stale binary.
+class ShaderCache
+{
+private:
+	std::string cacheDir;
+	std::string driverKey;
+
+public:
+	ShaderCache();
+
+	static ShaderCache& Instance();
+
+	std::string MakeKey(const std::string& vs_, const std::string& fs_);
+
+	bool Load(unsigned int program_, const std::string& key_);
+	void Store(unsigned int program_, const std::string& key_);
+
+private:
+	std::string FilePath(const std::string& key_) const;
+};
@@ -0,0 +1,65 @@
+#include "ShaderManager.h"
+
+#include <QOpenGLContext>
+
+typedef void (QOPENGLF_APIENTRYP MaxShaderCompilerThreadsProc)(unsigned int count);
+
+ShaderManager::ShaderManager()
+	: parallelCompile(false),
+	pendingCount(0)
+{
+}
+
+void ShaderManager::Add(ShaderProgram * program_)
+{
+	programs.push_back(program_);
+}
+
+void ShaderManager::SubmitAll()
+{
+	QOpenGLContext* context = QOpenGLContext::currentContext();
+
+	const char* procName = 0;
+	if (context->hasExtension("GL_KHR_parallel_shader_compile"))
+		procName = "glMaxShaderCompilerThreadsKHR";
+	else if (context->hasExtension("GL_ARB_parallel_shader_compile"))
+		procName = "glMaxShaderCompilerThreadsARB";
+
+	if (procName) {
+		MaxShaderCompilerThreadsProc maxThreads =
+			(MaxShaderCompilerThreadsProc)context->getProcAddress(procName);
+		//0xFFFFFFFF lets the driver pick its own thread count
+		if (maxThreads)
+			maxThreads(0xFFFFFFFF);
+		parallelCompile = true;
+	}
+
+	for (int i = 0; i < programs.size(); i++)
+		programs[i]->Submit();
+
+	pendingCount = (int)programs.size();
+	Poll();
+}
+
+bool ShaderManager::Poll()
+{
+	if (pendingCount == 0)
+		return true;
+
+	pendingCount = 0;
+	for (int i = 0; i < programs.size(); i++) {
+		ShaderProgram::Status before = programs[i]->GetStatus();
+		if (before == ShaderProgram::READY || before == ShaderProgram::FAILED)
+			continue;
+
+		if (!programs[i]->Poll(parallelCompile)) {
+			pendingCount++;
+			continue;
+		}
+
+		if (programs[i]->GetStatus() == ShaderProgram::FAILED && errorCallback)
+			errorCallback(programs[i]->GetName(), programs[i]->GetErrorLog());
+	}
+
+	return pendingCount == 0;
+}
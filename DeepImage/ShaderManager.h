@@ -0,0 +1,38 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "ShaderProgram.h"
+
+//submits every registered program before asking for any result, then
+//polls them once per frame. with KHR_parallel_shader_compile the driver
+//compiles in the background and the first frames simply skip the passes
+//whose program is not ready yet.
+class ShaderManager
+{
+public:
+	typedef std::function<void(const std::string&, const std::string&)> ErrorCallback;
+
+private:
+	std::vector<ShaderProgram*> programs;
+	ErrorCallback errorCallback;
+
+	bool parallelCompile;
+	int pendingCount;
+
+public:
+	ShaderManager();
+
+	void Add(ShaderProgram* program_);
+
+	void SubmitAll();
+	//returns true once nothing is left compiling
+	bool Poll();
+
+	inline void SetErrorCallback(ErrorCallback callback_) { errorCallback = callback_; }
+
+	inline bool IsParallel() const { return parallelCompile; }
+	inline bool HasPending() const { return pendingCount > 0; }
+};
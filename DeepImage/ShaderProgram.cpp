@@ -1,24 +1,121 @@
 #include "ShaderProgram.h"
 
 #include <QOpenGLFunctions_4_5_Core>
-#include <fstream>
-#include <iostream>
+#include <QFile>
+
+#include "ShaderCache.h"
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
 
 ShaderProgram::ShaderProgram(const std::string & vsFilePath_, const std::string & fsFilePath_)
+	: id(0),
+	vertexShader(0),
+	fragmentShader(0),
+	controlShader(0),
+	evaluationShader(0),
+	status(PENDING)
 {
-	std::string vs = LoadShader(vsFilePath_);
-	std::string fs = LoadShader(fsFilePath_);
+	vsSource = LoadShader(vsFilePath_);
+	fsSource = LoadShader(fsFilePath_);
 
-	id = CreateShaderProgram(vs, fs);
+	name = vsFilePath_.substr(vsFilePath_.find_last_of('/') + 1);
+	name = name.substr(0, name.find_last_of('.'));
+}
+
+ShaderProgram::ShaderProgram(const std::string & vsFilePath_, const std::string & tcsFilePath_,
+	const std::string & tesFilePath_, const std::string & fsFilePath_)
+	: ShaderProgram(vsFilePath_, fsFilePath_)
+{
+	tcsSource = LoadShader(tcsFilePath_);
+	tesSource = LoadShader(tesFilePath_);
 }
 
 ShaderProgram::~ShaderProgram()
 {
 	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
 		versionFunctions<QOpenGLFunctions_4_5_Core>();
+	ReleaseShaders();
 	f->glDeleteProgram(id);
 }
 
+void ShaderProgram::Submit()
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+	if (status != PENDING)
+		return;
+
+	id = f->glCreateProgram();
+
+	ShaderCache& cache = ShaderCache::Instance();
+	cacheKey = cache.MakeKey(vsSource + tcsSource + tesSource, fsSource);
+	if (cache.Load(id, cacheKey)) {
+		status = READY;
+		return;
+	}
+
+	vertexShader = CompileShader(GL_VERTEX_SHADER, vsSource);
+	fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fsSource);
+	f->glAttachShader(id, vertexShader);
+	f->glAttachShader(id, fragmentShader);
+	if (!tesSource.empty()) {
+		controlShader = CompileShader(GL_TESS_CONTROL_SHADER, tcsSource);
+		evaluationShader = CompileShader(GL_TESS_EVALUATION_SHADER, tesSource);
+		f->glAttachShader(id, controlShader);
+		f->glAttachShader(id, evaluationShader);
+	}
+	f->glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	f->glLinkProgram(id);
+
+	status = LINKING;
+}
+
+bool ShaderProgram::Poll(bool asyncQuery_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+	if (status != LINKING)
+		return status != PENDING;
+
+	int result;
+	if (asyncQuery_) {
+		f->glGetProgramiv(id, GL_COMPLETION_STATUS_KHR, &result);
+		if (result == GL_FALSE)
+			return false;
+	}
+
+	f->glGetProgramiv(id, GL_LINK_STATUS, &result);
+	if (result == GL_FALSE) {
+		errorLog += ShaderLog(vertexShader) + ShaderLog(controlShader) +
+			ShaderLog(evaluationShader) + ShaderLog(fragmentShader);
+
+		int length;
+		f->glGetProgramiv(id, GL_INFO_LOG_LENGTH, &length);
+		if (length > 0) {
+			std::string message(length, '\0');
+			f->glGetProgramInfoLog(id, length, &length, &message[0]);
+			message.resize(length);
+			errorLog += message;
+		}
+
+		ReleaseShaders();
+		status = FAILED;
+		return true;
+	}
+
+	ReleaseShaders();
+
+#ifndef QT_NO_DEBUG
+	f->glValidateProgram(id);
+#endif
+
+	ShaderCache::Instance().Store(id, cacheKey);
+	status = READY;
+	return true;
+}
+
 void ShaderProgram::Bind() const
 {
 	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
@@ -40,6 +137,34 @@ void ShaderProgram::SetUniform1i(const std::string & name_, int value_)
 	f->glUniform1i(GetUniformLocation(name_), value_);
 }
 
+void ShaderProgram::SetUniform1ui(const std::string & name_, unsigned int value_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+	f->glUniform1ui(GetUniformLocation(name_), value_);
+}
+
+void ShaderProgram::SetUniform1f(const std::string & name_, float value_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+	f->glUniform1f(GetUniformLocation(name_), value_);
+}
+
+void ShaderProgram::SetUniform2f(const std::string & name_, float v0_, float v1_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+	f->glUniform2f(GetUniformLocation(name_), v0_, v1_);
+}
+
+void ShaderProgram::SetUniform3f(const std::string & name_, float v0_, float v1_, float v2_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+	f->glUniform3f(GetUniformLocation(name_), v0_, v1_, v2_);
+}
+
 void ShaderProgram::SetUniform4f(const std::string & name_, float v0_, float v1_, float v2_, float v3_)
 {
 	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
@@ -47,7 +172,14 @@ void ShaderProgram::SetUniform4f(const std::string & name_, float v0_, float v1_
 	f->glUniform4f(GetUniformLocation(name_), v0_, v1_, v2_, v3_);
 }
 
-void ShaderProgram::SetUniformMat4f(const std::string & name_, float * mat_)
+void ShaderProgram::SetUniformMat3f(const std::string & name_, const float * mat_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+	f->glUniformMatrix3fv(GetUniformLocation(name_), 1, GL_FALSE, mat_);
+}
+
+void ShaderProgram::SetUniformMat4f(const std::string & name_, const float * mat_)
 {
 	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
 		versionFunctions<QOpenGLFunctions_4_5_Core>();
@@ -56,14 +188,13 @@ void ShaderProgram::SetUniformMat4f(const std::string & name_, float * mat_)
 
 std::string ShaderProgram::LoadShader(const std::string & filepath_)
 {
-	std::ifstream stream(filepath_);
-
-	std::string whole, line;
-	while (getline(stream, line)) {
-		whole = whole + line + '\n';
+	QFile file(QString::fromStdString(filepath_));
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		errorLog += "cannot open " + filepath_ + "\n";
+		return std::string();
 	}
 
-	return whole;
+	return file.readAll().toStdString();
 }
 
 unsigned int ShaderProgram::CompileShader(unsigned int type_, const std::string & source_)
@@ -75,42 +206,49 @@ unsigned int ShaderProgram::CompileShader(unsigned int type_, const std::string
 	f->glShaderSource(id, 1, &src, 0);
 	f->glCompileShader(id);
 
-	int result;
-	f->glGetShaderiv(id, GL_COMPILE_STATUS, &result);
-	if (result == GL_FALSE) {
-		int length;
-		f->glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
-
-		char *message = new char[length];
-		f->glGetShaderInfoLog(id, length, &length, message);
+	return id;
+}
 
-		std::cout << "Failed to compile shader!" << std::endl;
-		std::cout << message << std::endl;
+std::string ShaderProgram::ShaderLog(unsigned int shader_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
 
-		delete message;
+	if (shader_ == 0)
+		return std::string();
 
-		return 0;
-	}
-
-	return id;
+	int result;
+	f->glGetShaderiv(shader_, GL_COMPILE_STATUS, &result);
+	if (result == GL_TRUE)
+		return std::string();
+
+	int length;
+	f->glGetShaderiv(shader_, GL_INFO_LOG_LENGTH, &length);
+	if (length <= 0)
+		return std::string();
+
+	std::string message(length, '\0');
+	f->glGetShaderInfoLog(shader_, length, &length, &message[0]);
+	message.resize(length);
+	return message;
 }
 
-unsigned int ShaderProgram::CreateShaderProgram(std::string vs_, std::string fs_)
+void ShaderProgram::ReleaseShaders()
 {
 	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
 		versionFunctions<QOpenGLFunctions_4_5_Core>();
-	unsigned int program = f->glCreateProgram();
-	unsigned int vertexShader = CompileShader(GL_VERTEX_SHADER, vs_);
-	unsigned int fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fs_);
-	f->glAttachShader(program, vertexShader);
-	f->glAttachShader(program, fragmentShader);
-	f->glLinkProgram(program);
-	f->glValidateProgram(program);
-
-	f->glDeleteShader(vertexShader);
-	f->glDeleteShader(fragmentShader);
 
-	return program;
+	unsigned int shaders[4] = {
+		vertexShader, controlShader, evaluationShader, fragmentShader
+	};
+	for (int i = 0; i < 4; i++) {
+		if (shaders[i] == 0)
+			continue;
+		f->glDetachShader(id, shaders[i]);
+		f->glDeleteShader(shaders[i]);
+	}
+	vertexShader = fragmentShader = 0;
+	controlShader = evaluationShader = 0;
 }
 
 int ShaderProgram::GetUniformLocation(const std::string & name_)
@@ -127,63 +265,135 @@ int ShaderProgram::GetUniformLocation(const std::string & name_)
 }
 
 PhongShader::PhongShader()
-	: ShaderProgram("res/shaders/Phong.vertex",
-		"res/shaders/Phong.fragment")
+	: ShaderProgram(":/DeepImage/res/shaders/Phong.vertex",
+		":/DeepImage/res/shaders/Phong.fragment")
 {
 
 }
 
-void PhongShader::Predraw(QMatrix4x4 view_, QMatrix4x4 proj_, Model3D & model_)
+void PhongShader::Predraw(QMatrix4x4 view_, QMatrix4x4 proj_,
+	QMatrix4x4 model_, QVector4D color_)
 {
 	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
 		versionFunctions<QOpenGLFunctions_4_5_Core>();
 
-	QMatrix4x4 modelMatrix = model_.ModelMatrix();
-	QMatrix4x4 mv = view_ * modelMatrix;
-
-	QVector4D color = model_.GetColor();
+	QMatrix4x4 mv = view_ * model_;
 
 	Bind();
 	SetUniformMat4f("u_ModelView", mv.data());
+	SetUniformMat3f("u_NormalMatrix", mv.normalMatrix().constData());
 	SetUniformMat4f("u_Proj", proj_.data());
-	SetUniform4f("u_Color", color[0], color[1], color[2], color[3]);
+	SetUniform4f("u_Color", color_[0], color_[1], color_[2], color_[3]);
+}
+
+PhongTessShader::PhongTessShader()
+	: ShaderProgram(":/DeepImage/res/shaders/PhongTess.vertex",
+		":/DeepImage/res/shaders/PhongTess.control",
+		":/DeepImage/res/shaders/PhongTess.evaluation",
+		":/DeepImage/res/shaders/Phong.fragment")
+{
+}
+
+void PhongTessShader::SetTessellation(int viewportWidth_, int viewportHeight_,
+	float edgePixels_)
+{
+	Bind();
+	SetUniform2f("u_Viewport", (float)viewportWidth_, (float)viewportHeight_);
+	SetUniform1f("u_EdgePixels", edgePixels_);
 }
 
 SolidColorShader::SolidColorShader()
-	: ShaderProgram("res/shaders/BasicColor.vertex",
-		"res/shaders/BasicColor.fragment")
+	: ShaderProgram(":/DeepImage/res/shaders/BasicColor.vertex",
+		":/DeepImage/res/shaders/BasicColor.fragment")
 {
 }
 
-void SolidColorShader::Predraw(QMatrix4x4 view_, QMatrix4x4 proj_, Model3D & model_)
+void SolidColorShader::Predraw(QMatrix4x4 view_, QMatrix4x4 proj_,
+	QMatrix4x4 model_, QVector4D color_)
 {
 	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
 		versionFunctions<QOpenGLFunctions_4_5_Core>();
 
-	QMatrix4x4 modelMatrix = model_.ModelMatrix();
-	QMatrix4x4 mvp = proj_ * view_ * modelMatrix;
-
-	QVector4D color = model_.GetColor();
+	QMatrix4x4 mvp = proj_ * view_ * model_;
 
 	Bind();
 	SetUniformMat4f("u_MVP", mvp.data());
-	SetUniform4f("u_Color", color[0], color[1], color[2], color[3]);
+	SetUniform4f("u_Color", color_[0], color_[1], color_[2], color_[3]);
 }
 
 VertexColorShader::VertexColorShader()
-	: ShaderProgram("res/shaders/BasicVertexColor.vertex",
-		"res/shaders/BasicVertexColor.fragment")
+	: ShaderProgram(":/DeepImage/res/shaders/BasicVertexColor.vertex",
+		":/DeepImage/res/shaders/BasicVertexColor.fragment")
 {
 }
 
-void VertexColorShader::Predraw(QMatrix4x4 view_, QMatrix4x4 proj_, Model3D & model_)
+void VertexColorShader::Predraw(QMatrix4x4 view_, QMatrix4x4 proj_,
+	QMatrix4x4 model_, QVector4D color_)
 {
 	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
 		versionFunctions<QOpenGLFunctions_4_5_Core>();
 
-	QMatrix4x4 modelMatrix = model_.ModelMatrix();
-	QMatrix4x4 mvp = proj_ * view_ * modelMatrix;
+	QMatrix4x4 mvp = proj_ * view_ * model_;
 
 	Bind();
 	SetUniformMat4f("u_MVP", mvp.data());
 }
+
+GBufferShader::GBufferShader()
+	: ShaderProgram(":/DeepImage/res/shaders/GBuffer.vertex",
+		":/DeepImage/res/shaders/GBuffer.fragment")
+{
+}
+
+GizmoShader::GizmoShader()
+	: ShaderProgram(":/DeepImage/res/shaders/Gizmo.vertex",
+		":/DeepImage/res/shaders/Gizmo.fragment")
+{
+}
+
+GroundShader::GroundShader()
+	: ShaderProgram(":/DeepImage/res/shaders/Ground.vertex",
+		":/DeepImage/res/shaders/Ground.fragment")
+{
+}
+
+void GroundShader::Predraw(QMatrix4x4 view_, QMatrix4x4 proj_,
+	QVector3D background_, float fadeDistance_)
+{
+	//the view is rigid, the inverse rotation is the normal matrix of the
+	//inverse and its translation is the eye
+	QMatrix4x4 viewInv = view_.inverted();
+	QMatrix3x3 viewToWorld = viewInv.normalMatrix();
+	QVector4D eye = viewInv.column(3);
+	QMatrix4x4 projInv = proj_.inverted();
+
+	Bind();
+	SetUniformMat4f("u_Proj", proj_.data());
+	SetUniformMat4f("u_InvProj", projInv.data());
+	SetUniformMat3f("u_ViewToWorld", viewToWorld.constData());
+	SetUniform3f("u_Eye", eye.x(), eye.y(), eye.z());
+	SetUniform3f("u_Background", background_.x(), background_.y(), background_.z());
+	SetUniform1f("u_FadeDistance", fadeDistance_);
+}
+
+UpscaleShader::UpscaleShader()
+	: ShaderProgram(":/DeepImage/res/shaders/Upscale.vertex",
+		":/DeepImage/res/shaders/Upscale.fragment")
+{
+}
+
+void UpscaleShader::Predraw(unsigned int texture_, float uScale_, float vScale_,
+	int sourceWidth_, int sourceHeight_, float sharpness_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	f->glActiveTexture(GL_TEXTURE0);
+	f->glBindTexture(GL_TEXTURE_2D, texture_);
+
+	Bind();
+	SetUniform1i("u_Texture", 0);
+	SetUniform2f("u_UVScale", uScale_, vScale_);
+	SetUniform2f("u_TexelSize", 1.0f / sourceWidth_, 1.0f / sourceHeight_);
+	SetUniform1f("u_Sharpness", sharpness_);
+}
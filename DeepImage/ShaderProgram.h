@@ -3,31 +3,69 @@
 #include <string>
 #include <unordered_map>
 #include <QMatrix4x4>
-
-#include "Model3D.h"
+#include <QVector3D>
+#include <QVector4D>
 
 class ShaderProgram {
+public:
+	enum Status {
+		PENDING, LINKING, READY, FAILED
+	};
+
 private:
 	unsigned int id;
+	unsigned int vertexShader, fragmentShader;
+	unsigned int controlShader, evaluationShader;
 	std::unordered_map<std::string, int> uniformLocationCache;
 
+	std::string name;
+	std::string vsSource, fsSource;
+	//tessellation stages, empty for programs without them
+	std::string tcsSource, tesSource;
+	std::string cacheKey;
+	std::string errorLog;
+	Status status;
+
 public:
 	ShaderProgram(const std::string& vsFilePath_, const std::string& fsFilePath_);
+	ShaderProgram(const std::string& vsFilePath_, const std::string& tcsFilePath_,
+		const std::string& tesFilePath_, const std::string& fsFilePath_);
 	~ShaderProgram();
 
-	virtual void Predraw(QMatrix4x4 view_, QMatrix4x4 proj_, Model3D& model_) {}
+	virtual void Predraw(QMatrix4x4 view_, QMatrix4x4 proj_,
+		QMatrix4x4 model_, QVector4D color_) {}
+
+	//issues compile and link without querying any status, so the driver
+	//can work on several programs at once. Poll() finishes the job.
+	void Submit();
+	//returns false while the driver is still busy. blocks on drivers
+	//without KHR_parallel_shader_compile.
+	bool Poll(bool asyncQuery_);
+
+	inline bool IsReady() const { return status == READY; }
+	//true for programs drawn as GL_PATCHES
+	inline bool IsTessellated() const { return !tesSource.empty(); }
+	inline Status GetStatus() const { return status; }
+	inline const std::string& GetName() const { return name; }
+	inline const std::string& GetErrorLog() const { return errorLog; }
 
 	void Bind() const;
 	void Unbind() const;
 
 	void SetUniform1i(const std::string& name_, int value_);
+	void SetUniform1ui(const std::string& name_, unsigned int value_);
+	void SetUniform1f(const std::string& name_, float value_);
+	void SetUniform2f(const std::string& name_, float v0_, float v1_);
+	void SetUniform3f(const std::string& name_, float v0_, float v1_, float v2_);
 	void SetUniform4f(const std::string& name_, float v0_, float v1_, float v2_, float v3_);
-	void SetUniformMat4f(const std::string& name_, float* mat_);
+	void SetUniformMat3f(const std::string& name_, const float* mat_);
+	void SetUniformMat4f(const std::string& name_, const float* mat_);
 
 private:
 	std::string LoadShader(const std::string& filepath_);
 	unsigned int CompileShader(unsigned int type_, const std::string& source_);
-	unsigned int CreateShaderProgram(std::string vs_, std::string fs_);
+	std::string ShaderLog(unsigned int shader_);
+	void ReleaseShaders();
 
 	int GetUniformLocation(const std::string& name_);
 };
@@ -38,7 +76,22 @@ public:
 	PhongShader();
 	~PhongShader() {}
 
-	virtual void Predraw(QMatrix4x4 view_, QMatrix4x4 proj_, Model3D& model_);
+	virtual void Predraw(QMatrix4x4 view_, QMatrix4x4 proj_,
+		QMatrix4x4 model_, QVector4D color_);
+};
+
+//phong shading of triangles refined on the GPU, see PhongTess.control.
+//every triangle is a patch, its vertices are projected onto the tangent
+//planes of the corners (Phong tessellation), so silhouettes round off
+//without a refined mesh in memory. edges are split until they are about
+//edgePixels_ long on screen.
+class PhongTessShader : public ShaderProgram
+{
+public:
+	PhongTessShader();
+	~PhongTessShader() {}
+
+	void SetTessellation(int viewportWidth_, int viewportHeight_, float edgePixels_);
 };
 
 class SolidColorShader : public ShaderProgram
@@ -47,7 +100,8 @@ public:
 	SolidColorShader();
 	~SolidColorShader() {}
 
-	virtual void Predraw(QMatrix4x4 view_, QMatrix4x4 proj_, Model3D& model_);
+	virtual void Predraw(QMatrix4x4 view_, QMatrix4x4 proj_,
+		QMatrix4x4 model_, QVector4D color_);
 };
 
 class VertexColorShader : public ShaderProgram
@@ -56,5 +110,45 @@ public:
 	VertexColorShader();
 	~VertexColorShader() {}
 
-	virtual void Predraw(QMatrix4x4 view_, QMatrix4x4 proj_, Model3D& model_);
+	virtual void Predraw(QMatrix4x4 view_, QMatrix4x4 proj_,
+		QMatrix4x4 model_, QVector4D color_);
+};
+
+//shaded color, view space normal with linear depth and the model
+//index in one pass, see DrawList::SubmitGBuffer
+class GBufferShader : public ShaderProgram
+{
+public:
+	GBufferShader();
+	~GBufferShader() {}
+};
+
+//instanced gizmo handles, see Gizmo::DrawGeometry
+class GizmoShader : public ShaderProgram
+{
+public:
+	GizmoShader();
+	~GizmoShader() {}
+};
+
+//infinite ground plane at z = 0 drawn from a full-screen triangle,
+//squares fade out towards fadeDistance_ into the background color
+class GroundShader : public ShaderProgram
+{
+public:
+	GroundShader();
+	~GroundShader() {}
+
+	void Predraw(QMatrix4x4 view_, QMatrix4x4 proj_,
+		QVector3D background_, float fadeDistance_);
+};
+
+class UpscaleShader : public ShaderProgram
+{
+public:
+	UpscaleShader();
+	~UpscaleShader() {}
+
+	void Predraw(unsigned int texture_, float uScale_, float vScale_,
+		int sourceWidth_, int sourceHeight_, float sharpness_);
 };
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+static thread_local int workerIndex = -1;
+
+ThreadPool::ThreadPool(int threadCount_)
+	: pending(0),
+	nextQueue(0),
+	quit(false)
+{
+	int count = threadCount_;
+	if (count <= 0)
+		count = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+
+	for (int i = 0; i < count; i++)
+		workers.push_back(new Worker);
+	for (int i = 0; i < count; i++)
+		threads.push_back(std::thread(&ThreadPool::Run, this, i));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		quit = true;
+	}
+	sleepCondition.notify_all();
+
+	for (int i = 0; i < threads.size(); i++)
+		threads[i].join();
+	for (int i = 0; i < workers.size(); i++)
+		delete workers[i];
+}
+
+ThreadPool & ThreadPool::Instance()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::Submit(std::function<void()> task_)
+{
+	//workers push onto their own queue, everyone else spreads round-robin
+	int idx = workerIndex;
+	if (idx < 0)
+		idx = nextQueue++ % workers.size();
+
+	{
+		std::lock_guard<std::mutex> lock(workers[idx]->mutex);
+		workers[idx]->tasks.push_back(std::move(task_));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		pending++;
+	}
+	sleepCondition.notify_one();
+}
+
+void ThreadPool::ParallelFor(int begin_, int end_, int grain_,
+	const std::function<void(int, int)>& func_)
+{
+	if (end_ <= begin_)
+		return;
+
+	int grain = std::max(1, grain_);
+	int chunkCount = (end_ - begin_ + grain - 1) / grain;
+	if (chunkCount == 1) {
+		func_(begin_, end_);
+		return;
+	}
+
+	//helpers may be dequeued after the loop returned, they only touch
+	//the shared state then and find no chunk left
+	std::shared_ptr<Loop> loop = std::make_shared<Loop>();
+	loop->func = &func_;
+	loop->begin = begin_;
+	loop->end = end_;
+	loop->grain = grain;
+	loop->chunkCount = chunkCount;
+	loop->nextChunk = 0;
+	loop->doneCount = 0;
+	loop->failed = false;
+
+	int helperCount = std::min(chunkCount - 1, (int)workers.size());
+	for (int i = 0; i < helperCount; i++)
+		Submit([loop]() { RunChunks(*loop); });
+
+	RunChunks(*loop);
+
+	//the chunks still running were claimed by workers already busy on them,
+	//func_ has to outlive them even when one of them threw
+	std::unique_lock<std::mutex> lock(loop->mutex);
+	loop->doneCondition.wait(lock, [&loop]() {
+		return loop->doneCount == loop->chunkCount;
+	});
+	if (loop->error)
+		std::rethrow_exception(loop->error);
+}
+
+void ThreadPool::RunChunks(Loop & loop_)
+{
+	while (true) {
+		int chunk = loop_.nextChunk++;
+		if (chunk >= loop_.chunkCount)
+			return;
+
+		if (!loop_.failed) {
+			int b = loop_.begin + chunk * loop_.grain;
+			int e = std::min(loop_.end, b + loop_.grain);
+			try {
+				(*loop_.func)(b, e);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(loop_.mutex);
+				if (!loop_.error)
+					loop_.error = std::current_exception();
+				loop_.failed = true;
+			}
+		}
+
+		if (++loop_.doneCount == loop_.chunkCount) {
+			std::lock_guard<std::mutex> lock(loop_.mutex);
+			loop_.doneCondition.notify_all();
+		}
+	}
+}
+
+void ThreadPool::Run(int idx_)
+{
+	workerIndex = idx_;
+
+	while (true) {
+		if (RunOne(idx_))
+			continue;
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepCondition.wait(lock, [this]() { return quit || pending > 0; });
+		if (quit && pending == 0)
+			return;
+	}
+}
+
+bool ThreadPool::PopLocal(int idx_, std::function<void()>& task_)
+{
+	if (idx_ < 0)
+		return false;
+
+	//owner takes the newest task, it is the most likely to be cache-hot
+	Worker* worker = workers[idx_];
+	std::lock_guard<std::mutex> lock(worker->mutex);
+	if (worker->tasks.empty())
+		return false;
+	task_ = std::move(worker->tasks.back());
+	worker->tasks.pop_back();
+	return true;
+}
+
+bool ThreadPool::Steal(int idx_, std::function<void()>& task_)
+{
+	//thieves take the oldest task from the other end of the victim's queue
+	int count = (int)workers.size();
+	int start = idx_ < 0 ? 0 : idx_ + 1;
+	for (int i = 0; i < count; i++) {
+		Worker* victim = workers[(start + i) % count];
+		std::unique_lock<std::mutex> lock(victim->mutex, std::try_to_lock);
+		if (!lock.owns_lock() || victim->tasks.empty())
+			continue;
+		task_ = std::move(victim->tasks.front());
+		victim->tasks.pop_front();
+		return true;
+	}
+
+	return false;
+}
+
+bool ThreadPool::RunOne(int idx_)
+{
+	std::function<void()> task;
+	if (!PopLocal(idx_, task) && !Steal(idx_, task))
+		return false;
+
+	pending--;
+	task();
+	return true;
+}
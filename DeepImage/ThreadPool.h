@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+private:
+	struct Worker {
+		std::deque<std::function<void()>> tasks;
+		std::mutex mutex;
+	};
+
+	//chunks of one ParallelFor, claimed by the caller and its helpers
+	struct Loop {
+		const std::function<void(int, int)>* func;
+		int begin;
+		int end;
+		int grain;
+		int chunkCount;
+		std::atomic<int> nextChunk;
+		std::atomic<int> doneCount;
+		std::mutex mutex;
+		std::condition_variable doneCondition;
+		//first exception thrown by a chunk, the chunks claimed after it
+		//are skipped and the caller rethrows it
+		std::exception_ptr error;
+		std::atomic<bool> failed;
+	};
+
+	std::vector<Worker*> workers;
+	std::vector<std::thread> threads;
+
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+	std::atomic<int> pending;
+	std::atomic<unsigned int> nextQueue;
+	bool quit;
+
+public:
+	ThreadPool(int threadCount_ = 0);
+	~ThreadPool();
+
+	static ThreadPool& Instance();
+
+	void Submit(std::function<void()> task_);
+
+	//splits [begin_, end_) into chunks of at most grain_ and blocks
+	//until all of them ran. the calling thread works through the chunks
+	//too but never runs other queued tasks, so a GUI thread waiting here
+	//does not pick up some long unrelated job, and nested calls from
+	//inside a task cannot deadlock since the caller can finish every
+	//chunk alone. an exception thrown by a chunk is rethrown here once
+	//every chunk is done or skipped.
+	void ParallelFor(int begin_, int end_, int grain_,
+		const std::function<void(int, int)>& func_);
+
+	inline int GetThreadCount() const { return (int)threads.size(); }
+
+private:
+	void Run(int idx_);
+
+	bool PopLocal(int idx_, std::function<void()>& task_);
+	bool Steal(int idx_, std::function<void()>& task_);
+	bool RunOne(int idx_);
+	static void RunChunks(Loop& loop_);
+};
@@ -1,5 +1,71 @@
 #include "TriMesh.h"
 
+#include "ResourceTracker.h"
+
+TriMesh::TriMesh()
+	: trackedBytes(0),
+	owner(ResourceTracker::SHARED_OWNER)
+{
+}
+
+TriMesh::TriMesh(const TriMesh & other_)
+	: OpenMesh::TriMesh_ArrayKernelT<HCCLTraits>(other_),
+	trackedBytes(0),
+	owner(-1)
+{
+}
+
+TriMesh::~TriMesh()
+{
+	if (owner >= 0)
+		ResourceTracker::Instance().Free(ResourceTracker::HALF_EDGE_MESH,
+			owner, trackedBytes);
+}
+
+TriMesh & TriMesh::operator=(const TriMesh & other_)
+{
+	OpenMesh::TriMesh_ArrayKernelT<HCCLTraits>::operator=(other_);
+	return *this;
+}
+
+size_t TriMesh::GetMemoryBytes() const
+{
+	//array kernel connectivity: a halfedge handle per vertex and face,
+	//vertex, next and prev handles per halfedge
+	size_t bytes = (n_vertices() + n_faces() + n_halfedges() * 3) * sizeof(int);
+	for (const_prop_iterator it = vprops_begin(); it != vprops_end(); it++)
+		bytes += *it ? (*it)->size_of() : 0;
+	for (const_prop_iterator it = hprops_begin(); it != hprops_end(); it++)
+		bytes += *it ? (*it)->size_of() : 0;
+	for (const_prop_iterator it = eprops_begin(); it != eprops_end(); it++)
+		bytes += *it ? (*it)->size_of() : 0;
+	for (const_prop_iterator it = fprops_begin(); it != fprops_end(); it++)
+		bytes += *it ? (*it)->size_of() : 0;
+	return bytes;
+}
+
+void TriMesh::TrackMemory()
+{
+	ResourceTracker& tracker = ResourceTracker::Instance();
+	if (owner >= 0)
+		tracker.Free(ResourceTracker::HALF_EDGE_MESH, owner, trackedBytes);
+	trackedBytes = GetMemoryBytes();
+	owner = tracker.Allocate(ResourceTracker::HALF_EDGE_MESH, trackedBytes);
+}
+
+bool TriMesh::CanAddFace(VertexHandle a_, VertexHandle b_, VertexHandle c_) const
+{
+	VertexHandle v[3] = { a_, b_, c_ };
+	for (int i = 0; i < 3; i++) {
+		if (!is_boundary(v[i]))
+			return false;
+		HalfedgeHandle h = find_halfedge(v[i], v[(i + 1) % 3]);
+		if (h.is_valid() && !is_boundary(h))
+			return false;
+	}
+	return true;
+}
+
 bool TriMesh::Read(std::string filePath_)
 {
 	OpenMesh::IO::Options ropt;
@@ -16,6 +82,7 @@ bool TriMesh::Read(std::string filePath_)
 		update_normals();
 	}
 
+	TrackMemory();
 	return true;
 }
 
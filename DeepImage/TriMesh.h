@@ -14,7 +14,30 @@ struct HCCLTraits : public OpenMesh::DefaultTraits
 
 class TriMesh : public OpenMesh::TriMesh_ArrayKernelT<HCCLTraits>
 {
+private:
+	size_t trackedBytes;
+	//-1 until TrackMemory
+	int owner;
+
 public:
+	TriMesh();
+	TriMesh(const TriMesh& other_);
+	~TriMesh();
+	//copies the mesh only, each side keeps its own accounting
+	TriMesh& operator=(const TriMesh& other_);
+
+	//connectivity plus every property, which is far more than the render
+	//buffers made of it
+	size_t GetMemoryBytes() const;
+	//reports the current footprint to the ResourceTracker, Read does it
+	//itself, generated meshes call it once they are built
+	void TrackMemory();
+
+	//true when add_face takes the face without hitting a complex vertex
+	//or edge. add_face reports those on omerr, which all threads share,
+	//so bulk builders check first instead of muting it.
+	bool CanAddFace(VertexHandle a_, VertexHandle b_, VertexHandle c_) const;
+
 	bool Read(std::string filePath_);
 	bool Write(std::string filePath_);
 
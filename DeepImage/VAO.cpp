@@ -2,11 +2,16 @@
 
 #include <QOpenGLFunctions_4_5_Core>
 
+#include "ResourceTracker.h"
+
 VAO::VAO()
 {
 	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
 		versionFunctions<QOpenGLFunctions_4_5_Core>();
 	f->glGenVertexArrays(1, &id);
+
+	//no storage of its own, counted so leaks show up
+	owner = ResourceTracker::Instance().Allocate(ResourceTracker::VERTEX_ARRAY, 0);
 }
 
 VAO::~VAO()
@@ -14,9 +19,11 @@ VAO::~VAO()
 	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
 		versionFunctions<QOpenGLFunctions_4_5_Core>();
 	f->glDeleteVertexArrays(1, &id);
+
+	ResourceTracker::Instance().Free(ResourceTracker::VERTEX_ARRAY, owner, 0);
 }
 
-void VAO::AddBuffer(const VBO & vbo_, const VBOLayout & layout_)
+void VAO::AddBuffer(const VBO & vbo_, const VBOLayout & layout_, unsigned int firstIndex_)
 {
 	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
 		versionFunctions<QOpenGLFunctions_4_5_Core>();
@@ -27,9 +34,10 @@ void VAO::AddBuffer(const VBO & vbo_, const VBOLayout & layout_)
 	unsigned int offset = 0;
 	for (int i = 0; i < elements.size(); i++) {
 		const auto& element = elements[i];
-		f->glEnableVertexAttribArray(i);
-		f->glVertexAttribPointer(i, element.count, element.type,
+		f->glEnableVertexAttribArray(firstIndex_ + i);
+		f->glVertexAttribPointer(firstIndex_ + i, element.count, element.type,
 			element.normalized, layout_.GetStride(), (const void*)offset);
+		f->glVertexAttribDivisor(firstIndex_ + i, layout_.GetDivisor());
 		offset += element.count * VBElement::GetSizeOfType(element.type);
 	}
 }
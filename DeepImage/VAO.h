@@ -6,11 +6,13 @@
 class VAO {
 private:
 	unsigned int id;
+	int owner;
 public:
 	VAO();
 	~VAO();
 
-	void AddBuffer(const VBO& vbo_, const VBOLayout& layout_);
+	//the elements of layout_ go to the attributes from firstIndex_ on
+	void AddBuffer(const VBO& vbo_, const VBOLayout& layout_, unsigned int firstIndex_ = 0);
 
 	void Bind() const;
 	void Unbind() const;
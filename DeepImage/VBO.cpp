@@ -2,7 +2,10 @@
 
 #include <QOpenGLFunctions_4_5_Core>
 
+#include "ResourceTracker.h"
+
 VBO::VBO(const void * data_, unsigned int size_)
+	: size(size_)
 {
 	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
 		versionFunctions<QOpenGLFunctions_4_5_Core>();
@@ -10,6 +13,8 @@ VBO::VBO(const void * data_, unsigned int size_)
 	Bind();
 	f->glBufferData(GL_ARRAY_BUFFER, size_, data_, GL_STATIC_DRAW);
 	Unbind();
+
+	owner = ResourceTracker::Instance().Allocate(ResourceTracker::VERTEX_BUFFER, size);
 }
 
 VBO::~VBO()
@@ -17,6 +22,33 @@ VBO::~VBO()
 	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
 		versionFunctions<QOpenGLFunctions_4_5_Core>();
 	f->glDeleteBuffers(1, &id);
+
+	ResourceTracker::Instance().Free(ResourceTracker::VERTEX_BUFFER, owner, size);
+}
+
+void VBO::SetData(const void * data_, unsigned int size_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+	//respecifying the store lets the driver hand out fresh memory instead
+	//of waiting for draws that still read the old contents
+	Bind();
+	f->glBufferData(GL_ARRAY_BUFFER, size_, data_, GL_DYNAMIC_DRAW);
+	Unbind();
+
+	ResourceTracker& tracker = ResourceTracker::Instance();
+	tracker.Free(ResourceTracker::VERTEX_BUFFER, owner, size);
+	size = size_;
+	owner = tracker.Allocate(ResourceTracker::VERTEX_BUFFER, size);
+}
+
+void VBO::SetSubData(unsigned int offset_, const void * data_, unsigned int size_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+	Bind();
+	f->glBufferSubData(GL_ARRAY_BUFFER, offset_, size_, data_);
+	Unbind();
 }
 
 void VBO::Bind() const
@@ -3,11 +3,18 @@
 class VBO {
 private:
 	unsigned int id;
+	unsigned int size;
+	int owner;
 
 public:
 	VBO(const void* data_, unsigned int size_);
 	~VBO();
 
+	//replaces the whole contents, for buffers rewritten every frame
+	void SetData(const void* data_, unsigned int size_);
+	//rewrites [offset_, offset_ + size_) of the current store in place
+	void SetSubData(unsigned int offset_, const void* data_, unsigned int size_);
+
 	void Bind() const;
 	void Unbind() const;
 };
\ No newline at end of file
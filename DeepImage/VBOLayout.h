@@ -22,9 +22,13 @@ class VBOLayout {
 private:
 	std::vector<VBElement> elements;
 	unsigned int stride;
+	//0 advances per vertex, n per n instances
+	unsigned int divisor;
 
 public:
-	VBOLayout() : stride(0) {}
+	VBOLayout() : stride(0), divisor(0) {}
+
+	inline void SetDivisor(unsigned int divisor_) { divisor = divisor_; }
 
 	template<typename T>
 	void Push(unsigned int count_) {
@@ -51,4 +55,5 @@ public:
 
 	inline const std::vector<VBElement> GetElements() const { return elements; }
 	inline unsigned int GetStride() const { return stride; }
+	inline unsigned int GetDivisor() const { return divisor; }
 };
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include "DatasetGenerator.h"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QOpenGLFunctions_4_5_Core>
+
+#include "ThreadPool.h"
+
+static const float GOLDEN_ANGLE = 2.39996323f;
+static const float MIN_ELEVATION = 0.1f;
+static const float MAX_ELEVATION = 0.9f;
+//a float mask holds every integer id up to here exactly
+static const unsigned int MASK_PFM_MAX_ID = 1u << 24;
+//views whose readback may be in flight at once
+static const int READBACK_DEPTH = 3;
+
+DatasetGenerator::DatasetGenerator(HeadlessRenderer & renderer_, const QString & outputDir_)
+	: renderer(renderer_),
+	outputDir(outputDir_),
+	readback(0),
+	inFlight(0),
+	failed(false)
+{
+}
+
+DatasetGenerator::~DatasetGenerator()
+{
+	delete readback;
+}
+
+void DatasetGenerator::SampleCameras(int count_, QVector3D min_, QVector3D max_,
+	float fieldOfView_, std::vector<SceneCamera>& cameras_)
+{
+	QVector3D center = (min_ + max_) * 0.5f;
+	float radius = qMax((max_ - min_).length() * 0.5f, 1e-3f);
+	float distance = 1.1f * radius / sin(fieldOfView_ * 0.5f * (float)(M_PI / 180.0));
+
+	//fibonacci spiral over the band of the hemisphere, evenly spread for
+	//any count. the poles are left out, lookAt needs the up vector
+	for (int i = 0; i < count_; i++) {
+		float t = (i + 0.5f) / count_;
+		float z = MIN_ELEVATION + t * (MAX_ELEVATION - MIN_ELEVATION);
+		float r = sqrt(1.0f - z * z);
+		float phi = i * GOLDEN_ANGLE;
+
+		SceneCamera camera;
+		camera.name = QString("view_%1").arg(i, 5, 10, QChar('0')).toStdString();
+		camera.eye = center + distance * QVector3D(r * cos(phi), r * sin(phi), z);
+		camera.center = center;
+		camera.fieldOfView = fieldOfView_;
+		cameras_.push_back(camera);
+	}
+}
+
+bool DatasetGenerator::Run(const std::vector<SceneCamera>& cameras_, QVector3D background_)
+{
+	ThreadPool& pool = ThreadPool::Instance();
+	//bounds the memory held by views waiting for the encoder
+	int maxInFlight = 2 * pool.GetThreadCount() + 2;
+
+	if (!readback)
+		readback = new AsyncReadback(READBACK_DEPTH * GBuffer::ATTACHMENT_COUNT);
+
+	QElapsedTimer timer;
+	timer.start();
+	qint64 renderTime = 0;
+
+	for (int i = 0; i < cameras_.size() && !failed; i++) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [&]() { return inFlight < maxInFlight; });
+			inFlight++;
+		}
+
+		QElapsedTimer renderTimer;
+		renderTimer.start();
+
+		GBuffer& gbuffer = renderer.RenderGBuffer(cameras_[i], background_);
+
+		View* view = new View;
+		view->name = cameras_[i].name;
+		QueueReadback(gbuffer, view);
+		gbuffer.Unbind();
+
+		//hand over whatever finished while this view was drawn
+		readback->Poll();
+
+		renderTime += renderTimer.elapsed();
+	}
+
+	readback->Poll(true);
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		condition.wait(lock, [&]() { return inFlight == 0; });
+	}
+
+	double seconds = qMax<qint64>(timer.elapsed(), 1) / 1000.0;
+	std::cout << cameras_.size() << " views in " << seconds << " s ("
+		<< cameras_.size() / seconds << " views/s, "
+		<< renderTime / (double)qMax<size_t>(cameras_.size(), 1)
+		<< " ms render per view)" << std::endl;
+
+	return !failed;
+}
+
+void DatasetGenerator::QueueReadback(GBuffer & gbuffer_, View * view_)
+{
+	view_->width = gbuffer_.GetWidth();
+	view_->height = gbuffer_.GetHeight();
+	size_t pixelCount = (size_t)view_->width * view_->height;
+	view_->color.resize(pixelCount * 4);
+	view_->normalDepth.resize(pixelCount * 4);
+	view_->index.resize(pixelCount);
+
+	unsigned int id = gbuffer_.GetID();
+	readback->Read(id, GL_COLOR_ATTACHMENT0 + GBuffer::COLOR,
+		0, 0, view_->width, view_->height, GL_RGBA, GL_UNSIGNED_BYTE,
+		[view_](const void* data_, int width_, int height_) {
+		memcpy(view_->color.data(), data_, view_->color.size());
+	});
+	readback->Read(id, GL_COLOR_ATTACHMENT0 + GBuffer::NORMAL_DEPTH,
+		0, 0, view_->width, view_->height, GL_RGBA, GL_FLOAT,
+		[view_](const void* data_, int width_, int height_) {
+		memcpy(view_->normalDepth.data(), data_, view_->normalDepth.size() * sizeof(float));
+	});
+	//callbacks come in order, so the last channel completes the view
+	ThreadPool& pool = ThreadPool::Instance();
+	readback->Read(id, GL_COLOR_ATTACHMENT0 + GBuffer::INDEX,
+		0, 0, view_->width, view_->height, GL_RED_INTEGER, GL_UNSIGNED_INT,
+		[this, &pool, view_](const void* data_, int width_, int height_) {
+		memcpy(view_->index.data(), data_, view_->index.size() * sizeof(unsigned int));
+		pool.Submit([this, view_]() { Encode(view_); });
+	});
+}
+
+void DatasetGenerator::Encode(View * view_)
+{
+	bool ok = WriteColor(*view_) && WriteDepth(*view_) &&
+		WriteNormal(*view_) && WriteMask(*view_);
+	if (!ok)
+		failed = true;
+	delete view_;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		inFlight--;
+	}
+	condition.notify_all();
+}
+
+bool DatasetGenerator::WriteColor(const View & view_)
+{
+	QImage image(view_.color.data(), view_.width, view_.height,
+		QImage::Format_RGBA8888);
+	QString fileName = QDir(outputDir).filePath(
+		QString::fromStdString(view_.name + "_rgb.png"));
+
+	//GL rows start at the bottom, mirrored() also detaches from view_
+	if (!image.mirrored().convertToFormat(QImage::Format_RGB888).save(fileName)) {
+		std::cerr << "File Write Error: " << fileName.toStdString() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool DatasetGenerator::WriteDepth(const View & view_)
+{
+	//PFM stores rows bottom to top like GL, a negative scale marks little endian
+	size_t pixelCount = (size_t)view_.width * view_.height;
+	std::vector<float> depth(pixelCount);
+	for (size_t i = 0; i < pixelCount; i++)
+		depth[i] = view_.normalDepth[i * 4 + 3];
+
+	QByteArray header = QString("Pf\n%1 %2\n-1.0\n")
+		.arg(view_.width).arg(view_.height).toLatin1();
+	return WriteFile("_depth.pfm", view_, header,
+		(const char*)depth.data(), depth.size() * sizeof(float));
+}
+
+bool DatasetGenerator::WriteNormal(const View & view_)
+{
+	size_t pixelCount = (size_t)view_.width * view_.height;
+	std::vector<float> normal(pixelCount * 3);
+	for (size_t i = 0; i < pixelCount; i++)
+		for (int c = 0; c < 3; c++)
+			normal[i * 3 + c] = view_.normalDepth[i * 4 + c];
+
+	QByteArray header = QString("PF\n%1 %2\n-1.0\n")
+		.arg(view_.width).arg(view_.height).toLatin1();
+	return WriteFile("_normal.pfm", view_, header,
+		(const char*)normal.data(), normal.size() * sizeof(float));
+}
+
+bool DatasetGenerator::WriteMask(const View & view_)
+{
+	size_t pixelCount = (size_t)view_.width * view_.height;
+	const std::vector<unsigned int>& ids = view_.index;
+	unsigned int maxId = 0;
+	for (size_t i = 0; i < pixelCount; i++)
+		maxId = qMax(maxId, ids[i]);
+	if (maxId > MASK_PFM_MAX_ID) {
+		std::cerr << "Dataset Error: instance id " << maxId << " of " << view_.name
+			<< " does not fit the mask" << std::endl;
+		return false;
+	}
+
+	//ids past 16 bit go to a single channel PFM, its rows run bottom to
+	//top like the pixels read back
+	if (maxId > 65535u) {
+		std::vector<float> mask(pixelCount);
+		for (size_t i = 0; i < pixelCount; i++)
+			mask[i] = (float)ids[i];
+
+		QByteArray header = QString("Pf\n%1 %2\n-1.0\n")
+			.arg(view_.width).arg(view_.height).toLatin1();
+		return WriteFile("_mask.pfm", view_, header,
+			(const char*)mask.data(), mask.size() * sizeof(float));
+	}
+
+	//PGM rows run top to bottom and 16 bit samples are big endian
+	std::vector<unsigned char> mask(pixelCount * 2);
+	for (int y = 0; y < view_.height; y++) {
+		const unsigned int* src = &ids[(size_t)(view_.height - 1 - y) * view_.width];
+		unsigned char* dst = &mask[(size_t)y * view_.width * 2];
+		for (int x = 0; x < view_.width; x++) {
+			dst[x * 2] = (unsigned char)(src[x] >> 8);
+			dst[x * 2 + 1] = (unsigned char)(src[x] & 0xFF);
+		}
+	}
+
+	QByteArray header = QString("P5\n%1 %2\n65535\n")
+		.arg(view_.width).arg(view_.height).toLatin1();
+	return WriteFile("_mask.pgm", view_, header,
+		(const char*)mask.data(), mask.size());
+}
+
+bool DatasetGenerator::WriteFile(const std::string & suffix_, const View & view_,
+	const QByteArray & header_, const char * data_, size_t size_)
+{
+	QString fileName = QDir(outputDir).filePath(
+		QString::fromStdString(view_.name + suffix_));
+
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly) ||
+		file.write(header_) != header_.size() ||
+		file.write(data_, size_) != (qint64)size_) {
+		std::cerr << "File Write Error: " << fileName.toStdString() << std::endl;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <QString>
+
+#include "AsyncReadback.h"
+#include "HeadlessRenderer.h"
+
+//renders every channel of a view into the G-buffer and queues an
+//asynchronous readback. once the pixels arrive, a frame or two later,
+//they go to the thread pool for encoding. the GL thread renders the next
+//views meanwhile, so neither the readback nor compression stall the GPU.
+//per view it writes
+//	<name>_rgb.png		shaded color
+//	<name>_depth.pfm	linear view space depth, 0 on background
+//	<name>_normal.pfm	view space normal, 0 on background
+//	<name>_mask.pgm		16 bit instance id, model index + 1, 0 on background
+//	<name>_mask.pfm		the same as float, instead of the PGM for views
+//						that see ids above 65535
+class DatasetGenerator
+{
+private:
+	struct View {
+		std::string name;
+		int width, height;
+		std::vector<unsigned char> color;
+		std::vector<float> normalDepth;
+		std::vector<unsigned int> index;
+	};
+
+	HeadlessRenderer& renderer;
+	QString outputDir;
+	AsyncReadback* readback;
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	int inFlight;
+	std::atomic<bool> failed;
+
+public:
+	DatasetGenerator(HeadlessRenderer& renderer_, const QString& outputDir_);
+	~DatasetGenerator();
+
+	//count_ poses on the upper hemisphere around the scene bounds, all
+	//looking at the scene center
+	static void SampleCameras(int count_, QVector3D min_, QVector3D max_,
+		float fieldOfView_, std::vector<SceneCamera>& cameras_);
+
+	bool Run(const std::vector<SceneCamera>& cameras_, QVector3D background_);
+
+private:
+	void QueueReadback(GBuffer& gbuffer_, View* view_);
+	void Encode(View* view_);
+
+	bool WriteColor(const View& view_);
+	bool WriteDepth(const View& view_);
+	bool WriteNormal(const View& view_);
+	bool WriteMask(const View& view_);
+	bool WriteFile(const std::string& suffix_, const View& view_,
+		const QByteArray& header_, const char* data_, size_t size_);
+};
@@ -0,0 +1,99 @@
+#include "GBuffer.h"
+
+#include <QOpenGLFunctions_4_5_Core>
+
+#include "ResourceTracker.h"
+
+static const unsigned int INTERNAL_FORMATS[GBuffer::ATTACHMENT_COUNT] = {
+	GL_RGBA8, GL_RGBA32F, GL_R32UI
+};
+static const unsigned int FORMATS[GBuffer::ATTACHMENT_COUNT] = {
+	GL_RGBA, GL_RGBA, GL_RED_INTEGER
+};
+static const unsigned int TYPES[GBuffer::ATTACHMENT_COUNT] = {
+	GL_UNSIGNED_BYTE, GL_FLOAT, GL_UNSIGNED_INT
+};
+//RGBA8, RGBA32F and R32UI plus the DEPTH_COMPONENT24 attachment
+static const size_t BYTES_PER_PIXEL = 4 + 16 + 4 + 4;
+
+GBuffer::GBuffer(int width_, int height_)
+	: width(width_),
+	height(height_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	f->glGenFramebuffers(1, &id);
+	Bind();
+
+	unsigned int drawBuffers[ATTACHMENT_COUNT];
+	f->glGenTextures(ATTACHMENT_COUNT, textureIDs);
+	for (int i = 0; i < ATTACHMENT_COUNT; i++) {
+		f->glBindTexture(GL_TEXTURE_2D, textureIDs[i]);
+		f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		f->glTexImage2D(GL_TEXTURE_2D, 0, INTERNAL_FORMATS[i], width, height, 0,
+			FORMATS[i], TYPES[i], 0);
+		f->glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, textureIDs[i], 0);
+		drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+	}
+
+	f->glGenTextures(1, &depthID);
+	f->glBindTexture(GL_TEXTURE_2D, depthID);
+	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	f->glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0,
+		GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, 0);
+	f->glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthID, 0);
+	f->glBindTexture(GL_TEXTURE_2D, 0);
+
+	f->glDrawBuffers(ATTACHMENT_COUNT, drawBuffers);
+	Unbind();
+
+	owner = ResourceTracker::Instance().Allocate(ResourceTracker::FRAMEBUFFER,
+		(size_t)width * height * BYTES_PER_PIXEL);
+}
+
+GBuffer::~GBuffer()
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	f->glDeleteTextures(ATTACHMENT_COUNT, textureIDs);
+	f->glDeleteTextures(1, &depthID);
+	f->glDeleteFramebuffers(1, &id);
+
+	ResourceTracker::Instance().Free(ResourceTracker::FRAMEBUFFER, owner,
+		(size_t)width * height * BYTES_PER_PIXEL);
+}
+
+void GBuffer::Bind() const
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	f->glBindFramebuffer(GL_FRAMEBUFFER, id);
+}
+
+void GBuffer::Unbind() const
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	f->glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void GBuffer::Clear(float r_, float g_, float b_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	float background[4] = { r_, g_, b_, 1.0f };
+	float zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	unsigned int noID[4] = { 0, 0, 0, 0 };
+	float farDepth = 1.0f;
+	f->glClearBufferfv(GL_COLOR, COLOR, background);
+	f->glClearBufferfv(GL_COLOR, NORMAL_DEPTH, zero);
+	f->glClearBufferuiv(GL_COLOR, INDEX, noID);
+	f->glClearBufferfv(GL_DEPTH, 0, &farDepth);
+}
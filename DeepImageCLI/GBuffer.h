@@ -0,0 +1,32 @@
+#pragma once
+
+//framebuffer with one attachment per dataset channel, written in a
+//single pass by GBufferShader
+class GBuffer {
+public:
+	enum Attachment {
+		COLOR, NORMAL_DEPTH, INDEX, ATTACHMENT_COUNT
+	};
+
+private:
+	unsigned int id;
+	unsigned int textureIDs[ATTACHMENT_COUNT];
+	unsigned int depthID;
+
+	int width, height;
+	int owner;
+
+public:
+	GBuffer(int width_, int height_);
+	~GBuffer();
+
+	void Bind() const;
+	void Unbind() const;
+
+	//clears every attachment to zero and the depth to the far plane
+	void Clear(float r_, float g_, float b_);
+
+	inline unsigned int GetID() const { return id; }
+	inline int GetWidth() const { return width; }
+	inline int GetHeight() const { return height; }
+};
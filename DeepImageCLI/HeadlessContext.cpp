@@ -0,0 +1,304 @@
+#include "HeadlessContext.h"
+
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define HEADLESS_APIENTRY __stdcall
+#else
+#define HEADLESS_APIENTRY
+#endif
+
+//the few EGL and OSMesa tokens used here, so no headers are needed
+static const int EGL_NONE_ = 0x3038;
+static const int EGL_EXTENSIONS_ = 0x3055;
+static const int EGL_RENDERABLE_TYPE_ = 0x3040;
+static const int EGL_OPENGL_BIT_ = 0x0008;
+static const unsigned int EGL_OPENGL_API_ = 0x30A2;
+static const int EGL_CONTEXT_MAJOR_VERSION_ = 0x3098;
+static const int EGL_CONTEXT_MINOR_VERSION_ = 0x30FB;
+static const int EGL_CONTEXT_OPENGL_PROFILE_MASK_ = 0x30FD;
+static const int EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_ = 0x0001;
+static const unsigned int EGL_PLATFORM_DEVICE_EXT_ = 0x313F;
+static const unsigned int EGL_PLATFORM_SURFACELESS_MESA_ = 0x31DD;
+static const int MAX_DEVICES = 16;
+
+static const int OSMESA_FORMAT_ = 0x22;
+static const int OSMESA_DEPTH_BITS_ = 0x30;
+static const int OSMESA_PROFILE_ = 0x33;
+static const int OSMESA_CORE_PROFILE_ = 0x34;
+static const int OSMESA_CONTEXT_MAJOR_VERSION_ = 0x36;
+static const int OSMESA_CONTEXT_MINOR_VERSION_ = 0x37;
+static const int OSMESA_RGBA_ = 0x1908;
+static const unsigned int GL_UNSIGNED_BYTE_ = 0x1401;
+
+typedef void (HEADLESS_APIENTRY *EglProc)();
+typedef EglProc (HEADLESS_APIENTRY *PFN_eglGetProcAddress)(const char*);
+typedef const char* (HEADLESS_APIENTRY *PFN_eglQueryString)(void*, int);
+typedef unsigned int (HEADLESS_APIENTRY *PFN_eglInitialize)(void*, int*, int*);
+typedef unsigned int (HEADLESS_APIENTRY *PFN_eglTerminate)(void*);
+typedef unsigned int (HEADLESS_APIENTRY *PFN_eglBindAPI)(unsigned int);
+typedef unsigned int (HEADLESS_APIENTRY *PFN_eglChooseConfig)(void*, const int*, void**, int, int*);
+typedef void* (HEADLESS_APIENTRY *PFN_eglCreateContext)(void*, void*, void*, const int*);
+typedef unsigned int (HEADLESS_APIENTRY *PFN_eglDestroyContext)(void*, void*);
+typedef unsigned int (HEADLESS_APIENTRY *PFN_eglMakeCurrent)(void*, void*, void*, void*);
+typedef unsigned int (HEADLESS_APIENTRY *PFN_eglQueryDevicesEXT)(int, void**, int*);
+typedef void* (HEADLESS_APIENTRY *PFN_eglGetPlatformDisplayEXT)(unsigned int, void*, const int*);
+
+typedef void* (HEADLESS_APIENTRY *PFN_OSMesaCreateContextAttribs)(const int*, void*);
+typedef void (HEADLESS_APIENTRY *PFN_OSMesaDestroyContext)(void*);
+typedef unsigned char (HEADLESS_APIENTRY *PFN_OSMesaMakeCurrent)(void*, void*, unsigned int, int, int);
+typedef EglProc (HEADLESS_APIENTRY *PFN_OSMesaGetProcAddress)(const char*);
+
+static bool HasExtension(const char* extensions_, const char* name_)
+{
+	if (!extensions_)
+		return false;
+
+	size_t length = strlen(name_);
+	for (const char* p = strstr(extensions_, name_); p; p = strstr(p + length, name_)) {
+		if ((p == extensions_ || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0'))
+			return true;
+	}
+	return false;
+}
+
+HeadlessContext::HeadlessContext()
+	: backend(NONE),
+	display(0),
+	context(0)
+{
+#ifdef _WIN32
+	egl.setFileName("libEGL");
+	osmesa.setFileName("osmesa");
+#else
+	egl.setFileNameAndVersion("EGL", 1);
+	osmesa.setFileNameAndVersion("OSMesa", 8);
+#endif
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	if (backend == OSMESA) {
+		PFN_OSMesaDestroyContext destroyContext =
+			(PFN_OSMesaDestroyContext)osmesa.resolve("OSMesaDestroyContext");
+		destroyContext(context);
+	}
+	else if (backend != NONE) {
+		PFN_eglMakeCurrent makeCurrent = (PFN_eglMakeCurrent)egl.resolve("eglMakeCurrent");
+		PFN_eglDestroyContext destroyContext =
+			(PFN_eglDestroyContext)egl.resolve("eglDestroyContext");
+		PFN_eglTerminate terminate = (PFN_eglTerminate)egl.resolve("eglTerminate");
+		makeCurrent(display, 0, 0, 0);
+		destroyContext(display, context);
+		terminate(display);
+	}
+}
+
+bool HeadlessContext::Create(bool software_)
+{
+	if (CreateEGL(software_) || CreateOSMesa())
+		return true;
+
+	std::cerr << "Headless Error: neither EGL nor OSMesa can create an OpenGL 4.5 "
+		"core context" << std::endl;
+	return false;
+}
+
+bool HeadlessContext::CreateEGL(bool software_)
+{
+	if (!egl.load())
+		return false;
+
+	PFN_eglGetProcAddress getProcAddress =
+		(PFN_eglGetProcAddress)egl.resolve("eglGetProcAddress");
+	PFN_eglQueryString queryString = (PFN_eglQueryString)egl.resolve("eglQueryString");
+	if (!getProcAddress || !queryString)
+		return false;
+
+	//client extensions, the display is 0 here
+	const char* extensions = queryString(0, EGL_EXTENSIONS_);
+	PFN_eglGetPlatformDisplayEXT getPlatformDisplay =
+		(PFN_eglGetPlatformDisplayEXT)getProcAddress("eglGetPlatformDisplayEXT");
+	if (!getPlatformDisplay)
+		return false;
+
+	//every GPU first, the first that gives a 4.5 core context wins. Mesa
+	//lists llvmpipe as a device too, so software_ goes straight to the
+	//surfaceless platform, which LIBGL_ALWAYS_SOFTWARE turns to llvmpipe.
+	PFN_eglQueryDevicesEXT queryDevices =
+		(PFN_eglQueryDevicesEXT)getProcAddress("eglQueryDevicesEXT");
+	if (!software_ && queryDevices && HasExtension(extensions, "EGL_EXT_platform_device")) {
+		void* devices[MAX_DEVICES];
+		int deviceCount = 0;
+		if (queryDevices(MAX_DEVICES, devices, &deviceCount)) {
+			for (int i = 0; i < deviceCount; i++) {
+				if (CreateEGLContext(getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT_, devices[i], 0))) {
+					backend = EGL_DEVICE;
+					return true;
+				}
+			}
+		}
+	}
+
+	if (HasExtension(extensions, "EGL_MESA_platform_surfaceless") &&
+		CreateEGLContext(getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA_, 0, 0))) {
+		backend = EGL_SURFACELESS;
+		return true;
+	}
+
+	return false;
+}
+
+bool HeadlessContext::CreateEGLContext(void * display_)
+{
+	if (!display_)
+		return false;
+
+	PFN_eglInitialize initialize = (PFN_eglInitialize)egl.resolve("eglInitialize");
+	PFN_eglTerminate terminate = (PFN_eglTerminate)egl.resolve("eglTerminate");
+	PFN_eglQueryString queryString = (PFN_eglQueryString)egl.resolve("eglQueryString");
+	PFN_eglBindAPI bindAPI = (PFN_eglBindAPI)egl.resolve("eglBindAPI");
+	PFN_eglChooseConfig chooseConfig = (PFN_eglChooseConfig)egl.resolve("eglChooseConfig");
+	PFN_eglCreateContext createContext = (PFN_eglCreateContext)egl.resolve("eglCreateContext");
+	PFN_eglDestroyContext destroyContext =
+		(PFN_eglDestroyContext)egl.resolve("eglDestroyContext");
+	PFN_eglMakeCurrent makeCurrent = (PFN_eglMakeCurrent)egl.resolve("eglMakeCurrent");
+	if (!initialize || !terminate || !queryString || !bindAPI || !chooseConfig ||
+		!createContext || !destroyContext || !makeCurrent)
+		return false;
+
+	int major, minor;
+	if (!initialize(display_, &major, &minor))
+		return false;
+
+	//no surface ever, the renderer only draws into FBOs
+	if (!HasExtension(queryString(display_, EGL_EXTENSIONS_), "EGL_KHR_surfaceless_context") ||
+		!bindAPI(EGL_OPENGL_API_)) {
+		terminate(display_);
+		return false;
+	}
+
+	const int configAttribs[] = {
+		EGL_RENDERABLE_TYPE_, EGL_OPENGL_BIT_,
+		EGL_NONE_
+	};
+	void* config = 0;
+	int configCount = 0;
+	if (!chooseConfig(display_, configAttribs, &config, 1, &configCount) || configCount == 0) {
+		terminate(display_);
+		return false;
+	}
+
+	const int contextAttribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION_, 4,
+		EGL_CONTEXT_MINOR_VERSION_, 5,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK_, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_,
+		EGL_NONE_
+	};
+	void* eglContext = createContext(display_, config, 0, contextAttribs);
+	if (!eglContext) {
+		terminate(display_);
+		return false;
+	}
+	if (!makeCurrent(display_, 0, 0, eglContext)) {
+		destroyContext(display_, eglContext);
+		terminate(display_);
+		return false;
+	}
+
+	display = display_;
+	context = eglContext;
+	return true;
+}
+
+bool HeadlessContext::CreateOSMesa()
+{
+	if (!osmesa.load())
+		return false;
+
+	PFN_OSMesaCreateContextAttribs createContext =
+		(PFN_OSMesaCreateContextAttribs)osmesa.resolve("OSMesaCreateContextAttribs");
+	if (!createContext)
+		return false;
+
+	const int attribs[] = {
+		OSMESA_FORMAT_, OSMESA_RGBA_,
+		OSMESA_DEPTH_BITS_, 24,
+		OSMESA_PROFILE_, OSMESA_CORE_PROFILE_,
+		OSMESA_CONTEXT_MAJOR_VERSION_, 4,
+		OSMESA_CONTEXT_MINOR_VERSION_, 5,
+		0
+	};
+	context = createContext(attribs, 0);
+	if (!context)
+		return false;
+
+	backend = OSMESA;
+	if (!MakeCurrent()) {
+		PFN_OSMesaDestroyContext destroyContext =
+			(PFN_OSMesaDestroyContext)osmesa.resolve("OSMesaDestroyContext");
+		destroyContext(context);
+		context = 0;
+		backend = NONE;
+		return false;
+	}
+	return true;
+}
+
+bool HeadlessContext::MakeCurrent()
+{
+	if (backend == OSMESA) {
+		PFN_OSMesaMakeCurrent makeCurrent =
+			(PFN_OSMesaMakeCurrent)osmesa.resolve("OSMesaMakeCurrent");
+		return makeCurrent(context, osmesaPixel, GL_UNSIGNED_BYTE_, 1, 1) != 0;
+	}
+	if (backend == NONE)
+		return false;
+
+	PFN_eglMakeCurrent makeCurrent = (PFN_eglMakeCurrent)egl.resolve("eglMakeCurrent");
+	return makeCurrent(display, 0, 0, context) != 0;
+}
+
+void HeadlessContext::DoneCurrent()
+{
+	//OSMesa has no way to release a context, the next MakeCurrent
+	//replaces it
+	if (backend == OSMESA || backend == NONE)
+		return;
+
+	PFN_eglMakeCurrent makeCurrent = (PFN_eglMakeCurrent)egl.resolve("eglMakeCurrent");
+	makeCurrent(display, 0, 0, 0);
+}
+
+HeadlessContext::Proc HeadlessContext::GetProcAddress(const char * name_)
+{
+	if (backend == OSMESA) {
+		PFN_OSMesaGetProcAddress getProcAddress =
+			(PFN_OSMesaGetProcAddress)osmesa.resolve("OSMesaGetProcAddress");
+		return (Proc)getProcAddress(name_);
+	}
+	if (backend == NONE)
+		return 0;
+
+	//EGL 1.5 and EGL_KHR_get_all_proc_addresses resolve the core entry
+	//points too
+	PFN_eglGetProcAddress getProcAddress =
+		(PFN_eglGetProcAddress)egl.resolve("eglGetProcAddress");
+	return (Proc)getProcAddress(name_);
+}
+
+const char * HeadlessContext::GetBackendName() const
+{
+	switch (backend)
+	{
+	case EGL_DEVICE:
+		return "EGL device";
+	case EGL_SURFACELESS:
+		return "EGL surfaceless";
+	case OSMESA:
+		return "OSMesa";
+	default:
+		return "none";
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QLibrary>
+
+//OpenGL 4.5 core context that needs no window system and no display:
+//EGL on a GPU device (EGL_EXT_platform_device), EGL on Mesa's surfaceless
+//platform (EGL_MESA_platform_surfaceless), or OSMesa where there is no
+//EGL, as on Windows. EGL contexts are made current without a surface
+//(EGL_KHR_surfaceless_context), so everything is drawn into FBOs.
+//the libraries are resolved at runtime, nothing links against them.
+class HeadlessContext
+{
+public:
+	enum Backend {
+		NONE, EGL_DEVICE, EGL_SURFACELESS, OSMESA
+	};
+
+private:
+	typedef void (*Proc)();
+
+	QLibrary egl;
+	QLibrary osmesa;
+	Backend backend;
+
+	void* display;
+	void* context;
+	//OSMesa always renders into client memory, one pixel is enough
+	unsigned char osmesaPixel[4];
+
+public:
+	HeadlessContext();
+	~HeadlessContext();
+
+	//software_ skips GPU devices, Mesa picks llvmpipe then
+	bool Create(bool software_);
+
+	bool MakeCurrent();
+	void DoneCurrent();
+	Proc GetProcAddress(const char* name_);
+
+	inline Backend GetBackend() const { return backend; }
+	const char* GetBackendName() const;
+
+private:
+	bool CreateEGL(bool software_);
+	bool CreateEGLContext(void* display_);
+	bool CreateOSMesa();
+};
@@ -0,0 +1,121 @@
+#include "HeadlessPlatform.h"
+
+#include <QCoreApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <qpa/qwindowsysteminterface.h>
+
+#include <iostream>
+
+QPlatformIntegration* HeadlessPlatformPlugin::create(const QString& system_, const QStringList& paramList_)
+{
+	if (system_.compare("headless", Qt::CaseInsensitive) != 0)
+		return 0;
+
+	return new HeadlessIntegration(paramList_.contains("software"));
+}
+
+HeadlessSurface::HeadlessSurface(QOffscreenSurface* surface_)
+	: QPlatformOffscreenSurface(surface_)
+{
+}
+
+QSurfaceFormat HeadlessSurface::format() const
+{
+	return offscreenSurface()->requestedFormat();
+}
+
+HeadlessGLContext::HeadlessGLContext(const QSurfaceFormat& format_, bool software_)
+	: surfaceFormat(format_)
+{
+	valid = context.Create(software_);
+
+	//HeadlessContext always asks for 4.5 core, the renderer needs nothing else
+	surfaceFormat.setRenderableType(QSurfaceFormat::OpenGL);
+	surfaceFormat.setProfile(QSurfaceFormat::CoreProfile);
+	surfaceFormat.setVersion(4, 5);
+
+	if (valid)
+		qInfo("Headless context: %s", context.GetBackendName());
+}
+
+bool HeadlessGLContext::makeCurrent(QPlatformSurface* surface_)
+{
+	return valid && context.MakeCurrent();
+}
+
+void HeadlessGLContext::doneCurrent()
+{
+	if (valid)
+		context.DoneCurrent();
+}
+
+QFunctionPointer HeadlessGLContext::getProcAddress(const char* procName_)
+{
+	if (!valid)
+		return 0;
+
+	return (QFunctionPointer)context.GetProcAddress(procName_);
+}
+
+bool HeadlessEventDispatcher::processEvents(QEventLoop::ProcessEventsFlags flags_)
+{
+	emit awake();
+	QCoreApplication::sendPostedEvents();
+	return QWindowSystemInterface::sendWindowSystemEvents(flags_);
+}
+
+HeadlessIntegration::HeadlessIntegration(bool software_)
+	: screen(0), software(software_)
+{
+}
+
+HeadlessIntegration::~HeadlessIntegration()
+{
+	if (screen) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+		QWindowSystemInterface::handleScreenRemoved(screen);
+#else
+		destroyScreen(screen);
+#endif
+	}
+}
+
+void HeadlessIntegration::initialize()
+{
+	screen = new HeadlessScreen;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+	QWindowSystemInterface::handleScreenAdded(screen);
+#else
+	screenAdded(screen);
+#endif
+}
+
+bool HeadlessIntegration::hasCapability(Capability capability_) const
+{
+	switch (capability_) {
+	case OpenGL:
+		return true;
+	default:
+		return false;
+	}
+}
+
+QPlatformOpenGLContext* HeadlessIntegration::createPlatformOpenGLContext(QOpenGLContext* context_) const
+{
+	HeadlessGLContext* context = new HeadlessGLContext(context_->format(), software);
+	if (!context->isValid())
+		std::cerr << "Headless Error: no EGL device, no surfaceless EGL and no OSMesa available" << std::endl;
+	return context;
+}
+
+QPlatformOffscreenSurface* HeadlessIntegration::createPlatformOffscreenSurface(
+	QOffscreenSurface* surface_) const
+{
+	return new HeadlessSurface(surface_);
+}
+
+QAbstractEventDispatcher* HeadlessIntegration::createEventDispatcher() const
+{
+	return new HeadlessEventDispatcher;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <QAbstractEventDispatcher>
+#include <qpa/qplatformintegration.h>
+#include <qpa/qplatformintegrationplugin.h>
+#include <qpa/qplatformoffscreensurface.h>
+#include <qpa/qplatformopenglcontext.h>
+#include <qpa/qplatformscreen.h>
+
+#include "HeadlessContext.h"
+
+//Qt platform plugin "headless" for the CLI. Qt's own offscreen plugin
+//only gets OpenGL through GLX, so it needs an X display on Linux and has
+//none at all on Windows. this one hands every QOpenGLContext a
+//HeadlessContext, so QOffscreenSurface, QOpenGLContext and the
+//QOpenGLFunctions the renderer is built on work without any window
+//system. windows and backing stores are not supported. select it with
+//QT_QPA_PLATFORM=headless, "headless:software" prefers llvmpipe.
+class HeadlessPlatformPlugin : public QPlatformIntegrationPlugin
+{
+	Q_OBJECT
+	Q_PLUGIN_METADATA(IID QPlatformIntegrationFactoryInterface_iid FILE "HeadlessPlatform.json")
+
+public:
+	virtual QPlatformIntegration* create(const QString& system_, const QStringList& paramList_);
+};
+
+class HeadlessScreen : public QPlatformScreen
+{
+public:
+	virtual QRect geometry() const { return QRect(0, 0, 1, 1); }
+	virtual int depth() const { return 32; }
+	virtual QImage::Format format() const { return QImage::Format_ARGB32_Premultiplied; }
+};
+
+class HeadlessSurface : public QPlatformOffscreenSurface
+{
+public:
+	HeadlessSurface(QOffscreenSurface* surface_);
+
+	virtual QSurfaceFormat format() const;
+	virtual bool isValid() const { return true; }
+};
+
+class HeadlessGLContext : public QPlatformOpenGLContext
+{
+private:
+	HeadlessContext context;
+	QSurfaceFormat surfaceFormat;
+	bool valid;
+
+public:
+	HeadlessGLContext(const QSurfaceFormat& format_, bool software_);
+
+	virtual QSurfaceFormat format() const { return surfaceFormat; }
+	virtual bool isValid() const { return valid; }
+
+	virtual void swapBuffers(QPlatformSurface* surface_) {}
+	virtual bool makeCurrent(QPlatformSurface* surface_);
+	virtual void doneCurrent();
+	virtual QFunctionPointer getProcAddress(const char* procName_);
+};
+
+//there is no event loop in the CLI, posted and window system events are
+//delivered whenever Qt asks for them, timers and sockets are not
+//supported
+class HeadlessEventDispatcher : public QAbstractEventDispatcher
+{
+public:
+	virtual bool processEvents(QEventLoop::ProcessEventsFlags flags_);
+	virtual bool hasPendingEvents() { return false; }
+
+	virtual void registerSocketNotifier(QSocketNotifier* notifier_) {}
+	virtual void unregisterSocketNotifier(QSocketNotifier* notifier_) {}
+
+	virtual void registerTimer(int timerId_, int interval_, Qt::TimerType timerType_,
+		QObject* object_) {}
+	virtual bool unregisterTimer(int timerId_) { return false; }
+	virtual bool unregisterTimers(QObject* object_) { return false; }
+	virtual QList<TimerInfo> registeredTimers(QObject* object_) const {
+		return QList<TimerInfo>();
+	}
+	virtual int remainingTime(int timerId_) { return -1; }
+
+#ifdef Q_OS_WIN
+	virtual bool registerEventNotifier(QWinEventNotifier* notifier_) { return false; }
+	virtual void unregisterEventNotifier(QWinEventNotifier* notifier_) {}
+#endif
+
+	virtual void wakeUp() {}
+	virtual void interrupt() {}
+	virtual void flush() {}
+};
+
+class HeadlessIntegration : public QPlatformIntegration
+{
+private:
+	HeadlessScreen* screen;
+	bool software;
+
+public:
+	HeadlessIntegration(bool software_);
+	~HeadlessIntegration();
+
+	virtual void initialize();
+	virtual bool hasCapability(Capability capability_) const;
+
+	virtual QPlatformWindow* createPlatformWindow(QWindow* window_) const { return 0; }
+	virtual QPlatformBackingStore* createPlatformBackingStore(QWindow* window_) const { return 0; }
+	virtual QPlatformOpenGLContext* createPlatformOpenGLContext(QOpenGLContext* context_) const;
+	virtual QPlatformOffscreenSurface* createPlatformOffscreenSurface(
+		QOffscreenSurface* surface_) const;
+	virtual QAbstractEventDispatcher* createEventDispatcher() const;
+};
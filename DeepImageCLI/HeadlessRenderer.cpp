@@ -0,0 +1,243 @@
+#include "HeadlessRenderer.h"
+
+#include <cfloat>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <QOpenGLFunctions_4_5_Core>
+
+#include "MeshRepair.h"
+
+HeadlessRenderer::HeadlessRenderer()
+	: surface(0),
+	context(0),
+	phong(0),
+	phongTess(0),
+	gbufferShader(0),
+	fbo(0),
+	gbuffer(0),
+	width(0),
+	height(0),
+	tessellationPixels(0.0f)
+{
+}
+
+HeadlessRenderer::~HeadlessRenderer()
+{
+	if (context && context->makeCurrent(surface)) {
+		std::vector<Model3D*>& meshes = modelManager.GetMeshes();
+		for (int i = 0; i < meshes.size(); i++)
+			delete meshes[i];
+		delete phong;
+		delete phongTess;
+		delete gbufferShader;
+		delete fbo;
+		delete gbuffer;
+		context->doneCurrent();
+	}
+
+	delete context;
+	delete surface;
+}
+
+bool HeadlessRenderer::Init(int width_, int height_)
+{
+	width = width_;
+	height = height_;
+
+	QSurfaceFormat format;
+	format.setVersion(4, 5);
+	format.setProfile(QSurfaceFormat::CoreProfile);
+	format.setRenderableType(QSurfaceFormat::OpenGL);
+	format.setDepthBufferSize(24);
+
+	surface = new QOffscreenSurface;
+	surface->setFormat(format);
+	surface->create();
+	if (!surface->isValid()) {
+		std::cerr << "Headless Error: cannot create an offscreen surface" << std::endl;
+		return false;
+	}
+
+	context = new QOpenGLContext;
+	context->setFormat(format);
+	if (!context->create() || !context->makeCurrent(surface)) {
+		std::cerr << "Headless Error: cannot create an OpenGL context" << std::endl;
+		return false;
+	}
+
+	QOpenGLFunctions_4_5_Core *f = context->versionFunctions<QOpenGLFunctions_4_5_Core>();
+	if (!f || !f->initializeOpenGLFunctions()) {
+		std::cerr << "Headless Error: OpenGL 4.5 core is not available" << std::endl;
+		return false;
+	}
+
+	//diagnostics go to the message handler, stdout is kept for results
+	qInfo("Renderer: %s, %s", (const char*)f->glGetString(GL_RENDERER),
+		(const char*)f->glGetString(GL_VERSION));
+
+	phong = new PhongShader;
+	phongTess = new PhongTessShader;
+	gbufferShader = new GBufferShader;
+	shaderManager.Add(phong);
+	shaderManager.Add(phongTess);
+	shaderManager.Add(gbufferShader);
+	shaderManager.SetErrorCallback(
+		[](const std::string& name_, const std::string& log_) {
+		std::cerr << "Shader " << name_ << " failed:\n" << log_ << std::endl;
+	});
+	//there is no frame loop to hide the compile in, just wait for it. the
+	//driver compiles on threads of its own, so this one sleeps between polls
+	shaderManager.SubmitAll();
+	while (!shaderManager.Poll())
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	if (!phong->IsReady() || !gbufferShader->IsReady())
+		return false;
+
+	fbo = new FBO(width, height);
+
+	f->glEnable(GL_DEPTH_TEST);
+	return true;
+}
+
+bool HeadlessRenderer::LoadScene(const SceneDescription & scene_)
+{
+	const std::vector<SceneModel>& sceneModels = scene_.GetModels();
+	int loadedCount = 0;
+	for (int i = 0; i < sceneModels.size(); i++) {
+		const SceneModel& sceneModel = sceneModels[i];
+
+		//a model that cannot be read is left out, the rest still renders
+		Model3D* model = new Model3D;
+		if (!model->Load(sceneModel.path)) {
+			std::cerr << "Scene Error: skipping " << sceneModel.path << std::endl;
+			delete model;
+			continue;
+		}
+		model->Init();
+		loadedCount++;
+
+		QVector3D t = sceneModel.translation;
+		QVector3D r = sceneModel.rotation * (float)(M_PI / 180.0);
+		qglviewer::Quaternion q =
+			qglviewer::Quaternion(qglviewer::Vec(0, 0, 1), r[2]) *
+			qglviewer::Quaternion(qglviewer::Vec(0, 1, 0), r[1]) *
+			qglviewer::Quaternion(qglviewer::Vec(1, 0, 0), r[0]);
+		SceneStore& scene = modelManager.GetScene();
+		int idx = scene.GetIndex(modelManager.AddModel(model));
+		scene.SetTransform(idx, qglviewer::Vec(t[0], t[1], t[2]), q);
+	}
+
+	//nothing is on screen yet, so wait for the repairs and render the
+	//repaired meshes from the first image on
+	MeshRepair& repair = MeshRepair::Instance();
+	repair.Wait();
+	std::vector<MeshRepairResult*> results;
+	repair.Collect(results);
+	for (int i = 0; i < results.size(); i++) {
+		modelManager.ApplyRepair(*results[i]);
+		qInfo("Repaired %s: %s", results[i]->name.c_str(),
+			DescribeMeshRepair(results[i]->report).c_str());
+		delete results[i];
+	}
+
+	return loadedCount > 0;
+}
+
+void HeadlessRenderer::ViewProjection(const SceneCamera & camera_,
+	QMatrix4x4 & view_, QMatrix4x4 & proj_)
+{
+	view_.setToIdentity();
+	view_.lookAt(camera_.eye, camera_.center, QVector3D(0, 0, 1));
+
+	//fit the clipping planes around every model, like QGLViewer does
+	//around its scene radius
+	float zNear = FLT_MAX, zFar = 0.0f;
+	const SceneStore& scene = modelManager.GetScene();
+	for (int i = 0; i < scene.GetCount(); i++) {
+		QVector3D bmin = scene.GetWorldMin(i);
+		QVector3D bmax = scene.GetWorldMax(i);
+		QVector3D center = view_.map((bmin + bmax) * 0.5f);
+		float radius = ((bmax - bmin) * 0.5f).length();
+		zNear = qMin(zNear, -center.z() - radius);
+		zFar = qMax(zFar, -center.z() + radius);
+	}
+	zFar = qMax(zFar, 1.0f);
+	zNear = qMax(zNear, zFar * 0.001f);
+
+	proj_.setToIdentity();
+	proj_.perspective(camera_.fieldOfView, width / (float)height, zNear, zFar);
+}
+
+void HeadlessRenderer::Draw(const SceneCamera & camera_, QVector3D background_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	QMatrix4x4 view, proj;
+	ViewProjection(camera_, view, proj);
+
+	fbo->Bind();
+	f->glViewport(0, 0, width, height);
+	f->glClearColor(background_[0], background_[1], background_[2], 1.0f);
+	f->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	drawList.Prepare(modelManager, view, proj, height);
+	PhongTessShader* tessellated = 0;
+	if (tessellationPixels > 0.0f && phongTess->IsReady()) {
+		tessellated = phongTess;
+		tessellated->SetTessellation(width, height, tessellationPixels);
+	}
+	drawList.Submit(*phong, tessellated);
+}
+
+QImage HeadlessRenderer::Render(const SceneCamera & camera_, QVector3D background_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	Draw(camera_, background_);
+
+	QImage image(width, height, QImage::Format_RGBA8888);
+	f->glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	f->glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, image.bits());
+	fbo->Unbind();
+
+	//GL rows start at the bottom
+	return image.mirrored();
+}
+
+GBuffer & HeadlessRenderer::RenderGBuffer(const SceneCamera & camera_, QVector3D background_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	if (!gbuffer)
+		gbuffer = new GBuffer(width, height);
+
+	QMatrix4x4 view, proj;
+	ViewProjection(camera_, view, proj);
+
+	gbuffer->Bind();
+	f->glViewport(0, 0, width, height);
+	gbuffer->Clear(background_[0], background_[1], background_[2]);
+
+	drawList.Prepare(modelManager, view, proj, height);
+	drawList.SubmitGBuffer(*gbufferShader);
+
+	return *gbuffer;
+}
+
+void HeadlessRenderer::GetSceneBounds(QVector3D & min_, QVector3D & max_)
+{
+	min_ = QVector3D(FLT_MAX, FLT_MAX, FLT_MAX);
+	max_ = QVector3D(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+	const SceneStore& scene = modelManager.GetScene();
+	for (int i = 0; i < scene.GetCount(); i++) {
+		for (int k = 0; k < 3; k++) {
+			min_[k] = qMin(min_[k], scene.GetWorldMin(i)[k]);
+			max_[k] = qMax(max_[k], scene.GetWorldMax(i)[k]);
+		}
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QImage>
+#include <QMatrix4x4>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+
+#include "DrawList.h"
+#include "FBO.h"
+#include "GBuffer.h"
+#include "ModelManager.h"
+#include "ShaderManager.h"
+#include "ShaderProgram.h"
+#include "SceneDescription.h"
+
+//renders the same passes as Screen into an FBO owned by an offscreen
+//context, so no window, widget or display connection is needed.
+//the context comes from the headless platform plugin: EGL on a GPU
+//device, Mesa's surfaceless EGL (llvmpipe without a GPU) or OSMesa.
+class HeadlessRenderer
+{
+private:
+	QOffscreenSurface* surface;
+	QOpenGLContext* context;
+
+	PhongShader* phong;
+	PhongTessShader* phongTess;
+	GBufferShader* gbufferShader;
+	ShaderManager shaderManager;
+
+	FBO* fbo;
+	GBuffer* gbuffer;
+	int width, height;
+	//target edge length of the Phong tessellation, 0 draws plain meshes
+	float tessellationPixels;
+
+	ModelManager modelManager;
+	DrawList drawList;
+
+public:
+	HeadlessRenderer();
+	~HeadlessRenderer();
+
+	//creates the context and waits for the shaders, false if the
+	//platform cannot provide an OpenGL 4.5 core context
+	bool Init(int width_, int height_);
+
+	//models whose file cannot be read are skipped, false when none loaded
+	bool LoadScene(const SceneDescription& scene_);
+
+	//shades the scene into the FBO and leaves it bound, no readback
+	void Draw(const SceneCamera& camera_, QVector3D background_);
+	QImage Render(const SceneCamera& camera_, QVector3D background_);
+	//draws every dataset channel into the G-buffer and leaves it bound,
+	//reading it back is up to the caller
+	GBuffer& RenderGBuffer(const SceneCamera& camera_, QVector3D background_);
+
+	void GetSceneBounds(QVector3D& min_, QVector3D& max_);
+
+	//false when the driver did not link the tessellation program
+	inline bool CanTessellate() const { return phongTess->IsReady(); }
+	inline void SetTessellation(float edgePixels_) { tessellationPixels = edgePixels_; }
+
+	inline int GetWidth() const { return width; }
+	inline int GetHeight() const { return height; }
+	inline ModelManager& GetModelManager() { return modelManager; }
+
+private:
+	void ViewProjection(const SceneCamera& camera_, QMatrix4x4& view_,
+		QMatrix4x4& proj_);
+};
@@ -0,0 +1,76 @@
+#include "SceneDescription.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+SceneDescription::SceneDescription()
+	: width(1024),
+	height(768),
+	background(0.7f, 0.7f, 0.7f)
+{
+}
+
+bool SceneDescription::Read(const std::string & filePath_)
+{
+	std::ifstream stream(filePath_);
+	if (!stream) {
+		std::cerr << "File Open Error: cannot read scene " << filePath_ << std::endl;
+		return false;
+	}
+
+	std::string line;
+	int lineNumber = 0;
+	while (getline(stream, line)) {
+		lineNumber++;
+		line = line.substr(0, line.find('#'));
+
+		std::istringstream tokens(line);
+		std::string key;
+		if (!(tokens >> key))
+			continue;
+
+		bool ok = true;
+		if (key == "size") {
+			ok = (bool)(tokens >> width >> height) && width > 0 && height > 0;
+		}
+		else if (key == "background") {
+			float r, g, b;
+			ok = (bool)(tokens >> r >> g >> b);
+			background = QVector3D(r, g, b);
+		}
+		else if (key == "model") {
+			SceneModel model;
+			ok = (bool)(tokens >> model.path);
+			float v[6] = { 0, 0, 0, 0, 0, 0 };
+			int count = 0;
+			while (count < 6 && tokens >> v[count])
+				count++;
+			ok = ok && (count == 0 || count == 3 || count == 6);
+			model.translation = QVector3D(v[0], v[1], v[2]);
+			model.rotation = QVector3D(v[3], v[4], v[5]);
+			models.push_back(model);
+		}
+		else if (key == "camera") {
+			SceneCamera camera;
+			float e[3], c[3];
+			ok = (bool)(tokens >> camera.name >> e[0] >> e[1] >> e[2] >> c[0] >> c[1] >> c[2]);
+			camera.eye = QVector3D(e[0], e[1], e[2]);
+			camera.center = QVector3D(c[0], c[1], c[2]);
+			if (!(tokens >> camera.fieldOfView))
+				camera.fieldOfView = 45.0f;
+			cameras.push_back(camera);
+		}
+		else {
+			ok = false;
+		}
+
+		if (!ok) {
+			std::cerr << filePath_ << ":" << lineNumber
+				<< ": cannot parse '" << line << "'" << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <QVector3D>
+
+//plain text scene for the command line renderer. one entry per line,
+//'#' starts a comment:
+//	size <width> <height>
+//	background <r> <g> <b>
+//	model <path> [<tx> <ty> <tz> [<rx> <ry> <rz>]]	(euler angles in degrees)
+//	camera <name> <ex> <ey> <ez> <cx> <cy> <cz> [<fov>]	(eye, center, z up)
+struct SceneModel {
+	std::string path;
+	QVector3D translation;
+	QVector3D rotation;
+};
+
+struct SceneCamera {
+	std::string name;
+	QVector3D eye;
+	QVector3D center;
+	float fieldOfView;
+};
+
+class SceneDescription
+{
+private:
+	int width, height;
+	QVector3D background;
+
+	std::vector<SceneModel> models;
+	std::vector<SceneCamera> cameras;
+
+public:
+	SceneDescription();
+
+	bool Read(const std::string& filePath_);
+
+	inline int GetWidth() const { return width; }
+	inline int GetHeight() const { return height; }
+	inline QVector3D GetBackground() const { return background; }
+
+	inline const std::vector<SceneModel>& GetModels() const { return models; }
+	inline std::vector<SceneCamera>& GetCameras() { return cameras; }
+};
@@ -0,0 +1,155 @@
+#include "SubdivisionBenchmark.h"
+
+#include <iostream>
+#include <QElapsedTimer>
+#include <QOpenGLFunctions_4_5_Core>
+#include <OpenMesh/Tools/Subdivider/Uniform/LoopT.hh>
+
+#include "MeshCache.h"
+#include "TriMesh.h"
+
+SubdivisionBenchmark::SubdivisionBenchmark(HeadlessRenderer & renderer_, int frameCount_)
+	: renderer(renderer_),
+	frameCount(frameCount_)
+{
+}
+
+bool SubdivisionBenchmark::Run(const SceneCamera & camera_, QVector3D background_,
+	int levels_, float edgePixels_)
+{
+	ModelManager& modelManager = renderer.GetModelManager();
+	std::vector<Model3D*>& meshes = modelManager.GetMeshes();
+
+	Result plain = Result();
+	plain.name = "plain";
+	renderer.SetTessellation(0.0f);
+	Measure(camera_, background_, plain);
+	Report(plain);
+
+	if (renderer.CanTessellate()) {
+		Result phong = Result();
+		phong.name = "phong tessellation " + std::to_string((int)edgePixels_) + " px";
+		renderer.SetTessellation(edgePixels_);
+		Measure(camera_, background_, phong);
+		renderer.SetTessellation(0.0f);
+		Report(phong);
+	}
+	else
+		std::cerr << "Benchmark Error: the tessellation program is not available" << std::endl;
+
+	//one mesh at a time, so the peak is the largest half-edge mesh
+	Result loop = Result();
+	loop.name = "loop x" + std::to_string(levels_);
+	QElapsedTimer timer;
+	for (int i = 0; i < meshes.size(); i++) {
+		Model3D* mesh = meshes[i];
+		if (!mesh)
+			continue;
+
+		std::vector<float> vertices;
+		std::vector<unsigned int> indices;
+		if (mesh->HasCpuCopy()) {
+			vertices = mesh->GetVertices();
+			indices = mesh->GetIndices();
+		}
+		else if (!MeshCache::Instance().Load(mesh->GetCacheKey(), vertices, indices)) {
+			std::cerr << "Benchmark Error: no buffers for mesh " << i << std::endl;
+			return false;
+		}
+
+		timer.start();
+		size_t halfEdgeBytes;
+		LoopSubdivide(vertices, indices, levels_, halfEdgeBytes);
+		loop.buildTime += timer.nsecsElapsed() / 1.0e6;
+		loop.halfEdgeBytes = qMax(loop.halfEdgeBytes, halfEdgeBytes);
+
+		modelManager.ReplaceMesh(i, vertices, indices);
+	}
+	Measure(camera_, background_, loop);
+	Report(loop);
+
+	return true;
+}
+
+void SubdivisionBenchmark::Measure(const SceneCamera & camera_, QVector3D background_,
+	Result & result_)
+{
+	QOpenGLFunctions_4_5_Core *f = QOpenGLContext::currentContext()->
+		versionFunctions<QOpenGLFunctions_4_5_Core>();
+
+	std::vector<Model3D*>& meshes = renderer.GetModelManager().GetMeshes();
+	for (int i = 0; i < meshes.size(); i++) {
+		if (!meshes[i])
+			continue;
+		result_.gpuBytes += meshes[i]->GetGpuBytes();
+		result_.cpuBytes += meshes[i]->GetCpuBytes();
+	}
+
+	//the first frame pays for uploads and state, it is not counted
+	renderer.Draw(camera_, background_);
+	f->glFinish();
+
+	unsigned int queries[2];
+	f->glGenQueries(2, queries);
+	QElapsedTimer timer;
+	timer.start();
+	f->glBeginQuery(GL_TIME_ELAPSED, queries[0]);
+	f->glBeginQuery(GL_PRIMITIVES_GENERATED, queries[1]);
+	for (int i = 0; i < frameCount; i++)
+		renderer.Draw(camera_, background_);
+	f->glEndQuery(GL_PRIMITIVES_GENERATED);
+	f->glEndQuery(GL_TIME_ELAPSED);
+	f->glFinish();
+	result_.wallTime = timer.nsecsElapsed() / 1.0e6 / frameCount;
+
+	GLuint64 elapsed, primitives;
+	f->glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &elapsed);
+	f->glGetQueryObjectui64v(queries[1], GL_QUERY_RESULT, &primitives);
+	f->glDeleteQueries(2, queries);
+	result_.gpuTime = elapsed / 1.0e6 / frameCount;
+	result_.triangles = primitives / frameCount;
+}
+
+void SubdivisionBenchmark::Report(const Result & result_)
+{
+	std::cout << result_.name << ": " << result_.gpuTime << " ms GPU, "
+		<< result_.wallTime << " ms wall per frame, "
+		<< result_.triangles << " triangles, buffers "
+		<< (result_.gpuBytes >> 10) << " KB GPU "
+		<< (result_.cpuBytes >> 10) << " KB CPU";
+	if (result_.halfEdgeBytes)
+		std::cout << ", half-edge mesh " << (result_.halfEdgeBytes >> 10)
+			<< " KB, subdivided in " << result_.buildTime << " ms";
+	std::cout << std::endl;
+}
+
+void SubdivisionBenchmark::LoopSubdivide(std::vector<float>& vertices_,
+	std::vector<unsigned int>& indices_, int levels_, size_t& halfEdgeBytes_)
+{
+	int stride = Model3D::VERTEX_STRIDE;
+	TriMesh mesh;
+	std::vector<TriMesh::VertexHandle> handles(vertices_.size() / stride);
+	for (int i = 0; i < handles.size(); i++) {
+		const float* p = vertices_.data() + (size_t)i * stride;
+		handles[i] = mesh.add_vertex(TriMesh::Point(p[0], p[1], p[2]));
+	}
+
+	//the repair left manifold meshes, whatever add_face would still
+	//refuse cannot be subdivided anyway
+	for (size_t i = 0; i + 2 < indices_.size(); i += 3) {
+		TriMesh::VertexHandle a = handles[indices_[i]];
+		TriMesh::VertexHandle b = handles[indices_[i + 1]];
+		TriMesh::VertexHandle c = handles[indices_[i + 2]];
+		if (mesh.CanAddFace(a, b, c))
+			mesh.add_face(a, b, c);
+	}
+
+	OpenMesh::Subdivider::Uniform::LoopT<TriMesh> loop;
+	loop.attach(mesh);
+	loop(levels_);
+	loop.detach();
+
+	halfEdgeBytes_ = mesh.GetMemoryBytes();
+	mesh.GetVertices(vertices_, true, false);
+	mesh.GetIndices(indices_);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <QVector3D>
+
+#include "HeadlessRenderer.h"
+
+//compares three ways to show a smoother surface from the first camera:
+//	plain		the meshes as loaded
+//	phong		Phong tessellation on the GPU, refined to a target edge
+//				length on screen. the refined triangles only live in the
+//				pipeline, the buffers are those of the plain meshes
+//	loop		Loop subdivision on the CPU with OpenMesh, every level
+//				quadruples the buffers and the half-edge mesh is needed
+//				to build them
+//per variant it reports GPU and wall time per frame, the triangles that
+//reached the rasterizer and the memory the geometry takes.
+class SubdivisionBenchmark
+{
+private:
+	struct Result {
+		std::string name;
+		double gpuTime;
+		double wallTime;
+		unsigned long long triangles;
+		size_t gpuBytes;
+		size_t cpuBytes;
+		//CPU Loop only, peak of the half-edge meshes and subdivision time
+		size_t halfEdgeBytes;
+		double buildTime;
+	};
+
+	HeadlessRenderer& renderer;
+	int frameCount;
+
+public:
+	SubdivisionBenchmark(HeadlessRenderer& renderer_, int frameCount_ = 50);
+
+	//the loop variant replaces the scene meshes by their subdivision, so
+	//this is the last thing done with the renderer
+	bool Run(const SceneCamera& camera_, QVector3D background_,
+		int levels_, float edgePixels_);
+
+private:
+	void Measure(const SceneCamera& camera_, QVector3D background_, Result& result_);
+	void Report(const Result& result_);
+
+	//levels_ rounds of Loop subdivision of position and normal buffers,
+	//halfEdgeBytes_ is the size of the half-edge mesh when done
+	static void LoopSubdivide(std::vector<float>& vertices_,
+		std::vector<unsigned int>& indices_, int levels_, size_t& halfEdgeBytes_);
+};
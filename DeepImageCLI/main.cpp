@@ -0,0 +1,137 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <QDir>
+#include <QGuiApplication>
+#include <QtPlugin>
+
+#include "DatasetGenerator.h"
+#include "HeadlessRenderer.h"
+#include "ResourceTracker.h"
+#include "SceneDescription.h"
+#include "SubdivisionBenchmark.h"
+
+Q_IMPORT_PLUGIN(HeadlessPlatformPlugin)
+
+//target edge length of the tessellation the benchmark compares against
+static const float BENCHMARK_EDGE_PIXELS = 8.0f;
+
+static void PrintUsage()
+{
+	std::cout << "usage: DeepImageCLI [--software] [--views <n>] [--subdivision <levels>]\n"
+		"                   [--resources <file>] <scene file> <output directory>\n"
+		"  --software          use the software rasterizer (Mesa llvmpipe)\n"
+		"  --views <n>         write a dataset (rgb, depth, normal, mask) for n sampled\n"
+		"                      poses instead of images for the scene cameras\n"
+		"  --subdivision <n>   compare frame time and memory of the plain meshes, GPU\n"
+		"                      Phong tessellation and n levels of CPU Loop subdivision\n"
+		"                      from the first scene camera instead of writing images\n"
+		"  --resources <file>  write the memory accounting as JSON when done"
+		<< std::endl;
+}
+
+static void DumpResources(const std::string& filePath_)
+{
+	if (filePath_.empty())
+		return;
+
+	std::ofstream file(filePath_);
+	if (!file) {
+		std::cerr << "File Write Error: " << filePath_ << std::endl;
+		return;
+	}
+	file << ResourceTracker::Instance().Dump();
+}
+
+int main(int argc, char *argv[])
+{
+	bool software = false;
+	int viewCount = 0;
+	int subdivisionLevels = 0;
+	std::string resourcesPath;
+	std::vector<std::string> args;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--software")
+			software = true;
+		else if (arg == "--views" && i + 1 < argc)
+			viewCount = atoi(argv[++i]);
+		else if (arg == "--subdivision" && i + 1 < argc)
+			subdivisionLevels = atoi(argv[++i]);
+		else if (arg == "--resources" && i + 1 < argc)
+			resourcesPath = argv[++i];
+		else
+			args.push_back(arg);
+	}
+	if (args.size() != 2) {
+		PrintUsage();
+		return 1;
+	}
+
+	//the headless platform plugin (HeadlessPlatform.h) creates the GL
+	//context on EGL without a display or on OSMesa, no X server or window
+	//is needed. both settings must precede the application.
+	if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+		qputenv("QT_QPA_PLATFORM", software ? "headless:software" : "headless");
+	if (software)
+		qputenv("LIBGL_ALWAYS_SOFTWARE", "1");
+	QGuiApplication a(argc, argv);
+
+	SceneDescription scene;
+	if (!scene.Read(args[0]))
+		return 1;
+	if (viewCount <= 0 && scene.GetCameras().empty()) {
+		std::cerr << "Scene Error: no camera in " << args[0] << std::endl;
+		return 1;
+	}
+
+	QDir outputDir(QString::fromStdString(args[1]));
+	if (!outputDir.mkpath(".")) {
+		std::cerr << "File Open Error: cannot create " << args[1] << std::endl;
+		return 1;
+	}
+
+	HeadlessRenderer renderer;
+	if (!renderer.Init(scene.GetWidth(), scene.GetHeight()))
+		return 1;
+	if (!renderer.LoadScene(scene)) {
+		std::cerr << "Scene Error: no model could be loaded from " << args[0] << std::endl;
+		return 1;
+	}
+
+	if (viewCount > 0) {
+		QVector3D sceneMin, sceneMax;
+		renderer.GetSceneBounds(sceneMin, sceneMax);
+		std::vector<SceneCamera> cameras;
+		DatasetGenerator::SampleCameras(viewCount, sceneMin, sceneMax, 45.0f, cameras);
+
+		DatasetGenerator generator(renderer, outputDir.absolutePath());
+		bool ok = generator.Run(cameras, scene.GetBackground());
+		DumpResources(resourcesPath);
+		return ok ? 0 : 1;
+	}
+
+	std::vector<SceneCamera>& cameras = scene.GetCameras();
+	if (subdivisionLevels > 0) {
+		SubdivisionBenchmark benchmark(renderer);
+		bool ok = benchmark.Run(cameras[0], scene.GetBackground(),
+			subdivisionLevels, BENCHMARK_EDGE_PIXELS);
+		DumpResources(resourcesPath);
+		return ok ? 0 : 1;
+	}
+
+	for (int i = 0; i < cameras.size(); i++) {
+		QImage image = renderer.Render(cameras[i], scene.GetBackground());
+		QString fileName = outputDir.filePath(
+			QString::fromStdString(cameras[i].name) + ".png");
+		if (!image.save(fileName)) {
+			std::cerr << "File Write Error: " << fileName.toStdString() << std::endl;
+			return 1;
+		}
+		std::cout << "Wrote " << fileName.toStdString() << std::endl;
+	}
+
+	DumpResources(resourcesPath);
+	return 0;
+}